@@ -57,18 +57,6 @@ package body textio is
         end if;
     end procedure;
 
-    procedure shrink (l : inout line; size : in natural) is
-        variable tmp : line;
-    begin
-        assert l /= null;
-        if size < l'length then
-            tmp := new string(1 to size);
-            tmp.all := l.all(1 to size);
-            deallocate(l);
-            l := tmp;
-        end if;
-    end procedure;
-
     procedure consume (l : inout line; nchars : in natural) is
         variable tmp : line;
     begin
@@ -614,39 +602,31 @@ package body textio is
         assert good report "hread failed" severity read_severity;
     end procedure;
 
-    -- Allocator will round up to 128
-    constant LINE_BUFFER_SIZE : positive := 127;
+    impure function read_line_length (file f : text) return natural is
+    begin
+        return 0;                       -- Has a foreign implementation
+    end function;
+
+    attribute foreign of read_line_length : function is
+        "INTERNAL _std_textio_line_length";
+
+    procedure read_line_data (file f : text; value : out string) is
+    begin
+    end procedure;
+
+    attribute foreign of read_line_data : procedure is
+        "INTERNAL _std_textio_line_data";
 
     procedure readline (file f: text; l: inout line) is
-        variable tmp  : line;
-        variable ch   : string(1 to 1);
-        variable used : natural;
-        variable got  : integer;
     begin
         if l /= null then
             deallocate(l);
         end if;
 
-        tmp := new string(1 to LINE_BUFFER_SIZE);
-        loop
-            read(f, ch, got);
-            exit when got /= 1;
-
-            next when ch(1) = CR;
-
-            if ch(1) = LF then
-                exit;
-            else
-                if used = tmp'length then
-                    grow(tmp, LINE_BUFFER_SIZE, used);
-                end if;
-                used := used + 1;
-                tmp(used) := ch(1);
-            end if;
-        end loop;
-
-        shrink(tmp, used);
-        l := tmp;
+        -- The whole line is read into a buffer in the runtime first so
+        -- the result can be allocated with the exact size
+        l := new string(1 to read_line_length(f));
+        read_line_data(f, l.all);
     end procedure;
 
     procedure writeline (file f : text; l : inout line) is
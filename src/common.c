@@ -1162,6 +1162,7 @@ void intern_strings(void)
       [W_IEEE_ULOGIC_VECTOR]     = "IEEE.STD_LOGIC_1164.STD_ULOGIC_VECTOR",
       [W_IEEE_1164_RISING_EDGE]  = "IEEE.STD_LOGIC_1164.RISING_EDGE(sU)B",
       [W_IEEE_1164_FALLING_EDGE] = "IEEE.STD_LOGIC_1164.FALLING_EDGE(sU)B",
+      [W_IEEE_1164_RESOLVED]     = "IEEE.STD_LOGIC_1164.RESOLVED(Y)U",
 
       [W_NUMERIC_STD_UNSIGNED] = "IEEE.NUMERIC_STD_UNSIGNED",
       [W_NUMERIC_BIT_UNSIGNED] = "IEEE.NUMERIC_BIT_UNSIGNED",
@@ -2602,6 +2603,11 @@ void capture_syntax(text_buf_t *tb)
 void analyse_file(const char *file, jit_t *jit, unit_registry_t *ur,
                   mir_context_t *mc)
 {
+   if (opt_get_int(OPT_INCREMENTAL) && lib_source_unchanged(lib_work(), file)) {
+      progress("skipped unchanged file %s", file);
+      return;
+   }
+
    input_from_file(file);
 
    switch (source_kind()) {
@@ -2625,11 +2631,10 @@ void analyse_file(const char *file, jit_t *jit, unit_registry_t *ur,
 
    case SOURCE_VERILOG:
       {
+         // Preprocessed text is generated in chunks as the parser
+         // consumes it rather than all at once
          LOCAL_TEXT_BUF tb = tb_new();
-         vlog_preprocess(tb, true);
-
-         file_ref_t file_ref = loc_file_ref(file, NULL);
-         input_from_buffer(tb_get(tb), tb_len(tb), file_ref, SOURCE_VERILOG);
+         vlog_preprocess_stream(tb, true);
 
          lib_t work = lib_work();
          vlog_node_t module;
@@ -289,6 +289,7 @@ typedef enum {
    W_OP_MATCH_GREATER_EQUAL,
    W_IEEE_1164_RISING_EDGE,
    W_IEEE_1164_FALLING_EDGE,
+   W_IEEE_1164_RESOLVED,
    W_TEXT_UTIL,
    W_VERILOG_NET_VALUE,
    W_VERILOG_LOGIC,
@@ -230,6 +230,8 @@ bool cover_enabled(cover_data_t *data, cover_mask_t mask);
 void cover_write(cover_data_t *db, fbuf_t *f, cover_dump_t dt);
 cover_data_t *cover_read(fbuf_t *f, uint32_t pre_mask);
 void cover_merge(cover_data_t *dst, const cover_data_t *src, merge_mode_t mode);
+cover_data_t *cover_read_merge(fbuf_t **files, int count, uint32_t pre_mask,
+                               merge_mode_t mode);
 
 int32_t *cover_get_counters(cover_data_t *db, ident_t name);
 cover_scope_t *cover_get_scope(cover_data_t *db, ident_t name);
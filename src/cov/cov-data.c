@@ -30,6 +30,7 @@
 #include "printf.h"
 #include "tree.h"
 #include "psl/psl-node.h"
+#include "thread.h"
 #include "type.h"
 
 #include <assert.h>
@@ -65,6 +66,22 @@ static const struct {
 #define COVER_FILE_MAGIC   0x6e636462   // ASCII "ncdb"
 #define COVER_FILE_VERSION 6
 
+// Accumulate the structure of the scope tree but not the counter values
+#define FINGERPRINT(db, x) \
+   ((db)->fingerprint = mix_bits_64((db)->fingerprint ^ (uint64_t)(x)))
+
+typedef struct {
+   fbuf_t       *fbuf;
+   uint32_t      pre_mask;
+   cover_data_t *db;
+} cover_read_task_t;
+
+typedef struct {
+   cover_data_t       *dst;
+   const cover_data_t *src;
+   merge_mode_t        mode;
+} cover_merge_task_t;
+
 static inline unsigned get_next_tag(cover_block_t *b)
 {
    if (b == NULL)
@@ -1008,6 +1025,9 @@ static cover_item_t *cover_read_item(cover_data_t *db, fbuf_t *f,
    const cover_item_kind_t kind = fbuf_get_uint(f);
    const cover_src_t src = fbuf_get_uint(f);
 
+   FINGERPRINT(db, consecutive);
+   FINGERPRINT(db, kind);
+
    for (int i = 0; i < consecutive; i++) {
       item[i].consecutive = consecutive - i;
       item[i].kind        = kind;
@@ -1041,6 +1061,10 @@ static cover_item_t *cover_read_item(cover_data_t *db, fbuf_t *f,
          item[i].func_name = ident_read(ident_ctx);
       else if (item[i].kind == COV_ITEM_TOGGLE)
          item[i].field_idx = fbuf_get_uint(f);
+
+      FINGERPRINT(db, item[i].tag);
+      FINGERPRINT(db, item[i].flags);
+      FINGERPRINT(db, item[i].hier);
    }
 
    return item;
@@ -1062,6 +1086,9 @@ static cover_scope_t *cover_read_scope(cover_data_t *db, fbuf_t *f,
 
    loc_read(&s->loc, loc_ctx);
 
+   FINGERPRINT(db, s->name);
+   FINGERPRINT(db, s->kind);
+
    const int nitems = fbuf_get_uint(f);
    for (int i = 0; i < nitems; i++) {
       cover_item_t *item = cover_read_item(db, f, loc_ctx, ident_ctx);
@@ -1070,6 +1097,8 @@ static cover_scope_t *cover_read_scope(cover_data_t *db, fbuf_t *f,
 
    for (;;) {
       const uint8_t ctrl = read_u8(f);
+      FINGERPRINT(db, ctrl);
+
       switch (ctrl) {
       case CTRL_PUSH_UNIT:
          {
@@ -1240,14 +1269,150 @@ static void cover_merge_scope(cover_data_t *db, cover_scope_t *dst_s,
    }
 }
 
+static bool cover_same_shape(const cover_scope_t *dst_s,
+                             const cover_scope_t *src_s)
+{
+   if (dst_s->name != src_s->name)
+      return false;
+   else if (dst_s->items.count != src_s->items.count)
+      return false;
+   else if (dst_s->children.count != src_s->children.count)
+      return false;
+
+   for (int i = 0; i < src_s->items.count; i++) {
+      const cover_item_t *dst = dst_s->items.items[i];
+      const cover_item_t *src = src_s->items.items[i];
+
+      if (dst->kind != src->kind || dst->consecutive != src->consecutive)
+         return false;
+
+      for (int j = 0; j < src->consecutive; j++) {
+         if (dst[j].flags != src[j].flags || dst[j].hier != src[j].hier)
+            return false;
+      }
+   }
+
+   return true;
+}
+
+static void cover_merge_identical(cover_data_t *db, cover_scope_t *dst_s,
+                                  const cover_scope_t *src_s,
+                                  merge_mode_t mode)
+{
+   // Fast path for databases with the same scope tree where items and
+   // children can be matched by position alone
+
+   if (!cover_same_shape(dst_s, src_s)) {
+      // Fingerprints are only a hash so fall back to matching by name
+      cover_merge_scope(db, dst_s, src_s, mode);
+      db->fingerprint = 0;
+      return;
+   }
+
+   for (int i = 0; i < src_s->items.count; i++) {
+      cover_item_t *dst = dst_s->items.items[i];
+      const cover_item_t *src = src_s->items.items[i];
+
+      for (int j = 0; j < src->consecutive; j++)
+         cover_merge_one_item(dst + j, src[j].data);
+   }
+
+   for (int i = 0; i < src_s->children.count; i++)
+      cover_merge_identical(db, dst_s->children.items[i],
+                            src_s->children.items[i], mode);
+}
+
+static void cover_merge_data(cover_data_t *dst, const cover_data_t *src,
+                             merge_mode_t mode)
+{
+   if (dst->fingerprint != 0 && dst->fingerprint == src->fingerprint)
+      cover_merge_identical(dst, dst->root_scope, src->root_scope, mode);
+   else {
+      cover_merge_scope(dst, dst->root_scope, src->root_scope, mode);
+      dst->fingerprint = 0;   // Scope tree may have changed
+   }
+}
+
 void cover_merge(cover_data_t *dst, const cover_data_t *src, merge_mode_t mode)
 {
-   cover_merge_scope(dst, dst->root_scope, src->root_scope, mode);
+   cover_merge_data(dst, src, mode);
 
    if (opt_get_int(OPT_COVER_VERBOSE))
       cover_debug_dump(dst->root_scope, 0);
 }
 
+static void cover_read_task(void *context, void *arg)
+{
+   // Safe to run concurrently: each database has its own pool and
+   // read contexts, the ident table is lock-free, and loc_read takes
+   // the diagnostic lock when it registers a new file
+   cover_read_task_t *t = arg;
+   t->db = cover_read(t->fbuf, t->pre_mask);
+}
+
+static void cover_merge_task(void *context, void *arg)
+{
+   cover_merge_task_t *t = arg;
+   cover_merge_data(t->dst, t->src, t->mode);
+}
+
+cover_data_t *cover_read_merge(fbuf_t **files, int count, uint32_t pre_mask,
+                               merge_mode_t mode)
+{
+   assert(count > 0);
+
+   workq_t *wq = workq_new(NULL);
+
+   cover_read_task_t *reads = xcalloc_array(count, sizeof(cover_read_task_t));
+   for (int i = 0; i < count; i++) {
+      reads[i].fbuf = files[i];
+      reads[i].pre_mask = pre_mask;
+      workq_do(wq, cover_read_task, &(reads[i]));
+   }
+
+   workq_start(wq);
+   workq_drain(wq);
+
+   cover_merge_task_t *merges =
+      xcalloc_array(count / 2 + 1, sizeof(cover_merge_task_t));
+
+   if (mode == MERGE_UNION) {
+      // Reduce pairs of databases in a binary tree so the merges at
+      // each level can run in parallel: the left operand is always the
+      // earlier input so the scope order matches a sequential merge
+      for (int stride = 1; stride < count; stride *= 2) {
+         int nmerges = 0;
+         for (int i = 0; i + stride < count; i += 2 * stride) {
+            cover_merge_task_t *t = &(merges[nmerges++]);
+            t->dst  = reads[i].db;
+            t->src  = reads[i + stride].db;
+            t->mode = mode;
+            workq_do(wq, cover_merge_task, t);
+         }
+
+         workq_start(wq);
+         workq_drain(wq);
+      }
+   }
+   else {
+      // The intersection is defined by the scope tree of the first
+      // input so every other database must be merged into that
+      for (int i = 1; i < count; i++)
+         cover_merge_data(reads[0].db, reads[i].db, mode);
+   }
+
+   cover_data_t *result = reads[0].db;
+
+   free(merges);
+   free(reads);
+   workq_free(wq);
+
+   if (opt_get_int(OPT_COVER_VERBOSE))
+      cover_debug_dump(result->root_scope, 0);
+
+   return result;
+}
+
 int32_t *cover_get_counters(cover_data_t *db, ident_t name)
 {
    if (db == NULL)
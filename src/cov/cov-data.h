@@ -60,6 +60,7 @@ struct _cover_data {
    cover_scope_t   *root_scope;
    hash_t          *blocks;
    mem_pool_t      *pool;
+   uint64_t         fingerprint;
 };
 
 typedef struct {
@@ -371,24 +371,27 @@ void loc_read(loc_t *loc, loc_rd_ctx_t *ctx)
          fatal("corrupt location file reference %x", old_ref);
 
       if (ctx->ref_map[old_ref] == FILE_INVALID) {
+         // Coverage databases may be read concurrently
+         SCOPED_LOCK(diag_lock);
+
          for (unsigned i = 0; i < loc_files.count; i++) {
             if (strcmp(loc_files.items[i].name_str,
                        ctx->file_map[old_ref]) == 0)
                ctx->ref_map[old_ref] = loc_files.items[i].ref;
          }
-      }
 
-      if (ctx->ref_map[old_ref] == FILE_INVALID) {
-         loc_file_t new = {
-            .linebuf  = NULL,
-            .name_str = ctx->file_map[old_ref],
-            .ref      = loc_files.count
-         };
+         if (ctx->ref_map[old_ref] == FILE_INVALID) {
+            loc_file_t new = {
+               .linebuf  = NULL,
+               .name_str = ctx->file_map[old_ref],
+               .ref      = loc_files.count
+            };
 
-         APUSH(loc_files, new);
+            APUSH(loc_files, new);
 
-         ctx->ref_map[old_ref]  = new.ref;
-         ctx->file_map[old_ref] = NULL;   // Owned by loc_file_t now
+            ctx->ref_map[old_ref]  = new.ref;
+            ctx->file_map[old_ref] = NULL;   // Owned by loc_file_t now
+         }
       }
 
       new_ref = ctx->ref_map[old_ref];
@@ -76,6 +76,8 @@ struct _fbuf {
    uint8_t     *rbuf;
    size_t       rptr;
    size_t       origsz;
+   uint8_t     *rmap;
+   size_t       rmapsz;
    fbuf_t      *next;
    fbuf_t      *prev;
    cs_state_t   checksum;
@@ -305,10 +307,14 @@ static void fbuf_update_header(fbuf_t *f, uint32_t checksum)
    if (len == -1)
       fatal_errno("%s: ftell", f->fname);
 
-   if (fseek(f->file, 8, SEEK_SET) != 0)
+   if (fseek(f->file, 4, SEEK_SET) != 0)
       fatal_errno("%s: fseek", f->fname);
 
-   const uint8_t bytes[12] = {
+   const uint8_t bytes[16] = {
+      f->zip,
+      f->checksum.algo,
+      FBUF_HEADER_SZ,
+      0,
       PACK_BE32(f->wtotal),
       PACK_BE32(checksum),
       PACK_BE32(len),
@@ -403,19 +409,30 @@ static void fbuf_decompress(fbuf_t *f)
 
    f->origsz = len;
    f->checksum.expect = checksum;
-   f->rbuf = xmalloc(f->origsz);
 
    uint8_t *payload = rmap + header_sz + userheader;
    const size_t payloadsz = filesz - header_sz - userheader;
 
+   if (header[4] == FBUF_ZIP_NONE) {
+      if (payloadsz < f->origsz)
+         fatal("%s has inconsistent length %zu vs payload size %zu",
+               f->fname, f->origsz, payloadsz);
+
+      // Read uncompressed data directly from the mapping rather than
+      // copying it into a separate buffer: the checksum is computed
+      // over the mapped payload when the file is closed
+      f->rbuf   = payload;
+      f->rmap   = rmap;
+      f->rmapsz = filesz;
+      return;
+   }
+
+   f->rbuf = xmalloc(f->origsz);
+
    switch (header[4]) {
    case FBUF_ZIP_FASTLZ:
       fbuf_decompress_fastlz(f, payload, payloadsz);
       break;
-   case FBUF_ZIP_NONE:
-      memcpy(f->rbuf, payload, f->origsz);
-      checksum_update(&(f->checksum), f->rbuf, f->origsz);
-      break;
    case FBUF_ZIP_ZSTD:
       fbuf_decompress_zstd(f, payload, payloadsz);
       break;
@@ -442,19 +459,6 @@ fbuf_t *fbuf_open(const char *file, fbuf_mode_t mode, fbuf_cs_t csum)
 
    checksum_init(&(f->checksum), csum);
 
-   if (f->zip == FBUF_ZIP_ZSTD && mode == FBUF_OUT) {
-      if ((f->zstd = ZSTD_createCCtx()) == NULL)
-         fatal_trace("ZSTD_createCCtx() failed");
-
-      size_t rc = ZSTD_CCtx_setParameter(f->zstd, ZSTD_c_compressionLevel, 3);
-      if (ZSTD_isError(rc))
-         fatal("failed to set ZSTD compression level: %s",
-               ZSTD_getErrorName(rc));
-
-      f->zbufsz = ZSTD_CStreamOutSize();
-      f->zbuf = xmalloc(f->zbufsz);
-   }
-
    if (mode == FBUF_OUT) {
       f->wbuf = xmalloc(SPILL_SIZE);
       fbuf_write_header(f);
@@ -468,6 +472,14 @@ fbuf_t *fbuf_open(const char *file, fbuf_mode_t mode, fbuf_cs_t csum)
    return (open_list = f);
 }
 
+void fbuf_set_zip(fbuf_t *f, fbuf_zip_t zip)
+{
+   assert(f->mode == FBUF_OUT);
+   assert(f->wtotal == 0);   // Must be called before first flush
+
+   f->zip = zip;
+}
+
 const char *fbuf_file_name(fbuf_t *f)
 {
    return f->fname;
@@ -493,6 +505,19 @@ static void fbuf_compress_fastlz(fbuf_t *f)
 
 static void fbuf_compress_zstd(fbuf_t *f, bool end)
 {
+   if (f->zstd == NULL) {
+      if ((f->zstd = ZSTD_createCCtx()) == NULL)
+         fatal_trace("ZSTD_createCCtx() failed");
+
+      size_t rc = ZSTD_CCtx_setParameter(f->zstd, ZSTD_c_compressionLevel, 3);
+      if (ZSTD_isError(rc))
+         fatal("failed to set ZSTD compression level: %s",
+               ZSTD_getErrorName(rc));
+
+      f->zbufsz = ZSTD_CStreamOutSize();
+      f->zbuf = xmalloc(f->zbufsz);
+   }
+
    ZSTD_EndDirective mode = end ? ZSTD_e_end : ZSTD_e_continue;
    ZSTD_inBuffer input = { f->wbuf, f->wpend, 0 };
    bool finished;
@@ -542,11 +567,34 @@ static void fbuf_maybe_flush(fbuf_t *f, size_t more, bool end)
    }
 }
 
+bool fbuf_read_checksum(const char *file, fbuf_cs_t csum, uint32_t *checksum)
+{
+   // Read the checksum from the header without decompressing the file
+   FILE *h = fopen(file, "rb");
+   if (h == NULL)
+      return false;
+
+   uint8_t header[16];
+   const bool valid = fread(header, sizeof(header), 1, h) == 1
+      && memcmp(header, "FBUF", 4) == 0
+      && header[5] == csum;
+
+   fclose(h);
+
+   if (valid)
+      *checksum = UNPACK_BE32(header + 12);
+
+   return valid;
+}
+
 void fbuf_close(fbuf_t *f, uint32_t *checksum)
 {
    if (f->wbuf != NULL)
       fbuf_maybe_flush(f, BLOCK_SIZE, true);
 
+   if (f->rmap != NULL)
+      checksum_update(&(f->checksum), f->rbuf, f->origsz);
+
    const uint32_t cs = checksum_finish(&(f->checksum));
 
    if (f->mode == FBUF_IN && cs != f->checksum.expect)
@@ -556,7 +604,9 @@ void fbuf_close(fbuf_t *f, uint32_t *checksum)
    if (checksum != NULL)
       *checksum = cs;
 
-   if (f->rbuf != NULL)
+   if (f->rmap != NULL)
+      unmap_file(f->rmap, f->rmapsz);
+   else if (f->rbuf != NULL)
       free(f->rbuf);
 
    if (f->wbuf != NULL) {
@@ -578,9 +628,6 @@ void fbuf_close(fbuf_t *f, uint32_t *checksum)
          f->next->prev = f->prev;
    }
 
-   if (checksum != NULL)
-      *checksum = checksum_finish(&(f->checksum));
-
    if (f->zstd != NULL)
       ZSTD_freeCCtx(f->zstd);
 
@@ -41,8 +41,10 @@ typedef enum {
 } fbuf_zip_t;
 
 fbuf_t *fbuf_open(const char *file, fbuf_mode_t mode, fbuf_cs_t csum);
+bool fbuf_read_checksum(const char *file, fbuf_cs_t csum, uint32_t *checksum);
 void fbuf_close(fbuf_t *f, uint32_t *checksum);
 void fbuf_cleanup(void);
+void fbuf_set_zip(fbuf_t *f, fbuf_zip_t zip);
 const char *fbuf_file_name(fbuf_t *f);
 int fbuf_file_handle(fbuf_t *f);
 
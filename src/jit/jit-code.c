@@ -283,15 +283,18 @@ code_cache_t *code_cache_new(void)
 
    extern void __nvc_putpriv(jit_handle_t, void *);
    extern void __nvc_sched_waveform(jit_anchor_t *, jit_scalar_t *, tlab_t *);
+   extern void __nvc_sched_delta(jit_anchor_t *, jit_scalar_t *, tlab_t *);
    extern void __nvc_sched_process(jit_anchor_t *, jit_scalar_t *, tlab_t *);
    extern void __nvc_test_event(jit_anchor_t *, jit_scalar_t *, tlab_t *);
    extern void __nvc_last_event(jit_anchor_t *, jit_scalar_t *, tlab_t *);
 
    shash_put(s, "__nvc_sched_waveform", &__nvc_sched_waveform);
+   shash_put(s, "__nvc_sched_delta", &__nvc_sched_delta);
    shash_put(s, "__nvc_sched_process", &__nvc_sched_process);
    shash_put(s, "__nvc_test_event", &__nvc_test_event);
    shash_put(s, "__nvc_last_event", &__nvc_last_event);
    shash_put(s, "__nvc_mspace_alloc", &__nvc_mspace_alloc);
+   shash_put(s, "__nvc_write_barrier", &__nvc_write_barrier);
    shash_put(s, "__nvc_putpriv", &__nvc_putpriv);
    shash_put(s, "__nvc_do_exit", &__nvc_do_exit);
    shash_put(s, "__nvc_pack", &__nvc_pack);
@@ -889,6 +892,29 @@ static void *code_emit_got(code_blob_t *blob, void *dest)
 }
 #endif
 
+__attribute__((cold, noinline))
+static void code_blob_unresolved(code_blob_t *blob, const char *name)
+{
+   // Objects with a resolver callback may have been loaded from the JIT
+   // cache and refer to symbols which no longer exist so let the caller
+   // discard the object instead of aborting
+   if (blob->resolve == NULL)
+      fatal_trace("failed to resolve symbol %s", name);
+
+   blob->unresolved = true;
+   blob->overflow = true;   // Release the partially loaded code
+}
+
+static void *code_resolve_external(code_blob_t *blob, shash_t *external,
+                                   const char *name)
+{
+   void *ptr = shash_get(external, name);
+   if (ptr == NULL && blob->resolve != NULL)
+      ptr = (*blob->resolve)(name, blob->resolve_ctx);
+
+   return ptr;
+}
+
 #if defined __MINGW32__
 static void code_load_pe(code_blob_t *blob, const void *data, size_t size)
 {
@@ -956,13 +982,15 @@ static void code_load_pe(code_blob_t *blob, const void *data, size_t size)
             ptr = load_addr[sym->SectionNumber - 1] + sym->Value;
          }
          else
-            ptr = shash_get(external, name);
+            ptr = code_resolve_external(blob, external, name);
 
          if (ptr == NULL && icmp(blob->span->name, name))
             ptr = blob->span->base;
 
-         if (ptr == NULL)
-            fatal_trace("failed to resolve symbol %s", name);
+         if (ptr == NULL) {
+            code_blob_unresolved(blob, name);
+            return;
+         }
 
          void *patch = load_addr[i] + relocs[j].VirtualAddress;
          assert((uint8_t *)patch >= blob->span->base);
@@ -1111,8 +1139,11 @@ static void code_load_macho(code_blob_t *blob, const void *data, size_t size)
             if (nl->n_type & N_EXT) {
                if (icmp(blob->span->name, name + 1))
                   ptr = blob->span->base;
-               else if ((ptr = shash_get(external, name + 1)) == NULL)
-                  fatal_trace("failed to resolve symbol %s", name + 1);
+               else if ((ptr = code_resolve_external(blob, external,
+                                                     name + 1)) == NULL) {
+                  code_blob_unresolved(blob, name + 1);
+                  return;
+               }
             }
             else if (nl->n_sect != NO_SECT)
                ptr = blob->span->base + nl->n_value;
@@ -1289,7 +1320,8 @@ static void code_load_elf(code_blob_t *blob, const void *data, size_t size)
          case STT_NOTYPE:
          case STT_FUNC:
             if (sym->st_shndx == 0)
-               ptr = shash_get(external, strtab + sym->st_name);
+               ptr = code_resolve_external(blob, external,
+                                           strtab + sym->st_name);
             else
                ptr = load_addr[sym->st_shndx] + sym->st_value;
             break;
@@ -1301,9 +1333,10 @@ static void code_load_elf(code_blob_t *blob, const void *data, size_t size)
                         ELF64_ST_TYPE(sym->st_info));
          }
 
-         if (ptr == NULL)
-            fatal_trace("cannot resolve symbol %s type %d",
-                        strtab + sym->st_name, ELF64_ST_TYPE(sym->st_info));
+         if (ptr == NULL) {
+            code_blob_unresolved(blob, strtab + sym->st_name);
+            return;
+         }
 
          void *patch = load_addr[shdr->sh_info] + r->r_offset;
          assert(r->r_offset < mod->sh_size);
@@ -1380,7 +1413,7 @@ static void code_load_elf(code_blob_t *blob, const void *data, size_t size)
 }
 #endif
 
-void code_load_object(code_blob_t *blob, const void *data, size_t size)
+bool code_load_object(code_blob_t *blob, const void *data, size_t size)
 {
 #if defined __APPLE__
    code_load_macho(blob, data, size);
@@ -1389,4 +1422,6 @@ void code_load_object(code_blob_t *blob, const void *data, size_t size)
 #else
    code_load_elf(blob, data, size);
 #endif
+
+   return !blob->overflow;
 }
@@ -41,6 +41,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -61,6 +62,8 @@ typedef struct {
    jit_func_t *items[0];
 } func_array_t;
 
+typedef A(ident_t) unit_names_t;
+
 typedef struct _jit {
    chash_t          *index;
    mspace_t         *mspace;
@@ -76,6 +79,7 @@ typedef struct _jit {
    void             *interrupt_ctx;
    unit_registry_t  *registry;
    mir_context_t    *mir;
+   hset_t           *profile;
 } jit_t;
 
 static void jit_transition(jit_thread_local_t *thread, jit_t *j,
@@ -170,6 +174,9 @@ void jit_free(jit_t *j)
 
    diag_remove_hint_fn(jit_diag_cb, j);
 
+   if (j->profile != NULL)
+      hset_free(j->profile);
+
    mspace_destroy(j->mspace);
    chash_free(j->index);
    free(j);
@@ -192,6 +199,13 @@ void *jit_mspace_alloc(size_t size)
    return mspace_alloc(thread->jit->mspace, size);
 }
 
+void jit_write_barrier(void *ptr, size_t size)
+{
+   jit_thread_local_t *thread = jit_thread_local();
+   assert(thread->state == JIT_RUNNING);
+   mspace_write_barrier(thread->jit->mspace, ptr, size);
+}
+
 static void jit_install(jit_t *j, jit_func_t *f)
 {
    assert_lock_held(&(j->lock));
@@ -236,6 +250,7 @@ static jit_handle_t jit_lazy_compile_locked(jit_t *j, ident_t name)
    f->next_tier = j->tiers;
    f->hotness   = f->next_tier ? f->next_tier->threshold : 0;
    f->entry     = entry;
+   f->profiled  = j->profile != NULL && hset_contains(j->profile, name);
 
    // Install now to allow circular references in relocations
    jit_install(j, f);
@@ -329,7 +344,22 @@ void jit_fill_irbuf(jit_func_t *f)
 
    jit_irgen(f, mu);
 
+   // The next tier may already have code for this function from a
+   // previous run in which case the interpreter is skipped entirely
+   jit_tier_t *tier = f->next_tier;
+   if (tier != NULL && tier->plugin.probe != NULL
+       && (*tier->plugin.probe)(f->jit, f->handle, tier->context)) {
+      f->hotness   = 0;
+      f->next_tier = NULL;
+   }
+
    jit_transition(thread, f->jit, JIT_COMPILING, oldstate);
+
+   // Functions that were hot in a previous run skip the interpreter
+   if (f->profiled && f->next_tier != NULL) {
+      f->hotness = 0;
+      jit_tier_up(f);
+   }
 }
 
 jit_handle_t jit_compile(jit_t *j, ident_t name)
@@ -761,7 +791,8 @@ void *jit_call_thunk2(jit_t *j, mir_unit_t *mu, void *context,
 
 tlab_t jit_null_tlab(jit_t *j)
 {
-   tlab_t t = { .mspace = j->mspace };
+   tlab_t t;
+   tlab_init(&t, j->mspace);
    return t;
 }
 
@@ -856,6 +887,119 @@ void jit_tier_up(jit_func_t *f)
    f->next_tier = NULL;
 }
 
+void jit_precompile(jit_t *j)
+{
+   // Generate code for every function compiled to IR so far in
+   // parallel rather than interpreting each until it becomes hot
+
+   const uint64_t start_us = get_timestamp_us();
+
+   unsigned limit;
+   {
+      SCOPED_LOCK(j->lock);
+      limit = j->next_handle;
+   }
+
+   int count = 0;
+   for (jit_handle_t handle = 0; handle < limit; handle++) {
+      jit_func_t *f = jit_get_func(j, handle);
+      if (load_acquire(&(f->state)) != JIT_FUNC_READY)
+         continue;
+      else if (f->irbuf == NULL || f->next_tier == NULL)
+         continue;
+
+      f->hotness = 0;
+      jit_tier_up(f);
+      count++;
+   }
+
+   if (opt_get_int(OPT_JIT_ASYNC))
+      async_barrier();
+
+   if (opt_get_int(OPT_JIT_LOG))
+      debugf("precompiled %d functions in %"PRIi64" us", count,
+             get_timestamp_us() - start_us);
+}
+
+static void jit_collect_unit_cb(ident_t name, void *ctx)
+{
+   unit_names_t *names = ctx;
+   APUSH(*names, name);
+}
+
+void jit_compile_all(jit_t *j)
+{
+   assert(j->registry != NULL);
+
+   // Compiling a unit may add new entries to the registry so collect
+   // the names first
+   unit_names_t names = AINIT;
+   unit_registry_walk(j->registry, jit_collect_unit_cb, &names);
+
+   for (int i = 0; i < names.count; i++)
+      (void)jit_compile(j, names.items[i]);
+
+   ACLEAR(names);
+
+   jit_precompile(j);
+}
+
+void jit_load_profile(jit_t *j, const char *file)
+{
+   FILE *f = fopen(file, "r");
+   if (f == NULL)
+      return;   // Profile is written at the end of the first run
+
+   if (j->profile == NULL)
+      j->profile = hset_new(256);
+
+   char *line = NULL;
+   size_t linesz = 0;
+   ssize_t len;
+   while ((len = getline(&line, &linesz, f)) != -1) {
+      if (len > 0 && line[len - 1] == '\n')
+         line[--len] = '\0';
+
+      if (len > 0 && line[0] != '#')
+         hset_insert(j->profile, ident_new(line));
+   }
+
+   free(line);
+   fclose(f);
+
+   // Functions already compiled during elaboration
+   SCOPED_LOCK(j->lock);
+
+   for (jit_handle_t handle = 0; handle < j->next_handle; handle++) {
+      jit_func_t *func = jit_get_func(j, handle);
+      func->profiled = hset_contains(j->profile, func->name);
+   }
+}
+
+void jit_save_profile(jit_t *j, const char *file)
+{
+   FILE *f = fopen(file, "w");
+   if (f == NULL)
+      fatal_errno("%s", file);
+
+   fprintf(f, "# " PACKAGE_STRING " JIT profile\n");
+
+   unsigned limit;
+   {
+      SCOPED_LOCK(j->lock);
+      limit = j->next_handle;
+   }
+
+   for (jit_handle_t handle = 0; handle < limit; handle++) {
+      const jit_func_t *func = jit_get_func(j, handle);
+      if (func->hot || func->profiled)
+         fprintf(f, "%s\n", istr(func->name));
+   }
+
+   if (fclose(f) != 0)
+      fatal_errno("%s", file);
+}
+
 void jit_add_tier(jit_t *j, int threshold, const jit_plugin_t *plugin)
 {
    assert(threshold > 0);
@@ -971,10 +1115,12 @@ jit_handle_t jit_assemble(jit_t *j, ident_t name, const char *text)
       { "$CASE",   MACRO_CASE,   1, 2 },
       { "$SALLOC", MACRO_SALLOC, 1, 2 },
       { "$LALLOC", MACRO_LALLOC, 1, 1 },
+      { "$GALLOC", MACRO_GALLOC, 1, 1 },
       { "$BZERO",  MACRO_BZERO,  1, 1 },
       { "$MEMSET", MACRO_MEMSET, 1, 2 },
       { "$EXP",    MACRO_EXP,    1, 2 },
       { "$FEXP",   MACRO_FEXP,   1, 2 },
+      { "$BARRIER", MACRO_BARRIER, 0, 2 },
    };
 
    static const struct {
@@ -51,7 +51,7 @@ const char *jit_op_name(jit_op_t op)
          "$COPY", "$GALLOC", "$EXIT", "$FEXP", "$EXP", "$BZERO",
          "$GETPRIV", "$PUTPRIV", "$LALLOC", "$SALLOC", "$CASE",
          "$TRIM", "$MOVE", "$MEMSET", "$REEXEC", "$SADD", "$PACK",
-         "$UNPACK", "$VEC2OP", "$VEC4OP",
+         "$UNPACK", "$VEC2OP", "$VEC4OP", "$BARRIER",
       };
       assert(op - __MACRO_BASE < ARRAY_LEN(names));
       return names[op - __MACRO_BASE];
@@ -96,7 +96,7 @@ const char *jit_exit_name(jit_exit_t exit)
       "CMP_TRIGGER", "INSTANCE_NAME", "DEPOSIT_SIGNAL", "BIND_EXTERNAL",
       "SYSCALL", "DIR_FAIL", "LEVEL_TRIGGER", "ENABLE_TRIGGER",
       "DISABLE_TRIGGER", "SCHED_DEPOSIT", "PUT_DRIVER", "SCHED_INACTIVE",
-      "GET_COUNTERS", "SCHED_ACTIVE",
+      "GET_COUNTERS", "SCHED_ACTIVE", "SCHED_DELTA",
    };
    assert(exit < ARRAY_LEN(names));
    return names[exit];
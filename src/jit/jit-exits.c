@@ -338,6 +338,20 @@ void __nvc_sched_process(jit_anchor_t *anchor, jit_scalar_t *args, tlab_t *tlab)
    thread->anchor = NULL;
 }
 
+DLLEXPORT
+void __nvc_sched_delta(jit_anchor_t *anchor, jit_scalar_t *args, tlab_t *tlab)
+{
+   jit_thread_local_t *thread = jit_attach_thread(anchor);
+
+   sig_shared_t *shared = args[0].pointer;
+   int32_t       offset = args[1].integer;
+   int64_t       value  = args[2].integer;
+
+   x_sched_delta_s(shared, offset, value);
+
+   thread->anchor = NULL;
+}
+
 DLLEXPORT
 void __nvc_do_exit(jit_exit_t which, jit_anchor_t *anchor, jit_scalar_t *args,
                    tlab_t *tlab)
@@ -457,6 +471,10 @@ void __nvc_do_exit(jit_exit_t which, jit_anchor_t *anchor, jit_scalar_t *args,
       __nvc_sched_waveform(anchor, args, tlab);
       break;
 
+   case JIT_EXIT_SCHED_DELTA:
+      __nvc_sched_delta(anchor, args, tlab);
+      break;
+
    case JIT_EXIT_SCHED_INACTIVE:
       x_sched_inactive();
       break;
@@ -1431,6 +1449,12 @@ void *__nvc_mspace_alloc(uintptr_t size, jit_anchor_t *anchor)
    return ptr;
 }
 
+DLLEXPORT
+void __nvc_write_barrier(void *ptr, uintptr_t size)
+{
+   mspace_write_barrier(jit_get_mspace(jit_for_thread()), ptr, size);
+}
+
 DLLEXPORT
 void __nvc_putpriv(jit_handle_t handle, void *data)
 {
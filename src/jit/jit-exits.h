@@ -42,6 +42,7 @@ int32_t x_test_net_active(sig_shared_t *ss, uint32_t offset,
 void x_sched_event(sig_shared_t *ss, uint32_t offset, int32_t count);
 void x_sched_active(sig_shared_t *ss, uint32_t offset, int32_t count);
 void x_alias_signal(sig_shared_t *ss, uint32_t offset, tree_t where);
+void x_sched_delta_s(sig_shared_t *ss, uint32_t offset, uint64_t scalar);
 void x_sched_waveform_s(sig_shared_t *ss, uint32_t offset, uint64_t scalar,
                         int64_t after, int64_t reject);
 void x_file_open(int8_t *status, void **_fp, const uint8_t *name_bytes,
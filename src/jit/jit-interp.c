@@ -920,6 +920,14 @@ static void interp_sadd(jit_interp_t *state, jit_ir_t *ir)
    FOR_EACH_SIZE(ir->size, SADD);
 }
 
+static void interp_barrier(jit_interp_t *state, jit_ir_t *ir)
+{
+   void *ptr = interp_get_pointer(state, ir->arg1);
+   const int64_t bytes = interp_get_int(state, ir->arg2);
+
+   mspace_write_barrier(state->mspace, ptr, bytes);
+}
+
 static void interp_pack(jit_interp_t *state, jit_ir_t *ir)
 {
    const uint8_t *src = interp_get_pointer(state, ir->arg1);
@@ -1119,6 +1127,9 @@ static void interp_loop(jit_interp_t *state)
       case MACRO_VEC4OP:
          interp_vec4op(state, ir);
          break;
+      case MACRO_BARRIER:
+         interp_barrier(state, ir);
+         break;
       default:
          interp_dump(state);
          fatal_trace("cannot interpret opcode %s", jit_op_name(ir->op));
@@ -1138,8 +1149,10 @@ void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
 
    jit_fill_irbuf(f);
 
-   if (f->next_tier && --(f->hotness) <= 0)
+   if (f->next_tier && --(f->hotness) <= 0) {
+      f->hot = true;
       jit_tier_up(f);
+   }
 
    jit_anchor_t anchor = {
       .caller    = caller,
@@ -735,9 +735,58 @@ static void macro_vec4op(jit_irgen_t *g, jit_vec_op_t op, int size)
                      jit_value_from_int64(size));
 }
 
+static void macro_barrier(jit_irgen_t *g, jit_value_t addr, jit_value_t bytes)
+{
+   // Constant pool and absolute addresses never point into the heap
+   if (addr.kind != JIT_ADDR_REG)
+      return;
+
+   jit_value_t ptr = jit_value_from_reg(addr.reg);
+   if (addr.disp != 0) {
+      ptr = irgen_alloc_temp(g);
+      j_lea(g, ptr, addr);
+   }
+
+   irgen_emit_binary(g, MACRO_BARRIER, JIT_SZ_UNSPEC, JIT_CC_NONE,
+                     JIT_REG_INVALID, ptr, bytes);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // MIR to JIT IR lowering
 
+static bool irgen_has_pointers(jit_irgen_t *g, mir_type_t type)
+{
+   switch (mir_get_class(g->mu, type)) {
+   case MIR_TYPE_INT:
+   case MIR_TYPE_OFFSET:
+   case MIR_TYPE_REAL:
+   case MIR_TYPE_FILE:
+   case MIR_TYPE_SIGNAL:
+   case MIR_TYPE_TRIGGER:
+   case MIR_TYPE_VEC2:
+   case MIR_TYPE_VEC4:
+      return false;
+
+   case MIR_TYPE_CARRAY:
+      return irgen_has_pointers(g, mir_get_elem(g->mu, type));
+
+   case MIR_TYPE_RECORD:
+      {
+         size_t nfields;
+         const mir_type_t *fields = mir_get_fields(g->mu, type, &nfields);
+         for (int i = 0; i < nfields; i++) {
+            if (irgen_has_pointers(g, fields[i]))
+               return true;
+         }
+
+         return false;
+      }
+
+   default:
+      return true;
+   }
+}
+
 static int irgen_repr_bits(mir_repr_t repr)
 {
    switch (repr) {
@@ -1415,6 +1464,9 @@ static void irgen_op_copy(jit_irgen_t *g, mir_value_t n)
    jit_value_t src = jit_addr_from_value(arg1, 0);
 
    macro_move(g, dest, src, bytes);
+
+   if (irgen_has_pointers(g, elem))
+      macro_barrier(g, dest, bytes);
 }
 
 static void irgen_op_set(jit_irgen_t *g, mir_value_t n)
@@ -1962,6 +2014,7 @@ static void irgen_op_store(jit_irgen_t *g, mir_value_t n)
       }
       else
          j_store(g, JIT_SZ_PTR, value, addr);
+      macro_barrier(g, addr, jit_value_from_int64(sizeof(void *)));
       break;
 
    case MIR_TYPE_FILE:
@@ -1971,11 +2024,14 @@ static void irgen_op_store(jit_irgen_t *g, mir_value_t n)
    case MIR_TYPE_UARRAY:
       {
          const int slots = mir_get_slots(g->mu, mir_get_elem(g->mu, type));
+         jit_value_t base = addr;
          for (int i = 0; i < slots; i++) {
             j_store(g, JIT_SZ_PTR, irgen_get_slot(g, arg1, i), addr);
             addr = jit_addr_from_value(addr, sizeof(void *));
          }
 
+         macro_barrier(g, base, jit_value_from_int64(slots * sizeof(void *)));
+
          const int ndims = mir_get_dims(g->mu, type);
          for (int i = 0; i < 2*ndims; i++) {
             j_store(g, JIT_SZ_64, irgen_get_slot(g, arg1, slots + i), addr);
@@ -1992,6 +2048,7 @@ static void irgen_op_store(jit_irgen_t *g, mir_value_t n)
 
    case MIR_TYPE_RESOLUTION:
       j_store(g, JIT_SZ_PTR, irgen_get_slot(g, arg1, 0), addr); // Closure
+      macro_barrier(g, addr, jit_value_from_int64(sizeof(void *)));
       addr = jit_addr_from_value(addr, sizeof(void *));
       j_store(g, JIT_SZ_64, irgen_get_slot(g, arg1, 1), addr);  // Literals
       addr = jit_addr_from_value(addr, sizeof(int64_t));
@@ -2663,6 +2720,7 @@ static void irgen_pcall_suspend(jit_irgen_t *g, jit_value_t state,
 {
    jit_value_t pcall_ptr = irgen_pcall_ptr(g);
    j_store(g, JIT_SZ_PTR, state, pcall_ptr);
+   macro_barrier(g, pcall_ptr, jit_value_from_int64(sizeof(void *)));
 
    j_cmp(g, JIT_CC_EQ, state, jit_null_ptr());
    j_jump(g, JIT_CC_T, cont);
@@ -3547,6 +3605,21 @@ static void irgen_op_sched_waveform(jit_irgen_t *g, mir_value_t n)
 
    jit_value_t scalar = irgen_is_scalar(g, n, 2);
 
+   const bool delta =
+      after.kind == JIT_VALUE_INT64 && after.int64 == 0
+      && reject.kind == JIT_VALUE_INT64 && reject.int64 == 0;
+
+   if (scalar.int64 && delta) {
+      // Delta cycle assignment to a scalar signal is by far the most
+      // common case and has a dedicated exit with fewer checks
+      j_send(g, 0, shared);
+      j_send(g, 1, offset);
+      j_send(g, 2, value);
+
+      macro_exit(g, JIT_EXIT_SCHED_DELTA);
+      return;
+   }
+
    j_send(g, 0, shared);
    j_send(g, 1, offset);
    j_send(g, 2, count);
@@ -4117,6 +4190,185 @@ static jit_value_t irgen_arith_xbits(jit_irgen_t *g, jit_value_t left,
    return result;
 }
 
+static void irgen_load_words(jit_irgen_t *g, jit_value_t ptr,
+                             jit_value_t words[2])
+{
+   for (int i = 0; i < 2; i++) {
+      words[i] = irgen_alloc_temp(g);
+      j_load(g, JIT_SZ_64, words[i], jit_addr_from_value(ptr, i * 8));
+   }
+}
+
+static bool irgen_vec4_binary_wide(jit_irgen_t *g, mir_value_t n,
+                                   mir_vec_op_t op, jit_value_t aleft,
+                                   jit_value_t bleft, jit_value_t aright,
+                                   jit_value_t bright)
+{
+   // Expand bitwise and equality operations on vectors that fit in two
+   // words inline rather than calling __nvc_vec4op
+
+   switch (op) {
+   case MIR_VEC_BIT_AND:
+   case MIR_VEC_BIT_OR:
+   case MIR_VEC_BIT_XOR:
+   case MIR_VEC_CASE_EQ:
+   case MIR_VEC_CASE_NEQ:
+   case MIR_VEC_LOG_EQ:
+   case MIR_VEC_LOG_NEQ:
+      break;
+   default:
+      return false;
+   }
+
+   jit_value_t xa[2], xb[2], ya[2], yb[2];
+   irgen_load_words(g, aleft, xa);
+   irgen_load_words(g, bleft, xb);
+   irgen_load_words(g, aright, ya);
+   irgen_load_words(g, bright, yb);
+
+   jit_value_t ones = jit_value_from_int64(-1);
+   jit_value_t zero = jit_value_from_int64(0);
+
+   switch (op) {
+   case MIR_VEC_BIT_AND:
+   case MIR_VEC_BIT_OR:
+   case MIR_VEC_BIT_XOR:
+      {
+         jit_value_t ptr = irgen_alloc_temp(g);
+         macro_galloc(g, ptr, jit_value_from_int64(4 * sizeof(uint64_t)));
+
+         for (int i = 0; i < 2; i++) {
+            jit_value_t abits = irgen_alloc_temp(g);
+            jit_value_t bbits = irgen_alloc_temp(g);
+
+            switch (op) {
+            case MIR_VEC_BIT_AND:
+               {
+                  jit_value_t lmaybe1 = irgen_alloc_temp(g);
+                  j_or(g, lmaybe1, xa[i], xb[i]);
+
+                  jit_value_t rmaybe1 = irgen_alloc_temp(g);
+                  j_or(g, rmaybe1, ya[i], yb[i]);
+
+                  jit_value_t tmp = irgen_alloc_temp(g);
+                  j_and(g, bbits, xb[i], rmaybe1);
+                  j_and(g, tmp, yb[i], lmaybe1);
+                  j_or(g, bbits, bbits, tmp);
+
+                  j_and(g, abits, xa[i], ya[i]);
+                  j_or(g, abits, abits, bbits);
+               }
+               break;
+            case MIR_VEC_BIT_OR:
+               {
+                  jit_value_t lnot1 = irgen_alloc_temp(g);
+                  j_xor(g, lnot1, xb[i], ones);
+                  j_and(g, lnot1, lnot1, xa[i]);
+                  j_xor(g, lnot1, lnot1, ones);
+
+                  jit_value_t rnot1 = irgen_alloc_temp(g);
+                  j_xor(g, rnot1, yb[i], ones);
+                  j_and(g, rnot1, rnot1, ya[i]);
+                  j_xor(g, rnot1, rnot1, ones);
+
+                  jit_value_t tmp = irgen_alloc_temp(g);
+                  j_and(g, bbits, xb[i], rnot1);
+                  j_and(g, tmp, yb[i], lnot1);
+                  j_or(g, bbits, bbits, tmp);
+
+                  j_or(g, abits, xa[i], ya[i]);
+                  j_or(g, abits, abits, bbits);
+               }
+               break;
+            default:
+               j_or(g, bbits, xb[i], yb[i]);
+               j_xor(g, abits, xa[i], ya[i]);
+               j_or(g, abits, abits, bbits);
+               break;
+            }
+
+            j_store(g, JIT_SZ_64, abits, jit_addr_from_value(ptr, i * 8));
+            j_store(g, JIT_SZ_64, bbits, jit_addr_from_value(ptr, 16 + i * 8));
+         }
+
+         j_mov(g, irgen_get_slot(g, n, 0), ptr);
+         j_add(g, irgen_get_slot(g, n, 1), ptr, jit_value_from_int64(16));
+      }
+      break;
+
+   case MIR_VEC_CASE_EQ:
+   case MIR_VEC_CASE_NEQ:
+      {
+         jit_value_t diff = irgen_alloc_temp(g), tmp = irgen_alloc_temp(g);
+         j_xor(g, diff, xa[0], ya[0]);
+         for (int i = 0; i < 2; i++) {
+            if (i > 0) {
+               j_xor(g, tmp, xa[i], ya[i]);
+               j_or(g, diff, diff, tmp);
+            }
+            j_xor(g, tmp, xb[i], yb[i]);
+            j_or(g, diff, diff, tmp);
+         }
+
+         j_cmp(g, op == MIR_VEC_CASE_EQ ? JIT_CC_EQ : JIT_CC_NE, diff, zero);
+         j_cset(g, irgen_get_slot(g, n, 0));
+         j_mov(g, irgen_get_slot(g, n, 1), zero);
+      }
+      break;
+
+   case MIR_VEC_LOG_EQ:
+   case MIR_VEC_LOG_NEQ:
+      {
+         jit_value_t unknown = irgen_alloc_temp(g);
+         jit_value_t known_diff = irgen_alloc_temp(g);
+         jit_value_t umask = irgen_alloc_temp(g), tmp = irgen_alloc_temp(g);
+
+         for (int i = 0; i < 2; i++) {
+            j_or(g, umask, xb[i], yb[i]);
+            j_xor(g, tmp, xa[i], ya[i]);
+
+            if (i == 0)
+               j_mov(g, unknown, umask);
+            else
+               j_or(g, unknown, unknown, umask);
+
+            j_xor(g, umask, umask, ones);
+            j_and(g, tmp, tmp, umask);
+
+            if (i == 0)
+               j_mov(g, known_diff, tmp);
+            else
+               j_or(g, known_diff, known_diff, tmp);
+         }
+
+         // A known difference takes precedence over any unknown bits
+         jit_value_t has_diff = irgen_alloc_temp(g);
+         j_cmp(g, JIT_CC_NE, known_diff, zero);
+         j_cset(g, has_diff);
+
+         jit_value_t xbits = irgen_alloc_temp(g);
+         j_cmp(g, JIT_CC_NE, unknown, zero);
+         j_cset(g, xbits);
+         j_cmp(g, JIT_CC_NE, has_diff, zero);
+         j_csel(g, xbits, zero, xbits);
+
+         jit_value_t abits = irgen_get_slot(g, n, 0);
+         if (op == MIR_VEC_LOG_EQ)
+            j_xor(g, abits, has_diff, jit_value_from_int64(1));
+         else
+            j_or(g, abits, has_diff, xbits);
+
+         j_mov(g, irgen_get_slot(g, n, 1), xbits);
+      }
+      break;
+
+   default:
+      should_not_reach_here();
+   }
+
+   return true;
+}
+
 static void irgen_op_binary(jit_irgen_t *g, mir_value_t n)
 {
    mir_value_t left = mir_get_arg(g->mu, n, 1);
@@ -4147,6 +4399,10 @@ static void irgen_op_binary(jit_irgen_t *g, mir_value_t n)
    if (size == 64 && issigned && (op == MIR_VEC_DIV || op == MIR_VEC_MOD))
       call_runtime = true;  // Division corner case
 
+   if (is_vec4 && size > 64 && size <= 128
+       && irgen_vec4_binary_wide(g, n, op, aleft, bleft, aright, bright))
+      return;
+
    if (call_runtime) {
       jit_vec_op_t jop;
       switch (op) {
@@ -27,11 +27,21 @@
 #include "thread.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
 #include <libgen.h>
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
 #include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __MINGW32__
+#include <direct.h>
+#endif
+
+#include "thirdparty/sha1.h"
 
 #include <llvm-c/Analysis.h>
 #include <llvm-c/Core.h>
@@ -129,9 +139,12 @@ typedef enum {
    LLVM_DO_EXIT,
    LLVM_PUTPRIV,
    LLVM_MSPACE_ALLOC,
+   LLVM_WRITE_BARRIER,
    LLVM_GET_OBJECT,
    LLVM_TLAB_ALLOC,
+   LLVM_CARD_MARK,
    LLVM_SCHED_WAVEFORM,
+   LLVM_SCHED_DELTA,
    LLVM_TEST_EVENT,
    LLVM_LAST_EVENT,
    LLVM_SCHED_PROCESS,
@@ -156,6 +169,8 @@ typedef struct _cgen_block cgen_block_t;
 #define ARGCACHE_SIZE          6
 #define ENABLE_DWARF           0
 #define INLINE_LIMIT           0
+#define RELOC_PREFIX           "__nvc_reloc."
+#define CACHE_FORMAT           2
 
 #if defined __APPLE__ && defined ARCH_ARM64
 #define JIT_CODE_MODEL LLVMCodeModelSmall
@@ -186,6 +201,7 @@ typedef struct _llvm_obj {
    LLVMTypeRef           fntypes[LLVM_LAST_FN];
    LLVMValueRef          strtab;
    unsigned              opt_hint;
+   bool                  relocatable;
 } llvm_obj_t;
 
 typedef struct _cgen_block {
@@ -366,6 +382,10 @@ static void llvm_register_types(llvm_obj_t *obj)
          obj->types[LLVM_PTR],                     // Mspace object
          obj->types[LLVM_INT32],                   // Allocation pointer
          obj->types[LLVM_INT32],                   // Limit pointer
+         obj->types[LLVM_PTR],                     // Heap base
+         obj->types[LLVM_INTPTR],                  // Heap size
+         obj->types[LLVM_PTR],                     // Card table
+         obj->types[LLVM_INTPTR],                  // Padding
          LLVMArrayType(obj->types[LLVM_INT8], 0),  // Data
       };
       obj->types[LLVM_TLAB] = LLVMStructTypeInContext(obj->context, fields,
@@ -850,6 +870,7 @@ static LLVMValueRef llvm_get_fn(llvm_obj_t *obj, llvm_fn_t which)
       break;
 
    case LLVM_SCHED_WAVEFORM:
+   case LLVM_SCHED_DELTA:
    case LLVM_TEST_EVENT:
    case LLVM_LAST_EVENT:
    case LLVM_SCHED_PROCESS:
@@ -873,6 +894,7 @@ static LLVMValueRef llvm_get_fn(llvm_obj_t *obj, llvm_fn_t which)
          const char *sym = NULL;
          switch (which) {
          case LLVM_SCHED_WAVEFORM: sym = "__nvc_sched_waveform"; break;
+         case LLVM_SCHED_DELTA: sym = "__nvc_sched_delta"; break;
          case LLVM_TEST_EVENT: sym = "__nvc_test_event"; break;
          case LLVM_LAST_EVENT: sym = "__nvc_last_event"; break;
          case LLVM_SCHED_PROCESS: sym = "__nvc_sched_process"; break;
@@ -982,6 +1004,21 @@ static LLVMValueRef llvm_get_fn(llvm_obj_t *obj, llvm_fn_t which)
       }
       break;
 
+   case LLVM_WRITE_BARRIER:
+      {
+         LLVMTypeRef args[] = {
+            obj->types[LLVM_PTR],
+            obj->types[LLVM_INTPTR],
+         };
+         obj->fntypes[which] = LLVMFunctionType(obj->types[LLVM_VOID], args,
+                                                ARRAY_LEN(args), false);
+
+         fn = llvm_add_fn(obj, "__nvc_write_barrier", obj->fntypes[which]);
+         llvm_add_func_attr(obj, fn, FUNC_ATTR_NOUNWIND, -1);
+         llvm_add_func_attr(obj, fn, FUNC_ATTR_NOCAPTURE, 1);
+      }
+      break;
+
    case LLVM_GET_OBJECT:
       {
          LLVMTypeRef args[] = {
@@ -1019,6 +1056,24 @@ static LLVMValueRef llvm_get_fn(llvm_obj_t *obj, llvm_fn_t which)
       }
       break;
 
+   case LLVM_CARD_MARK:
+      {
+         LLVMTypeRef args[] = {
+#ifdef LLVM_HAS_OPAQUE_POINTERS
+            obj->types[LLVM_PTR],
+#else
+            LLVMPointerType(obj->types[LLVM_TLAB], 0),
+#endif
+            obj->types[LLVM_PTR],
+         };
+         obj->fntypes[which] = LLVMFunctionType(obj->types[LLVM_VOID], args,
+                                                ARRAY_LEN(args), false);
+         fn = llvm_add_fn(obj, "card_mark", obj->fntypes[which]);
+         llvm_add_func_attr(obj, fn, FUNC_ATTR_NOUNWIND, -1);
+         llvm_add_func_attr(obj, fn, FUNC_ATTR_INLINE, -1);
+      }
+      break;
+
    default:
       fatal_trace("cannot generate prototype for function %d", which);
    }
@@ -1150,6 +1205,50 @@ static LLVMIntPredicate cgen_int_pred(cgen_block_t *cgb, jit_ir_t *ir)
    }
 }
 
+__attribute__((format(printf, 3, 4)))
+static LLVMValueRef cgen_reloc_global(llvm_obj_t *obj, llvm_type_t type,
+                                      const char *fmt, ...)
+{
+   // Pointers which differ between runs are referenced through named
+   // symbols resolved at load time so the object can be cached
+
+   va_list ap;
+   va_start(ap, fmt);
+   char *name LOCAL = xvasprintf(fmt, ap);
+   va_end(ap);
+
+   LLVMValueRef global = LLVMGetNamedGlobal(obj->module, name);
+   if (global == NULL) {
+      global = LLVMAddGlobal(obj->module, obj->types[type], name);
+      LLVMSetLinkage(global, LLVMExternalLinkage);
+   }
+
+   return global;
+}
+
+static LLVMValueRef cgen_reloc_ptr(llvm_obj_t *obj, const char *kind,
+                                   ident_t name)
+{
+   LLVMValueRef global = cgen_reloc_global(obj, LLVM_STRTAB, RELOC_PREFIX
+                                           "%s:%s", kind, istr(name));
+   return PTR(global);
+}
+
+static LLVMValueRef cgen_locus(llvm_obj_t *obj, object_t *locus)
+{
+   if (!obj->relocatable || locus == NULL)
+      return llvm_ptr(obj, locus);
+
+   ident_t module;
+   ptrdiff_t offset;
+   object_locus(locus, &module, &offset);
+
+   LLVMValueRef global = cgen_reloc_global(obj, LLVM_STRTAB, RELOC_PREFIX
+                                           "locus:%s:%td", istr(module),
+                                           offset);
+   return PTR(global);
+}
+
 static LLVMValueRef cgen_get_value(llvm_obj_t *obj, cgen_block_t *cgb,
                                    jit_value_t value)
 {
@@ -1164,7 +1263,15 @@ static LLVMValueRef cgen_get_value(llvm_obj_t *obj, cgen_block_t *cgb,
       return llvm_real(obj, value.dval);
    case JIT_ADDR_CPOOL:
       assert(value.int64 >= 0 && value.int64 <= cgb->func->source->cpoolsz);
-      return llvm_ptr(obj, cgb->func->source->cpool + value.int64);
+      if (obj->relocatable) {
+         LLVMValueRef base =
+            cgen_reloc_ptr(obj, "cpool", cgb->func->source->name);
+         LLVMValueRef indexes[] = { llvm_intptr(obj, value.int64) };
+         return LLVMBuildGEP2(obj->builder, obj->types[LLVM_INT8],
+                              base, indexes, 1, "");
+      }
+      else
+         return llvm_ptr(obj, cgb->func->source->cpool + value.int64);
    case JIT_ADDR_REG:
       {
          assert(value.reg < cgb->func->source->nregs);
@@ -1186,11 +1293,21 @@ static LLVMValueRef cgen_get_value(llvm_obj_t *obj, cgen_block_t *cgb,
    case JIT_VALUE_EXIT:
       return llvm_int32(obj, value.exit);
    case JIT_VALUE_HANDLE:
-      return llvm_int32(obj, value.handle);
+      if (obj->relocatable) {
+         // Handles are allocated in a different order each run
+         jit_t *j = cgb->func->source->jit;
+         LLVMValueRef global =
+            cgen_reloc_global(obj, LLVM_INT32, RELOC_PREFIX "handle:%s",
+                              istr(jit_get_name(j, value.handle)));
+         return LLVMBuildLoad2(obj->builder, obj->types[LLVM_INT32],
+                               global, "");
+      }
+      else
+         return llvm_int32(obj, value.handle);
    case JIT_ADDR_ABS:
       return llvm_ptr(obj, (void *)(intptr_t)value.int64);
    case JIT_VALUE_LOCUS:
-      return llvm_ptr(obj, value.locus);
+      return cgen_locus(obj, value.locus);
    default:
       fatal_trace("cannot handle value kind %d", value.kind);
    }
@@ -1887,7 +2004,11 @@ static void cgen_op_call(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 
    jit_func_t *callee = jit_get_func(cgb->func->source->jit, ir->arg1.handle);
 
-   LLVMValueRef fptr = llvm_ptr(obj, callee);
+   LLVMValueRef fptr;
+   if (obj->relocatable)
+      fptr = cgen_reloc_ptr(obj, "func", callee->name);
+   else
+      fptr = llvm_ptr(obj, callee);
 
    LLVMValueRef entry = cgen_maybe_inline(obj, callee);
    if (entry == NULL) {
@@ -2076,6 +2197,17 @@ static void cgen_macro_exit(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
       }
       break;
 
+   case JIT_EXIT_SCHED_DELTA:
+      {
+         LLVMValueRef args[] = {
+            PTR(cgb->func->anchor),
+            cgb->func->args,
+            cgb->func->tlab,
+         };
+         llvm_call_fn(obj, LLVM_SCHED_DELTA, args, ARRAY_LEN(args));
+      }
+      break;
+
    case JIT_EXIT_TEST_EVENT:
       {
          LLVMValueRef args[] = {
@@ -2181,7 +2313,12 @@ static void cgen_macro_salloc(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 static void cgen_macro_getpriv(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 {
    jit_func_t *f = jit_get_func(cgb->func->source->jit, ir->arg1.handle);
-   LLVMValueRef ptrptr = llvm_ptr(obj, jit_get_privdata_ptr(f->jit, f));
+
+   LLVMValueRef ptrptr;
+   if (obj->relocatable)
+      ptrptr = cgen_reloc_ptr(obj, "priv", f->name);
+   else
+      ptrptr = llvm_ptr(obj, jit_get_privdata_ptr(f->jit, f));
 
 #ifndef LLVM_HAS_OPAQUE_POINTERS
    LLVMTypeRef ptr_type = LLVMPointerType(obj->types[LLVM_PTR], 0);
@@ -2243,6 +2380,36 @@ static void cgen_macro_vec4op(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
    llvm_call_fn(obj, LLVM_VEC4OP, args, ARRAY_LEN(args));
 }
 
+static void cgen_macro_barrier(llvm_obj_t *obj, cgen_block_t *cgb,
+                               jit_ir_t *ir)
+{
+   LLVMValueRef ptr = cgen_coerce_value(obj, cgb, ir->arg1, LLVM_PTR);
+
+   if (ir->arg2.kind == JIT_VALUE_INT64
+       && ir->arg2.int64 <= (1 << MSPACE_CARD_SHIFT)) {
+      // Spans at most two cards so mark the first and last inline
+      LLVMValueRef args1[] = { cgb->func->tlab, ptr };
+      llvm_call_fn(obj, LLVM_CARD_MARK, args1, ARRAY_LEN(args1));
+
+      if (ir->arg2.int64 > sizeof(void *)) {
+         LLVMValueRef indexes[] = { llvm_intptr(obj, ir->arg2.int64 - 1) };
+         LLVMValueRef last = LLVMBuildGEP2(obj->builder,
+                                           obj->types[LLVM_INT8], ptr,
+                                           indexes, ARRAY_LEN(indexes), "");
+
+         LLVMValueRef args2[] = { cgb->func->tlab, last };
+         llvm_call_fn(obj, LLVM_CARD_MARK, args2, ARRAY_LEN(args2));
+      }
+   }
+   else {
+      LLVMValueRef args[] = {
+         ptr,
+         cgen_coerce_value(obj, cgb, ir->arg2, LLVM_INTPTR),
+      };
+      llvm_call_fn(obj, LLVM_WRITE_BARRIER, args, ARRAY_LEN(args));
+   }
+}
+
 static void cgen_macro_case(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 {
    jit_ir_t *first = cgb->func->source->irbuf + cgb->source->first;
@@ -2496,6 +2663,9 @@ static void cgen_ir(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
    case MACRO_VEC4OP:
       cgen_macro_vec4op(obj, cgb, ir);
       break;
+   case MACRO_BARRIER:
+      cgen_macro_barrier(obj, cgb, ir);
+      break;
    case MACRO_CASE:
       cgen_macro_case(obj, cgb, ir);
       break;
@@ -2931,7 +3101,7 @@ static void cgen_tlab_alloc_body(llvm_obj_t *obj)
    LLVMBuildStore(obj->builder, next, alloc_ptr);
 
    LLVMValueRef base =
-      LLVMBuildStructGEP2(obj->builder, obj->types[LLVM_TLAB], tlab, 3, "");
+      LLVMBuildStructGEP2(obj->builder, obj->types[LLVM_TLAB], tlab, 7, "");
 
    LLVMValueRef indexes[] = { alloc };
    LLVMValueRef fast_ptr = LLVMBuildInBoundsGEP2(obj->builder,
@@ -2950,6 +3120,72 @@ static void cgen_tlab_alloc_body(llvm_obj_t *obj)
    LLVMBuildRet(obj->builder, slow_ptr);
 }
 
+static void cgen_card_mark_body(llvm_obj_t *obj)
+{
+   LLVMValueRef fn = obj->fns[LLVM_CARD_MARK];
+   LLVMSetLinkage(fn, LLVMPrivateLinkage);
+
+#ifdef PRESERVE_FRAME_POINTER
+   llvm_add_func_attr(obj, fn, FUNC_ATTR_PRESERVE_FP, 0);
+#endif
+
+   LLVMBasicBlockRef entry = llvm_append_block(obj, fn, "");
+
+   LLVMPositionBuilderAtEnd(obj->builder, entry);
+
+   LLVMValueRef tlab = LLVMGetParam(fn, 0);
+   LLVMSetValueName(tlab, "tlab");
+
+   LLVMValueRef ptr = LLVMGetParam(fn, 1);
+   LLVMSetValueName(ptr, "ptr");
+
+   LLVMBasicBlockRef mark_bb = llvm_append_block(obj, fn, "");
+   LLVMBasicBlockRef skip_bb = llvm_append_block(obj, fn, "");
+
+   LLVMValueRef heap_ptr =
+      LLVMBuildStructGEP2(obj->builder, obj->types[LLVM_TLAB], tlab, 3, "");
+   LLVMValueRef size_ptr =
+      LLVMBuildStructGEP2(obj->builder, obj->types[LLVM_TLAB], tlab, 4, "");
+
+   LLVMValueRef heap =
+      LLVMBuildLoad2(obj->builder, obj->types[LLVM_PTR], heap_ptr, "");
+   LLVMValueRef size =
+      LLVMBuildLoad2(obj->builder, obj->types[LLVM_INTPTR], size_ptr, "");
+
+   LLVMValueRef off = LLVMBuildSub(
+      obj->builder,
+      LLVMBuildPtrToInt(obj->builder, ptr, obj->types[LLVM_INTPTR], ""),
+      LLVMBuildPtrToInt(obj->builder, heap, obj->types[LLVM_INTPTR], ""), "");
+
+   // The heap size is zero unless the heap is generational
+   LLVMValueRef inheap = LLVMBuildICmp(obj->builder, LLVMIntULT, off, size, "");
+   LLVMBuildCondBr(obj->builder, inheap, mark_bb, skip_bb);
+
+   LLVMPositionBuilderAtEnd(obj->builder, mark_bb);
+
+   LLVMValueRef cards_ptr =
+      LLVMBuildStructGEP2(obj->builder, obj->types[LLVM_TLAB], tlab, 5, "");
+   LLVMValueRef cards =
+      LLVMBuildLoad2(obj->builder, obj->types[LLVM_PTR], cards_ptr, "");
+
+   LLVMValueRef shift = llvm_intptr(obj, MSPACE_CARD_SHIFT);
+   LLVMValueRef indexes[] = { LLVMBuildLShr(obj->builder, off, shift, "") };
+   LLVMValueRef card = LLVMBuildInBoundsGEP2(obj->builder,
+                                             obj->types[LLVM_INT8],
+                                             cards, indexes,
+                                             ARRAY_LEN(indexes), "");
+
+   LLVMValueRef store = LLVMBuildStore(obj->builder, llvm_int8(obj, 1), card);
+   LLVMSetAlignment(store, 1);
+   LLVMSetOrdering(store, LLVMAtomicOrderingMonotonic);
+
+   LLVMBuildRetVoid(obj->builder);
+
+   LLVMPositionBuilderAtEnd(obj->builder, skip_bb);
+
+   LLVMBuildRetVoid(obj->builder);
+}
+
 static void cgen_exp_overflow_body(llvm_obj_t *obj, llvm_fn_t which,
                                    jit_size_t sz, llvm_fn_t mulbase)
 {
@@ -3154,6 +3390,237 @@ static void *jit_llvm_init(jit_t *jit)
    return state;
 }
 
+static void cache_hash_value(SHA1_CTX *ctx, jit_t *j, jit_value_t value)
+{
+   SHA1Update(ctx, (const unsigned char *)&value.kind, sizeof(value.kind));
+   SHA1Update(ctx, (const unsigned char *)&value.disp, sizeof(value.disp));
+
+   switch (value.kind) {
+   case JIT_VALUE_HANDLE:
+      {
+         const char *name = istr(jit_get_name(j, value.handle));
+         SHA1Update(ctx, (const unsigned char *)name, strlen(name) + 1);
+      }
+      break;
+   case JIT_VALUE_LOCUS:
+      if (value.locus != NULL) {
+         ident_t module;
+         ptrdiff_t offset;
+         object_locus(value.locus, &module, &offset);
+
+         const char *name = istr(module);
+         SHA1Update(ctx, (const unsigned char *)name, strlen(name) + 1);
+         SHA1Update(ctx, (const unsigned char *)&offset, sizeof(offset));
+      }
+      break;
+   case JIT_VALUE_LOC:
+      break;   // Only used for debug information
+   default:
+      SHA1Update(ctx, (const unsigned char *)&value.int64,
+                 sizeof(value.int64));
+      break;
+   }
+}
+
+static bool cache_key(jit_func_t *f, char hex[SHA_HEX_LEN])
+{
+   // The key covers everything the generated code depends on other
+   // than pointers which are resolved by name when the object is loaded
+
+   for (int i = 0; i < f->nirs; i++) {
+      const jit_value_t args[] = { f->irbuf[i].arg1, f->irbuf[i].arg2 };
+      for (int j = 0; j < ARRAY_LEN(args); j++) {
+         if (args[j].kind == JIT_ADDR_ABS && args[j].int64 != 0)
+            return false;
+         else if (args[j].kind == JIT_VALUE_LOCUS && args[j].locus != NULL
+                  && !arena_frozen(object_arena(args[j].locus)))
+            return false;
+      }
+   }
+
+   SHA1_CTX ctx;
+   SHA1Init(&ctx);
+
+   // Profiled functions are compiled at a higher optimisation level so
+   // must not reuse an object generated before they were known to be hot
+   char *header LOCAL = xasprintf("%d:%s:%s:%d:%d", CACHE_FORMAT,
+                                  PACKAGE_VERSION, LLVM_VERSION,
+                                  JIT_CODE_MODEL, f->profiled);
+   SHA1Update(&ctx, (const unsigned char *)header, strlen(header) + 1);
+
+   char *triple = LLVMGetDefaultTargetTriple();
+   SHA1Update(&ctx, (const unsigned char *)triple, strlen(triple) + 1);
+   LLVMDisposeMessage(triple);
+
+   const char *name = istr(f->name);
+   SHA1Update(&ctx, (const unsigned char *)name, strlen(name) + 1);
+
+   const int32_t sizes[] = { f->nregs, f->framesz, f->nirs, f->cpoolsz };
+   SHA1Update(&ctx, (const unsigned char *)sizes, sizeof(sizes));
+   SHA1Update(&ctx, f->cpool, f->cpoolsz);
+
+   for (int i = 0; i < f->nirs; i++) {
+      const jit_ir_t *ir = &(f->irbuf[i]);
+      const uint8_t fields[] = { ir->op, ir->size, ir->target, ir->cc };
+      SHA1Update(&ctx, fields, sizeof(fields));
+      SHA1Update(&ctx, (const unsigned char *)&ir->result, sizeof(ir->result));
+      cache_hash_value(&ctx, f->jit, ir->arg1);
+      cache_hash_value(&ctx, f->jit, ir->arg2);
+   }
+
+   unsigned char hash[SHA1_LEN];
+   SHA1Final(hash, &ctx);
+
+   for (int i = 0; i < SHA1_LEN; i++)
+      snprintf(hex + i * 2, 3, "%02x", hash[i]);
+
+   return true;
+}
+
+static void *cache_resolve(const char *name, void *context)
+{
+   jit_func_t *f = context;
+
+   if (strncmp(name, RELOC_PREFIX, sizeof(RELOC_PREFIX) - 1) != 0)
+      return NULL;
+
+   const char *kind = name + sizeof(RELOC_PREFIX) - 1;
+   const char *arg = strchr(kind, ':');
+   if (arg++ == NULL)
+      return NULL;
+
+   const size_t kindlen = arg - kind - 1;
+
+   if (strncmp(kind, "locus", kindlen) == 0) {
+      const char *sep = strrchr(arg, ':');
+      if (sep == NULL)
+         return NULL;
+
+      ident_t module = ident_new_n(arg, sep - arg);
+      ptrdiff_t offset = strtoll(sep + 1, NULL, 10);
+      return object_from_locus(module, offset, lib_load_handler);
+   }
+
+   jit_handle_t handle = jit_lazy_compile(f->jit, ident_new(arg));
+   if (handle == JIT_HANDLE_INVALID)
+      return NULL;
+
+   jit_func_t *target = jit_get_func(f->jit, handle);
+
+   if (strncmp(kind, "cpool", kindlen) == 0)
+      return target == f ? f->cpool : NULL;
+   else if (strncmp(kind, "func", kindlen) == 0)
+      return target;
+   else if (strncmp(kind, "handle", kindlen) == 0)
+      return &(target->handle);
+   else if (strncmp(kind, "priv", kindlen) == 0)
+      return jit_get_privdata_ptr(f->jit, target);
+   else
+      return NULL;
+}
+
+static bool cache_load(llvm_jit_state_t *state, jit_func_t *f,
+                       const char *path)
+{
+   FILE *file = fopen(path, "rb");
+   if (file == NULL)
+      return false;
+
+   file_info_t info;
+   if (!get_handle_info(fileno(file), &info) || info.size == 0) {
+      fclose(file);
+      return false;
+   }
+
+   void *data LOCAL = xmalloc(info.size);
+   const bool ok = fread(data, info.size, 1, file) == 1;
+   fclose(file);
+
+   if (!ok)
+      return false;
+
+   code_blob_t *blob = code_blob_new(state->code, f->name, info.size);
+   if (blob == NULL)
+      return false;
+
+   blob->resolve     = cache_resolve;
+   blob->resolve_ctx = f;
+
+   const bool loaded = code_load_object(blob, data, info.size);
+   const bool stale = blob->unresolved;
+   code_blob_finalise(blob, &(f->entry));
+
+   if (!loaded && !stale)
+      return false;   // Code cache is full but the entry is still valid
+   else if (stale) {
+      // The object refers to a symbol which no longer exists so delete
+      // it and generate the code again
+      if (opt_get_int(OPT_JIT_LOG))
+         debugf("discarding stale cache entry %s for %s", path,
+                istr(f->name));
+
+      remove(path);
+      return false;
+   }
+
+   if (opt_get_int(OPT_JIT_LOG))
+      debugf("%s loaded from %s", istr(f->name), path);
+
+   return true;
+}
+
+static void cache_store(const char *path, const void *data, size_t size)
+{
+   const char *dir = opt_get_str(OPT_JIT_CACHE);
+
+#ifdef __MINGW32__
+   (void)_mkdir(dir);
+#else
+   (void)mkdir(dir, 0777);
+#endif
+
+   // Write to a temporary file first so concurrent runs never see a
+   // partially written object
+   char *tmp LOCAL = xasprintf("%s.%d", path, getpid());
+
+   FILE *file = fopen(tmp, "wb");
+   if (file == NULL)
+      return;
+
+   const bool ok = fwrite(data, size, 1, file) == 1;
+
+   if (fclose(file) != 0 || !ok || rename(tmp, path) != 0)
+      remove(tmp);
+}
+
+static char *cache_path(jit_func_t *f)
+{
+   const char *dir = opt_get_str(OPT_JIT_CACHE);
+   if (dir == NULL)
+      return NULL;
+
+   char hex[SHA_HEX_LEN];
+   if (!cache_key(f, hex))
+      return NULL;
+
+   return xasprintf("%s/%s.o", dir, hex);
+}
+
+static bool jit_llvm_probe(jit_t *j, jit_handle_t handle, void *context)
+{
+   llvm_jit_state_t *state = context;
+
+   jit_func_t *f = jit_get_func(j, handle);
+   if (f->entry != jit_interp)
+      return false;
+
+   char *path LOCAL = cache_path(f);
+   if (path == NULL)
+      return false;
+
+   return cache_load(state, f, path);
+}
+
 static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
 {
    llvm_jit_state_t *state = context;
@@ -3168,12 +3635,17 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
 
    const uint64_t start_us = get_timestamp_us();
 
+   char *path LOCAL = cache_path(f);
+   if (path != NULL && cache_load(state, f, path))
+      return;
+
    LLVMTargetMachineRef tm = llvm_target_machine(LLVMRelocStatic,
                                                  JIT_CODE_MODEL);
 
    llvm_obj_t obj = {
-      .context = LLVMContextCreate(),
-      .target  = tm,
+      .context     = LLVMContextCreate(),
+      .target      = tm,
+      .relocatable = (path != NULL),
    };
 
    LOCAL_TEXT_BUF tb = tb_new();
@@ -3199,6 +3671,9 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
    if (obj.fns[LLVM_TLAB_ALLOC] != NULL)
       cgen_tlab_alloc_body(&obj);
 
+   if (obj.fns[LLVM_CARD_MARK] != NULL)
+      cgen_card_mark_body(&obj);
+
    for (jit_size_t sz = JIT_SZ_8; sz <= JIT_SZ_64; sz++) {
       if (obj.fns[LLVM_EXP_OVERFLOW_S8 + sz] != NULL)
          cgen_exp_overflow_body(&obj, LLVM_EXP_OVERFLOW_S8 + sz, sz,
@@ -3218,7 +3693,12 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
 
    llvm_dump_module(obj.module, "initial");
    llvm_verify_module(obj.module);
-   llvm_optimise(obj.module, obj.target, obj.opt_hint > 0 ? LLVM_O1 : LLVM_O0);
+
+   llvm_opt_level_t olevel = obj.opt_hint > 0 ? LLVM_O1 : LLVM_O0;
+   if (f->profiled)
+      olevel = LLVM_O3;   // Known hot from a previous run
+
+   llvm_optimise(obj.module, obj.target, olevel);
    llvm_dump_module(obj.module, "final");
 
    if (jit_is_shutdown(f->jit))
@@ -3235,6 +3715,9 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
 
    const size_t objsz = LLVMGetBufferSize(buf);
 
+   if (path != NULL)
+      cache_store(path, LLVMGetBufferStart(buf), objsz);
+
    code_blob_t *blob = code_blob_new(state->code, f->name, objsz);
    if (blob == NULL)
       return;
@@ -3242,6 +3725,11 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
    const uint8_t *base = blob->wptr;
    const void *entry_addr = blob->wptr;
 
+   if (obj.relocatable) {
+      blob->resolve     = cache_resolve;
+      blob->resolve_ctx = f;
+   }
+
    code_load_object(blob, LLVMGetBufferStart(buf), objsz);
 
    const size_t size = blob->wptr - base;
@@ -3275,6 +3763,7 @@ static void jit_llvm_cleanup(void *context)
 static const jit_plugin_t jit_llvm = {
    .init    = jit_llvm_init,
    .cgen    = jit_llvm_cgen,
+   .probe   = jit_llvm_probe,
    .cleanup = jit_llvm_cleanup
 };
 
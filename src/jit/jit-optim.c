@@ -1244,6 +1244,8 @@ static bool try_promote_allocation(jit_func_t *f, jit_ir_t *alloc)
          else
             last = i;
       }
+      else if (ir->op == MACRO_BARRIER && get_value_reg(ir->arg1) == reg)
+         continue;   // Stack slot can never be in the heap
       else if (get_value_reg(ir->arg1) == reg)
          return false;
       else if (get_value_reg(ir->arg2) == reg)
@@ -1269,6 +1271,15 @@ static bool try_promote_allocation(jit_func_t *f, jit_ir_t *alloc)
       }
    }
 
+   for (int i = 0; i < f->nirs; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == MACRO_BARRIER && get_value_reg(ir->arg1) == reg) {
+         ir->op        = J_NOP;
+         ir->arg1.kind = JIT_VALUE_INVALID;
+         ir->arg2.kind = JIT_VALUE_INVALID;
+      }
+   }
+
    alloc->op        = J_NOP;
    alloc->size      = JIT_SZ_UNSPEC;
    alloc->cc        = JIT_CC_NONE;
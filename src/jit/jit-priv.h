@@ -88,6 +88,7 @@ typedef enum {
    MACRO_UNPACK,
    MACRO_VEC2OP,
    MACRO_VEC4OP,
+   MACRO_BARRIER,
 } jit_op_t;
 
 typedef enum {
@@ -177,6 +178,7 @@ typedef enum {
    JIT_EXIT_SCHED_INACTIVE,
    JIT_EXIT_GET_COUNTERS,
    JIT_EXIT_SCHED_ACTIVE,
+   JIT_EXIT_SCHED_DELTA,
 } jit_exit_t;
 
 typedef uint16_t jit_reg_t;
@@ -340,6 +342,8 @@ typedef struct _jit_func {
    unsigned        cpoolsz;
    jit_handle_t    handle;
    unsigned        hotness;
+   bool            hot;
+   bool            profiled;
    jit_tier_t     *next_tier;
    ffi_spec_t      spec;
    object_t       *object;
@@ -370,14 +374,19 @@ typedef struct _code_cache code_cache_t;
 typedef struct _code_span code_span_t;
 typedef struct _patch_list patch_list_t;
 
+typedef void *(*code_resolve_fn_t)(const char *, void *);
+
 typedef struct {
-   code_span_t  *span;
-   jit_func_t   *func;
-   uint8_t      *wptr;
-   ihash_t      *labels;
-   patch_list_t *patches;
-   uint8_t      *veneers;
-   bool          overflow;
+   code_span_t       *span;
+   jit_func_t        *func;
+   uint8_t           *wptr;
+   ihash_t           *labels;
+   patch_list_t      *patches;
+   uint8_t           *veneers;
+   bool               overflow;
+   bool               unresolved;
+   code_resolve_fn_t  resolve;
+   void              *resolve_ctx;
 } code_blob_t;
 
 #define JIT_MAX_ARGS 64
@@ -444,7 +453,7 @@ void code_blob_align(code_blob_t *blob, unsigned align);
 void code_blob_finalise(code_blob_t *blob, jit_entry_fn_t *entry);
 void code_blob_mark(code_blob_t *blob, jit_label_t label);
 void code_blob_patch(code_blob_t *blob, jit_label_t label, code_patch_fn_t fn);
-void code_load_object(code_blob_t *blob, const void *data, size_t size);
+bool code_load_object(code_blob_t *blob, const void *data, size_t size);
 
 #ifdef DEBUG
 __attribute__((format(printf, 2, 3)))
@@ -470,6 +479,7 @@ DLLEXPORT void __nvc_pack(const uint8_t *src, int32_t size, jit_scalar_t *args);
 DLLEXPORT void __nvc_unpack(jit_scalar_t aval, jit_scalar_t bval,
                             jit_scalar_t *args);
 DLLEXPORT void *__nvc_mspace_alloc(uintptr_t size, jit_anchor_t *anchor);
+DLLEXPORT void __nvc_write_barrier(void *ptr, uintptr_t size);
 DLLEXPORT void _debug_out(intptr_t val, int32_t reg);
 
 #endif  // _JIT_PRIV_H
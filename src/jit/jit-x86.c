@@ -38,6 +38,7 @@ typedef enum {
    TLAB_STUB,
    FEXP_STUB,
    ROUND_STUB,
+   BARRIER_STUB,
 
    NUM_STUBS
 } jit_x86_stub_t;
@@ -558,6 +559,19 @@ static void asm_mov(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
          }
          x86_imm32(&insn, src.imm);
          break;
+      case __BYTE:
+         x86_rex(&insn, size, 0, dst.addr.reg, 0);
+         x86_opcode(&insn, 0xc6);
+         if (is_imm8(dst.addr.off)) {
+            x86_modrm(&insn, 1, 0, dst.addr.reg);
+            x86_imm8(&insn, dst.addr.off);
+         }
+         else {
+            x86_modrm(&insn, 2, 0, dst.addr.reg);
+            x86_imm32(&insn, dst.addr.off);
+         }
+         x86_imm8(&insn, src.imm);
+         break;
       default:
          fatal_trace("unhandled immediate size %d in asm_mov", size);
       }
@@ -1924,6 +1938,48 @@ static void jit_x86_macro_galloc(code_blob_t *blob, jit_x86_state_t *state,
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
 
+static void jit_x86_card_mark(code_blob_t *blob, jit_label_t skip)
+{
+   // Pointer in EAX, clobbers ECX
+   MOV(__ECX, ADDR(TLAB_REG, offsetof(tlab_t, heap)), __QWORD);
+   SUB(__EAX, __ECX, __QWORD);
+   CMP(ADDR(TLAB_REG, offsetof(tlab_t, heapsize)), __EAX, __QWORD);
+   JBE(PATCH(0));                 // Outside generational heap
+   code_blob_patch(blob, skip, jit_x86_patch);
+   MOV(__ECX, ADDR(TLAB_REG, offsetof(tlab_t, cards)), __QWORD);
+   SAR(__EAX, IMM(MSPACE_CARD_SHIFT), __QWORD);
+   ADD(__ECX, __EAX, __QWORD);
+   MOV(ADDR(__ECX, 0), IMM(1), __BYTE);
+   code_blob_mark(blob, skip);
+}
+
+static void jit_x86_macro_barrier(code_blob_t *blob, jit_x86_state_t *state,
+                                  jit_ir_t *ir, const phys_slot_t *slots)
+{
+   if (ir->arg2.kind == JIT_VALUE_INT64
+       && ir->arg2.int64 <= (1 << MSPACE_CARD_SHIFT)) {
+      // Spans at most two cards so mark the first and last inline
+      // using local labels numbered after the last IR
+      const int this = ir - blob->func->irbuf;
+      const jit_label_t label = blob->func->nirs + 2 * this;
+
+      jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
+      jit_x86_card_mark(blob, label);
+
+      if (ir->arg2.int64 > sizeof(void *)) {
+         jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
+         ADD(__EAX, IMM(ir->arg2.int64 - 1), __QWORD);
+         jit_x86_card_mark(blob, label + 1);
+      }
+   }
+   else {
+      jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
+      jit_x86_get_copy(blob, __ECX, ir->arg2, slots);
+
+      CALL(PTR(state->stubs[BARRIER_STUB]));
+   }
+}
+
 static void jit_x86_macro_bzero(code_blob_t *blob, jit_ir_t *ir,
                                 const phys_slot_t *slots)
 {
@@ -2238,6 +2294,9 @@ static void jit_x86_op(code_blob_t *blob, jit_x86_state_t *state, jit_ir_t *ir,
    case MACRO_TRIM:
       jit_x86_macro_trim(blob, ir);
       break;
+   case MACRO_BARRIER:
+      jit_x86_macro_barrier(blob, state, ir, slots);
+      break;
    default:
       jit_dump_with_mark(blob->func, ir - blob->func->irbuf);
       fatal_trace("unhandled opcode %s in x86 backend", jit_op_name(ir->op));
@@ -2433,6 +2492,30 @@ static void jit_x86_gen_alloc_stub(jit_x86_state_t *state)
    code_blob_finalise(blob, &(state->stubs[ALLOC_STUB]));
 }
 
+static void jit_x86_gen_barrier_stub(jit_x86_state_t *state)
+{
+   ident_t name = ident_new("barrier stub");
+   code_blob_t *blob = code_blob_new(state->code, name, 0);
+
+   SUB(__ESP, IMM(8), __QWORD);   // Ensure stack aligned
+
+   jit_x86_push_call_clobbered(blob);
+
+   // Pointer in EAX and size in ECX
+   MOV(CARG1_REG, __ECX, __QWORD);
+   MOV(CARG0_REG, __EAX, __QWORD);
+
+   MOV(__EAX, PTR(__nvc_write_barrier), __QWORD);
+   CALL(__EAX);
+
+   jit_x86_pop_call_clobbered(blob);
+
+   ADD(__ESP, IMM(8), __QWORD);
+   RET();
+
+   code_blob_finalise(blob, &(state->stubs[BARRIER_STUB]));
+}
+
 static void jit_x86_gen_tlab_stub(jit_x86_state_t *state)
 {
    ident_t name = ident_new("tlab stub");
@@ -2549,6 +2632,7 @@ static void *jit_x86_init(jit_t *jit)
    jit_x86_gen_call_stub(state);
    jit_x86_gen_alloc_stub(state);
    jit_x86_gen_tlab_stub(state);
+   jit_x86_gen_barrier_stub(state);
    jit_x86_gen_fexp_stub(state);
    DEBUG_ONLY(jit_x86_gen_debug_stub(state));
 
@@ -27,6 +27,7 @@
 #include "tree.h"
 #include "vlog/vlog-node.h"
 #include "vlog/vlog-util.h"
+#include "thirdparty/sha1.h"
 
 #include <assert.h>
 #include <limits.h>
@@ -46,8 +47,10 @@ typedef struct _search_path search_path_t;
 typedef struct _lib_index   lib_index_t;
 typedef struct _lib_list    lib_list_t;
 typedef struct _lib_unit    lib_unit_t;
+typedef struct _lib_source  lib_source_t;
 
-#define INDEX_FILE_MAGIC 0x55225511
+#define INDEX_FILE_MAGIC   0x55225511
+#define SOURCES_FILE_MAGIC 0x55225512
 
 struct _lib_unit {
    object_t     *object;
@@ -66,12 +69,33 @@ struct _lib_index {
    lib_index_t *next;
 };
 
+typedef struct {
+   ident_t  name;
+   uint32_t checksum;
+} lib_hash_t;
+
+typedef A(lib_hash_t) hash_list_t;
+
+// Record of the design units produced by analysing a source file used
+// to skip analysis when neither the file nor its dependencies changed
+struct _lib_source {
+   ident_t       path;
+   char          hash[SHA_HEX_LEN];
+   uint32_t      options;
+   hash_list_t   units;
+   hash_list_t   deps;
+   lib_source_t *next;
+   bool          touched;
+};
+
 struct _lib {
    char         *path;
    ident_t       name;
    ghash_t      *lookup;
    lib_unit_t   *units;
    lib_index_t  *index;
+   lib_source_t *sources;
+   bool          sources_valid;
    uint64_t      index_mtime;
    off_t         index_size;
    int           lock_fd;
@@ -94,6 +118,7 @@ static lib_list_t    *loaded = NULL;
 static search_path_t *search_paths = NULL;
 
 static text_buf_t *lib_file_path(lib_t lib, const char *name);
+static void lib_free_sources(lib_t lib);
 
 static const char *standard_suffix(vhdl_standard_t std)
 {
@@ -743,6 +768,8 @@ void lib_free(lib_t lib)
    }
    ghash_free(lib->lookup);
 
+   lib_free_sources(lib);
+
    free(lib->path);
    free(lib);
 }
@@ -1058,6 +1085,315 @@ ident_t lib_name(lib_t lib)
    return lib->name;
 }
 
+static void lib_free_sources(lib_t lib)
+{
+   for (lib_source_t *it = lib->sources, *tmp; it; it = tmp) {
+      tmp = it->next;
+      ACLEAR(it->units);
+      ACLEAR(it->deps);
+      free(it);
+   }
+
+   lib->sources = NULL;
+   lib->sources_valid = false;
+}
+
+static void lib_read_hash_list(fbuf_t *f, ident_rd_ctx_t ictx,
+                               hash_list_t *list)
+{
+   const int count = read_u32(f);
+   for (int i = 0; i < count; i++) {
+      lib_hash_t h = { .name = ident_read(ictx) };
+      h.checksum = read_u32(f);
+      APUSH(*list, h);
+   }
+}
+
+static void lib_write_hash_list(fbuf_t *f, ident_wr_ctx_t ictx,
+                                const hash_list_t *list)
+{
+   write_u32(list->count, f);
+   for (int i = 0; i < list->count; i++) {
+      ident_write(list->items[i].name, ictx);
+      write_u32(list->items[i].checksum, f);
+   }
+}
+
+static void lib_read_sources(lib_t lib)
+{
+   lib_free_sources(lib);
+   lib->sources_valid = true;
+
+   fbuf_t *f = lib_fbuf_open(lib, "_sources", FBUF_IN, FBUF_CS_NONE);
+   if (f == NULL)
+      return;
+
+   if (read_u32(f) != SOURCES_FILE_MAGIC) {
+      fbuf_close(f, NULL);
+      return;   // Analyse everything again
+   }
+
+   ident_rd_ctx_t ictx = ident_read_begin(f);
+   lib_source_t **tail = &(lib->sources);
+
+   const int count = read_u32(f);
+   for (int i = 0; i < count; i++) {
+      lib_source_t *s = xcalloc(sizeof(lib_source_t));
+      s->path = ident_read(ictx);
+      read_raw(s->hash, SHA_HEX_LEN, f);
+      s->options = read_u32(f);
+      lib_read_hash_list(f, ictx, &s->units);
+      lib_read_hash_list(f, ictx, &s->deps);
+
+      *tail = s;
+      tail = &(s->next);
+   }
+
+   ident_read_end(ictx);
+   fbuf_close(f, NULL);
+}
+
+static void lib_write_sources(lib_t lib)
+{
+   fbuf_t *f = lib_fbuf_open(lib, "_sources", FBUF_OUT, FBUF_CS_NONE);
+   if (f == NULL)
+      fatal_errno("failed to create library %s source list",
+                  istr(lib->name));
+
+   write_u32(SOURCES_FILE_MAGIC, f);
+
+   ident_wr_ctx_t ictx = ident_write_begin(f);
+
+   int count = 0;
+   for (lib_source_t *it = lib->sources; it; it = it->next)
+      count++;
+
+   write_u32(count, f);
+   for (lib_source_t *it = lib->sources; it; it = it->next) {
+      ident_write(it->path, ictx);
+      write_raw(it->hash, SHA_HEX_LEN, f);
+      write_u32(it->options, f);
+      lib_write_hash_list(f, ictx, &it->units);
+      lib_write_hash_list(f, ictx, &it->deps);
+   }
+
+   ident_write_end(ictx);
+   fbuf_close(f, NULL);
+}
+
+static bool lib_file_hash(const char *path, char hex[SHA_HEX_LEN])
+{
+   int fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return false;
+
+   file_info_t info;
+   if (!get_handle_info(fd, &info) || info.type != FILE_REGULAR) {
+      close(fd);
+      return false;
+   }
+
+   SHA1_CTX ctx;
+   SHA1Init(&ctx);
+
+   if (info.size > 0) {
+      void *map = map_file(fd, info.size);
+      SHA1Update(&ctx, map, info.size);
+      unmap_file(map, info.size);
+   }
+
+   close(fd);
+
+   unsigned char hash[SHA1_LEN];
+   SHA1Final(hash, &ctx);
+
+   for (int i = 0; i < SHA1_LEN; i++)
+      checked_sprintf(hex + i * 2, 3, "%02x", hash[i]);
+
+   return true;
+}
+
+static uint32_t lib_source_options(void)
+{
+   // Options which change the result of analysing the same source
+   return standard()
+      | opt_get_int(OPT_RELAXED) << 4
+      | opt_get_int(OPT_PSL_COMMENTS) << 5
+      | opt_get_int(OPT_CHECK_SYNTHESIS) << 6
+      | opt_get_int(OPT_PRESERVE_CASE) << 7
+      | opt_get_int(OPT_BOOTSTRAP) << 8;
+}
+
+static lib_source_t *lib_find_source(lib_t lib, ident_t path)
+{
+   for (lib_source_t *it = lib->sources; it; it = it->next) {
+      if (it->path == path)
+         return it;
+   }
+
+   return NULL;
+}
+
+static bool lib_unit_checksum(lib_t lib, ident_t name, uint32_t *checksum)
+{
+   lib_unit_t *lu = ghash_get(lib->lookup, name);
+   if (lu != NULL) {
+      if (lu->dirty)
+         return false;
+
+      *checksum = arena_checksum(object_arena(lu->object));
+      return true;
+   }
+   else if (lib->path == NULL || lib_find_in_index(lib, name) == NULL)
+      return false;
+
+   // Read the checksum stored in the unit file rather than loading it
+   // as that fails if any of its own dependencies have changed
+   LOCAL_TEXT_BUF tb = tb_new();
+   lib_encode_file_name(name, tb);
+
+   LOCAL_TEXT_BUF path = lib_file_path(lib, tb_get(tb));
+   return fbuf_read_checksum(tb_get(path), FBUF_CS_ADLER32, checksum);
+}
+
+static bool lib_dep_unchanged(const lib_hash_t *dep)
+{
+   lib_t dlib = lib_find(ident_until(dep->name, '.'));
+   if (dlib == NULL)
+      return false;
+
+   uint32_t checksum;
+   return lib_unit_checksum(dlib, dep->name, &checksum)
+      && checksum == dep->checksum;
+}
+
+bool lib_source_unchanged(lib_t lib, const char *file)
+{
+   assert(lib != NULL);
+
+   if (lib->path == NULL)
+      return false;
+
+   if (!lib->sources_valid) {
+      file_read_lock(lib->lock_fd);
+      lib_read_sources(lib);
+      file_unlock(lib->lock_fd);
+   }
+
+   lib_source_t *s = lib_find_source(lib, ident_new(file));
+   if (s == NULL || s->units.count == 0)
+      return false;
+   else if (s->options != lib_source_options())
+      return false;
+
+   char hash[SHA_HEX_LEN];
+   if (!lib_file_hash(file, hash) || strcmp(hash, s->hash) != 0)
+      return false;
+
+   for (int i = 0; i < s->units.count; i++) {
+      ident_t name = s->units.items[i].name;
+      if (lib_find_in_index(lib, name) == NULL)
+         return false;
+
+      lib_unit_t *lu = ghash_get(lib->lookup, name);
+      if (lu != NULL && lu->dirty)
+         return false;
+   }
+
+   for (int i = 0; i < s->deps.count; i++) {
+      if (!lib_dep_unchanged(&(s->deps.items[i])))
+         return false;
+   }
+
+   return true;
+}
+
+static void lib_record_dep_cb(object_t *obj, void *ctx)
+{
+   lib_source_t *s = ctx;
+   ident_t name = object_ident(obj) ?: ident_new("???");
+
+   for (int i = 0; i < s->units.count; i++) {
+      if (s->units.items[i].name == name)
+         return;   // Produced by the same file
+   }
+
+   for (int i = 0; i < s->deps.count; i++) {
+      if (s->deps.items[i].name == name)
+         return;
+   }
+
+   lib_hash_t h = {
+      .name = name,
+      .checksum = arena_checksum(object_arena(obj))
+   };
+   APUSH(s->deps, h);
+}
+
+static bool lib_forget_source(lib_t lib, lib_unit_t *unit)
+{
+   // A unit belongs to the last file it was analysed from
+   bool changed = false;
+   for (lib_source_t *it = lib->sources; it; it = it->next) {
+      for (int i = 0; i < it->units.count; i++) {
+         if (it->units.items[i].name == unit->name) {
+            it->units.items[i] = it->units.items[--it->units.count];
+            changed = true;
+            break;
+         }
+      }
+   }
+
+   return changed;
+}
+
+static bool lib_record_source(lib_t lib, lib_unit_t *unit)
+{
+   if (tree_from_object(unit->object) == NULL)
+      return false;   // Verilog units are not tracked
+
+   ident_t path = ident_new(loc_file_str(&(unit->object->loc)));
+
+   lib_forget_source(lib, unit);
+
+   lib_source_t *s = lib_find_source(lib, path);
+   if (s == NULL) {
+      s = xcalloc(sizeof(lib_source_t));
+      s->path = path;
+      s->next = lib->sources;
+      lib->sources = s;
+   }
+
+   if (!s->touched) {
+      if (!lib_file_hash(istr(path), s->hash)) {
+         ACLEAR(s->units);
+         ACLEAR(s->deps);
+         return true;
+      }
+
+      s->options = lib_source_options();
+      s->touched = true;
+      ACLEAR(s->units);
+      ACLEAR(s->deps);
+   }
+
+   object_arena_t *arena = object_arena(unit->object);
+
+   lib_hash_t h = { .name = unit->name, .checksum = arena_checksum(arena) };
+   APUSH(s->units, h);
+
+   // Remove any dependency on a unit from the same file added earlier
+   for (int i = 0; i < s->deps.count; i++) {
+      if (s->deps.items[i].name == unit->name) {
+         s->deps.items[i] = s->deps.items[--s->deps.count];
+         break;
+      }
+   }
+
+   arena_walk_deps(arena, lib_record_dep_cb, s);
+   return true;
+}
+
 static void lib_save_unit(lib_t lib, lib_unit_t *unit)
 {
    LOCAL_TEXT_BUF tb = tb_new();
@@ -1067,6 +1403,11 @@ static void lib_save_unit(lib_t lib, lib_unit_t *unit)
    if (f == NULL)
       fatal("failed to create %s in library %s", tb_get(tb), istr(lib->name));
 
+   // Design units are stored uncompressed by default so they can be
+   // read directly from a memory mapping when loaded
+   if (!opt_get_int(OPT_LIB_COMPRESS))
+      fbuf_set_zip(f, FBUF_ZIP_NONE);
+
    write_u8('T', f);
 
    ident_wr_ctx_t ident_ctx = ident_write_begin(f);
@@ -1114,6 +1455,12 @@ void lib_save(lib_t lib)
 
    freeze_global_arena();
 
+   // Re-read the source list while holding the lock as other processes
+   // may have updated it
+   const bool incremental = opt_get_int(OPT_INCREMENTAL);
+   lib_read_sources(lib);
+
+   bool sources_changed = false;
    for (lib_unit_t *lu = lib->units; lu; lu = lu->next) {
       if (lu->dirty) {
          if (lu->error)
@@ -1123,10 +1470,24 @@ void lib_save(lib_t lib)
             arena_walk_obsolete_deps(object_arena(lu->object),
                                      lib_obsolete_cb, lu);
             lib_save_unit(lib, lu);
+
+            // Units analysed without --incremental are removed from
+            // the source list so a later incremental run does not
+            // skip the file they came from based on a stale record
+            if (incremental)
+               sources_changed |= lib_record_source(lib, lu);
+            else
+               sources_changed |= lib_forget_source(lib, lu);
          }
       }
    }
 
+   if (sources_changed)
+      lib_write_sources(lib);
+
+   for (lib_source_t *it = lib->sources; it; it = it->next)
+      it->touched = false;
+
    LOCAL_TEXT_BUF index_path = lib_file_path(lib, "_index");
    file_info_t info;
    if (get_file_info(tb_get(index_path), &info)) {
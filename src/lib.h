@@ -65,6 +65,7 @@ tree_t lib_get_qualified(ident_t qual);
 timestamp_t lib_get_mtime(lib_t lib, ident_t ident);
 object_t *lib_load_handler(ident_t qual);
 bool lib_had_errors(lib_t lib, ident_t ident);
+bool lib_source_unchanged(lib_t lib, const char *file);
 unsigned lib_index_size(lib_t lib);
 
 typedef void (*lib_index_fn_t)(lib_t lib, ident_t ident, int kind, void *ctx);
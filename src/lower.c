@@ -13213,6 +13213,17 @@ void unit_registry_defer2(unit_registry_t *ur, ident_t name,
    mir_defer(ur->mir, name, parent ? parent->name : NULL, kind, fn, object);
 }
 
+void unit_registry_walk(unit_registry_t *ur, unit_walk_fn_t fn, void *ctx)
+{
+   // Deferred units have not been lowered yet and are skipped
+   const void *key;
+   void *value;
+   for (hash_iter_t it = HASH_BEGIN; hash_iter(ur->map, &it, &key, &value); ) {
+      if (pointer_tag(value) != UNIT_DEFERRED)
+         (*fn)((ident_t)key, ctx);
+   }
+}
+
 void unit_registry_import(unit_registry_t *ur, vcode_unit_t vu)
 {
    mir_unit_t *mu = mir_import(ur->mir, vu);
@@ -29,6 +29,7 @@ typedef int32_t vcode_stamp_t;
 
 typedef void (*lower_fn_t)(lower_unit_t *, object_t *);
 typedef vcode_unit_t (*emit_fn_t)(ident_t, object_t *, vcode_unit_t);
+typedef void (*unit_walk_fn_t)(ident_t, void *);
 
 typedef A(vcode_var_t) var_list_t;
 
@@ -68,6 +69,7 @@ void unit_registry_finalise(unit_registry_t *ur, lower_unit_t *lu);
 void unit_registry_flush(unit_registry_t *ur, ident_t name);
 vcode_unit_t unit_registry_get_parent(unit_registry_t *ur, ident_t name);
 void unit_registry_import(unit_registry_t *ur, vcode_unit_t vu);
+void unit_registry_walk(unit_registry_t *ur, unit_walk_fn_t fn, void *ctx);
 
 lower_unit_t *lower_unit_new(unit_registry_t *ur, lower_unit_t *parent,
                              vcode_unit_t vunit, cover_data_t *cover,
@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "common.h"
 #include "diag.h"
 #include "hash.h"
@@ -30,10 +31,19 @@
 #include <string.h>
 #include <ctype.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifndef __MINGW32__
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char **environ;
+#endif
+
 typedef enum {
    MAKE_TREE,
    MAKE_LIB,
@@ -418,3 +428,345 @@ void make(tree_t *targets, int count, FILE *out)
    hash_free(rule_map);
    rule_map = NULL;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// Parallel analysis
+
+typedef enum {
+   JOB_PENDING,
+   JOB_RUNNING,
+   JOB_DONE,
+   JOB_FAILED,
+} job_state_t;
+
+typedef struct {
+   const char    *file;
+   ident_list_t  *defines;
+   ident_list_t  *uses;
+   bool           barrier;
+   A(int)         deps;
+   job_state_t    state;
+   pid_t          pid;
+} analyse_job_t;
+
+typedef struct {
+   const char *p;
+   const char *end;
+   ident_t     ident;
+} scan_state_t;
+
+typedef enum {
+   SCAN_EOF, SCAN_ID, SCAN_DOT, SCAN_OTHER
+} scan_tok_t;
+
+static scan_tok_t make_scan_token(scan_state_t *s)
+{
+   // Just enough of the VHDL lexical rules to find library unit
+   // headers and selected names in the work library
+
+   while (s->p < s->end) {
+      const char ch = *s->p;
+      if (isspace_iso88591(ch))
+         s->p++;
+      else if (ch == '-' && s->p + 1 < s->end && s->p[1] == '-') {
+         while (s->p < s->end && *s->p != '\n')
+            s->p++;
+      }
+      else if (ch == '/' && s->p + 1 < s->end && s->p[1] == '*') {
+         for (s->p += 2; s->p + 1 < s->end; s->p++) {
+            if (s->p[0] == '*' && s->p[1] == '/')
+               break;
+         }
+         s->p += 2;
+      }
+      else
+         break;
+   }
+
+   if (s->p >= s->end)
+      return SCAN_EOF;
+
+   const char ch = *s->p;
+   if (isalpha_iso88591(ch)) {
+      LOCAL_TEXT_BUF tb = tb_new();
+      while (s->p < s->end && (isalnum_iso88591(*s->p) || *s->p == '_'))
+         tb_append(tb, toupper_iso88591(*s->p++));
+
+      s->ident = ident_new(tb_get(tb));
+      return SCAN_ID;
+   }
+   else if (ch == '\\') {
+      const char *start = s->p++;
+      while (s->p < s->end && *s->p != '\\' && *s->p != '\n')
+         s->p++;
+
+      s->p++;
+      s->ident = ident_new_n(start, s->p - start);
+      return SCAN_ID;
+   }
+   else if (ch == '"') {
+      for (s->p++; s->p < s->end && *s->p != '"' && *s->p != '\n'; s->p++)
+         ;
+      s->p++;
+      return SCAN_OTHER;
+   }
+   else if (ch == '\'' && s->p + 2 < s->end && s->p[2] == '\'') {
+      s->p += 3;   // Character literal
+      return SCAN_OTHER;
+   }
+   else if (isdigit_iso88591(ch)) {
+      while (s->p < s->end && (isalnum_iso88591(*s->p) || *s->p == '_'
+                               || *s->p == '.' || *s->p == '#'))
+         s->p++;
+      return SCAN_OTHER;
+   }
+
+   s->p++;
+   return ch == '.' ? SCAN_DOT : SCAN_OTHER;
+}
+
+static bool make_scan_file(analyse_job_t *job, ident_t work_name)
+{
+   if (strcmp(job->file, "-") == 0)
+      return false;
+
+   // Same rules as input_from_file for detecting the source language
+   const size_t len = strlen(job->file);
+   if ((len > 2 && strcmp(job->file + len - 2, ".v") == 0)
+       || (len > 3 && strcmp(job->file + len - 3, ".sv") == 0)
+       || (len > 4 && strcmp(job->file + len - 4, ".sdf") == 0))
+      return false;
+
+   int fd = open(job->file, O_RDONLY);
+   if (fd < 0)
+      return false;   // Error will be reported during analysis
+
+   file_info_t info;
+   if (!get_handle_info(fd, &info) || info.type != FILE_REGULAR) {
+      close(fd);
+      return false;
+   }
+
+   if (info.size == 0) {
+      close(fd);
+      return true;
+   }
+
+   char *map = map_file(fd, info.size);
+   close(fd);
+
+   ident_t id_entity = ident_new("ENTITY");
+   ident_t id_architecture = ident_new("ARCHITECTURE");
+   ident_t id_package = ident_new("PACKAGE");
+   ident_t id_body = ident_new("BODY");
+   ident_t id_configuration = ident_new("CONFIGURATION");
+   ident_t id_context = ident_new("CONTEXT");
+   ident_t id_of = ident_new("OF");
+   ident_t id_is = ident_new("IS");
+   ident_t id_work = ident_new("WORK");
+   ident_t id_all = ident_new("ALL");
+
+   scan_state_t s = { .p = map, .end = map + info.size };
+
+   // Sliding window over the last four tokens
+   scan_tok_t tok[4] = { SCAN_OTHER, SCAN_OTHER, SCAN_OTHER, SCAN_OTHER };
+   ident_t id[4] = {};
+
+   bool use_all = false;
+   do {
+      memmove(tok, tok + 1, sizeof(tok) - sizeof(tok[0]));
+      memmove(id, id + 1, sizeof(id) - sizeof(id[0]));
+
+      tok[3] = make_scan_token(&s);
+      id[3] = tok[3] == SCAN_ID ? s.ident : NULL;
+
+      if (tok[2] == SCAN_ID && tok[3] == SCAN_ID && id[3] == id_is) {
+         // ENTITY name IS / PACKAGE name IS / CONTEXT name IS
+         if (tok[1] == SCAN_ID && (id[1] == id_entity || id[1] == id_package
+                                   || id[1] == id_context))
+            ident_list_add(&job->defines, id[2]);
+      }
+      else if (tok[1] == SCAN_ID && tok[2] == SCAN_ID && tok[3] == SCAN_ID
+               && id[2] == id_of && tok[0] == SCAN_ID) {
+         if (id[0] == id_architecture)
+            ident_list_add(&job->defines, id[3]);
+         else if (id[0] == id_configuration) {
+            ident_list_add(&job->defines, id[1]);
+            ident_list_add(&job->uses, id[3]);
+         }
+      }
+      else if (tok[1] == SCAN_ID && tok[2] == SCAN_ID && tok[3] == SCAN_ID
+               && id[1] == id_package && id[2] == id_body)
+         ident_list_add(&job->defines, id[3]);
+      else if (tok[1] == SCAN_ID && tok[2] == SCAN_DOT && tok[3] == SCAN_ID
+               && (id[1] == id_work || id[1] == work_name)) {
+         if (id[3] == id_all)
+            use_all = true;
+         else
+            ident_list_add(&job->uses, id[3]);
+      }
+   } while (tok[3] != SCAN_EOF);
+
+   unmap_file(map, info.size);
+
+   return !use_all;
+}
+
+static bool make_deps_done(analyse_job_t *jobs, analyse_job_t *job,
+                           int *failed)
+{
+   for (int i = 0; i < job->deps.count; i++) {
+      switch (jobs[job->deps.items[i]].state) {
+      case JOB_DONE:
+         break;
+      case JOB_FAILED:
+         *failed = job->deps.items[i];
+         return false;
+      default:
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static void make_build_graph(analyse_job_t *jobs, int count)
+{
+   // A file depends on the most recent earlier file that defines each
+   // unit it uses or defines: as any file defining a unit also depends
+   // on the previous definition this preserves the ordering between
+   // all earlier definitions of that unit
+
+   hash_t *providers = hash_new(256);
+   int last_barrier = -1;
+
+   for (int i = 0; i < count; i++) {
+      analyse_job_t *job = &(jobs[i]);
+
+      if (job->barrier) {
+         for (int j = 0; j < i; j++)
+            APUSH(job->deps, j);
+         last_barrier = i;
+      }
+      else if (last_barrier != -1)
+         APUSH(job->deps, last_barrier);
+
+      for (int pass = 0; pass < 2; pass++) {
+         ident_list_t *list = pass == 0 ? job->uses : job->defines;
+         for (ident_list_t *it = list; it; it = it->next) {
+            const intptr_t prev = (intptr_t)hash_get(providers, it->ident);
+            if (prev != 0 && prev - 1 != i && prev - 1 > last_barrier)
+               APUSH(job->deps, prev - 1);
+         }
+      }
+
+      for (ident_list_t *it = job->defines; it; it = it->next)
+         hash_put(providers, it->ident, (void *)(intptr_t)(i + 1));
+   }
+
+   hash_free(providers);
+}
+
+#ifndef __MINGW32__
+static pid_t make_start_job(analyse_job_t *job, const char *const *args)
+{
+   // Run a new nvc process for each file rather than forking as the JIT
+   // and garbage collector may already have started threads.  The child
+   // commits its units to the library under the library lock.
+   int nargs = 0;
+   while (args[nargs] != NULL)
+      nargs++;
+
+   char **argv LOCAL = xmalloc_array(nargs + 2, sizeof(char *));
+   memcpy(argv, args, nargs * sizeof(char *));
+   argv[nargs] = (char *)job->file;
+   argv[nargs + 1] = NULL;
+
+   fflush(stdout);
+   fflush(stderr);
+
+   pid_t pid;
+   const int rc = posix_spawn(&pid, argv[0], NULL, NULL, argv, environ);
+   if (rc != 0) {
+      errno = rc;
+      fatal_errno("posix_spawn");
+   }
+
+   return pid;
+}
+#endif
+
+bool make_analyse(const char *const *files, int count, int njobs,
+                  const char *const *args, jit_t *jit, unit_registry_t *ur,
+                  mir_context_t *mc)
+{
+#ifdef __MINGW32__
+   for (int i = 0; i < count; i++)
+      analyse_file(files[i], jit, ur, mc);
+
+   return error_count() == 0;
+#else
+   analyse_job_t *jobs = xcalloc_array(count, sizeof(analyse_job_t));
+
+   ident_t work_name = lib_name(lib_work());
+
+   for (int i = 0; i < count; i++) {
+      jobs[i].file = files[i];
+      jobs[i].barrier = !make_scan_file(&(jobs[i]), work_name);
+   }
+
+   make_build_graph(jobs, count);
+
+   int running = 0, remaining = count;
+   bool success = true;
+   while (remaining > 0) {
+      for (int i = 0; i < count && running < njobs; i++) {
+         if (jobs[i].state != JOB_PENDING)
+            continue;
+
+         int failed = -1;
+         if (make_deps_done(jobs, &(jobs[i]), &failed)) {
+            jobs[i].pid = make_start_job(&(jobs[i]), args);
+            jobs[i].state = JOB_RUNNING;
+            running++;
+         }
+         else if (failed != -1) {
+            // Analysing this file would only produce spurious errors
+            notef("skipping %s which depends on %s", jobs[i].file,
+                  jobs[failed].file);
+            jobs[i].state = JOB_FAILED;
+            success = false;
+            remaining--;
+         }
+      }
+
+      if (running == 0)
+         continue;
+
+      int status;
+      const pid_t pid = waitpid(-1, &status, 0);
+      if (pid < 0)
+         fatal_errno("waitpid");
+
+      for (int i = 0; i < count; i++) {
+         if (jobs[i].state == JOB_RUNNING && jobs[i].pid == pid) {
+            const bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            jobs[i].state = ok ? JOB_DONE : JOB_FAILED;
+            success &= ok;
+            running--;
+            remaining--;
+            break;
+         }
+      }
+   }
+
+   for (int i = 0; i < count; i++) {
+      ident_list_free(jobs[i].defines);
+      ident_list_free(jobs[i].uses);
+      ACLEAR(jobs[i].deps);
+   }
+
+   free(jobs);
+   return success;
+#endif
+}
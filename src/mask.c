@@ -123,6 +123,38 @@ void mask_set_range(bit_mask_t *m, size_t start, size_t count)
    }
 }
 
+bool mask_claim_range(bit_mask_t *m, size_t start, size_t count)
+{
+   // Other threads may concurrently claim disjoint ranges sharing a
+   // word with this one so all updates must be atomic
+   assert(count > 0);
+   assert(start + count <= m->size);
+
+   uint64_t *words = m->size > 64 ? m->ptr : &(m->bits);
+
+   const size_t low = start % 64;
+   const size_t high = MIN(low + count - 1, 63);
+   const uint64_t first = mask_for_range(low, high);
+
+   const uint64_t old =
+      __atomic_fetch_or(&(words[start / 64]), first, __ATOMIC_RELAXED);
+   if (old & (UINT64_C(1) << low))
+      return false;   // Already claimed by another thread
+
+   const size_t nbits = high - low + 1;
+   start += nbits;
+   count -= nbits;
+
+   for (; count >= 64; count -= 64, start += 64)
+      __atomic_store_n(&(words[start / 64]), ~UINT64_C(0), __ATOMIC_RELAXED);
+
+   if (count > 0)
+      __atomic_fetch_or(&(words[start / 64]), mask_for_range(0, count - 1),
+                        __ATOMIC_RELAXED);
+
+   return true;
+}
+
 bool mask_test_range(bit_mask_t *m, size_t start, size_t count)
 {
    if (m->size <= 64)
@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "common.h"
 #include "cov/cov-api.h"
 #include "diag.h"
@@ -58,6 +59,8 @@
 #define GIT_SHA_ONLY(x)
 #endif
 
+typedef A(char *) arg_list_t;
+
 typedef struct {
    jit_t           *jit;
    unit_registry_t *registry;
@@ -71,6 +74,7 @@ typedef struct {
    ident_t          top_level;
    const char      *top_level_arg;
    lib_t            work;
+   arg_list_t       global_args;
 } cmd_state_t;
 
 const char copy_string[] =
@@ -171,8 +175,40 @@ static bool parse_warn_option(char *optarg)
    }
 }
 
-static void do_file_list(const char *file, jit_t *jit, unit_registry_t *ur,
-                         mir_context_t *mc)
+typedef A(char *) file_list_t;
+
+static void push_option(arg_list_t *args, const struct option *long_options,
+                        const char *spec, int c, const char *arg)
+{
+   // Reconstruct an option parsed by getopt_long so it can be passed on
+   // to a child process
+   for (const struct option *o = long_options; o->name != NULL; o++) {
+      if (o->val != c)
+         continue;
+      else if (o->has_arg != no_argument && arg != NULL)
+         APUSH(*args, xasprintf("--%s=%s", o->name, arg));
+      else
+         APUSH(*args, xasprintf("--%s", o->name));
+      return;
+   }
+
+   const char *p = strchr(spec, c);
+   assert(p != NULL);
+
+   if (p[1] == ':')
+      APUSH(*args, xasprintf("-%c%s", c, arg));
+   else
+      APUSH(*args, xasprintf("-%c", c));
+}
+
+static void free_args(arg_list_t *args)
+{
+   for (int i = 0; i < args->count; i++)
+      free(args->items[i]);
+   ACLEAR(*args);
+}
+
+static void do_file_list(const char *file, file_list_t *files)
 {
    FILE *f;
    if (strcmp(file, "-") == 0)
@@ -217,7 +253,7 @@ static void do_file_list(const char *file, jit_t *jit, unit_registry_t *ur,
             tb_append(tb, *p++);
       }
 
-      analyse_file(tb_get(tb), jit, ur, mc);
+      APUSH(*files, xstrdup(tb_get(tb)));
    }
 
    free(line);
@@ -255,16 +291,27 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
       { "keywords",        required_argument, 0, 'k' },
       { "relative",        required_argument, 0, 'r' },
       { "warn",            required_argument, 0, 'W' },
+      { "jobs",            required_argument, 0, 'j' },
+      { "incremental",     no_argument,       0, 'i' },
+      { "verbose",         no_argument,       0, 'V' },
       { 0, 0, 0, 0 }
    };
 
    const int next_cmd = scan_cmd(2, argc, argv);
-   int c, index = 0, error_limit = 20;
+   int c, index = 0, error_limit = 20, jobs = 1;
    const char *file_list = NULL;
    const char *spec = ":D:f:I:W:";
    bool no_save = false, werror = false;
+   arg_list_t job_args = AINIT;
 
    while ((c = getopt_long(next_cmd, argv, spec, long_options, &index)) != -1) {
+      // Options other than the file list are passed on to the processes
+      // started by --jobs, which analyse one file each
+      if (c == 'X')
+         push_option(&job_args, long_options, spec, 'R', NULL);
+      else if (c != 0 && c != '?' && c != ':' && c != 'f' && c != 'j')
+         push_option(&job_args, long_options, spec, c, optarg);
+
       switch (c) {
       case 0:
          // Set a flag
@@ -329,6 +376,16 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
       case 'W':
          werror = parse_warn_option(optarg);
          break;
+      case 'j':
+         if ((jobs = parse_int(optarg)) < 1)
+            fatal("invalid number of jobs '%s'", optarg);
+         break;
+      case 'i':
+         opt_set_int(OPT_INCREMENTAL, 1);
+         break;
+      case 'V':
+         opt_set_int(OPT_VERBOSE, 1);
+         break;
       default:
          should_not_reach_here();
       }
@@ -350,18 +407,52 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
    if (state->vhpi != NULL)
       vhpi_run_callbacks(vhpiCbStartOfAnalysis);
 
+   file_list_t files = AINIT;
+
    if (file_list != NULL)
-      do_file_list(file_list, jit, state->registry, state->mir);
+      do_file_list(file_list, &files);
    else if (optind == next_cmd)
       fatal("missing file name");
 
    for (int i = optind; i < next_cmd; i++) {
       if (argv[i][0] == '@')
-         do_file_list(argv[i] + 1, jit, state->registry, state->mir);
+         do_file_list(argv[i] + 1, &files);
       else
-         analyse_file(argv[i], jit, state->registry, state->mir);
+         APUSH(files, xstrdup(argv[i]));
    }
 
+   LOCAL_TEXT_BUF exe = tb_new();
+
+   bool failed = false;
+   if (jobs > 1 && files.count > 1 && !no_save && get_exe_path(exe)) {
+      arg_list_t args = AINIT;
+      APUSH(args, tb_claim(exe));
+      for (int i = 0; i < state->global_args.count; i++)
+         APUSH(args, xstrdup(state->global_args.items[i]));
+      APUSH(args, xstrdup("-a"));
+      for (int i = 0; i < job_args.count; i++)
+         APUSH(args, xstrdup(job_args.items[i]));
+      APUSH(args, NULL);
+
+      // Units are committed to the library as each file is analysed
+      failed = !make_analyse((const char *const *)files.items, files.count,
+                             jobs, (const char *const *)args.items, jit,
+                             state->registry, state->mir);
+
+      args.count--;   // Terminating NULL
+      free_args(&args);
+   }
+   else {
+      for (int i = 0; i < files.count; i++)
+         analyse_file(files.items[i], jit, state->registry, state->mir);
+   }
+
+   for (int i = 0; i < files.count; i++)
+      free(files.items[i]);
+   ACLEAR(files);
+
+   free_args(&job_args);
+
    if (state->vhpi != NULL)
       vhpi_run_callbacks(vhpiCbEndOfAnalysis);
 
@@ -371,12 +462,15 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
    jit_free(jit);
    set_error_limit(0);
 
-   if (error_count() > 0)
+   if (failed || error_count() > 0)
       return EXIT_FAILURE;
 
    if (!no_save)
       lib_save(state->work);
 
+   // Only units saved by this command are tracked for incremental analysis
+   opt_set_int(OPT_INCREMENTAL, 0);
+
    if (error_count() > 0)
       return EXIT_FAILURE;   // May have errors saving library
 
@@ -495,10 +589,11 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
       { "no-collapse",     no_argument,       0, 'C' },
       { "stats",           no_argument,       0, 'S' },
       { "trace",           no_argument,       0, 't' },
+      { "aot",             no_argument,       0, 'A' },
       { 0, 0, 0, 0 }
    };
 
-   bool no_save = false;
+   bool no_save = false, aot = false;
    unit_meta_t meta = {};
    cover_mask_t cover_mask = 0;
    const char *cover_spec_file = NULL, *sdf_args = NULL;
@@ -557,6 +652,12 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
       case 'S':
          opt_set_int(OPT_ELAB_STATS, 1);
          break;
+      case 'A':
+#ifndef HAVE_LLVM
+         fatal("$bold$--aot$$ requires LLVM support");
+#endif
+         aot = true;
+         break;
       case 0:
          // Set a flag
          break;
@@ -651,6 +752,19 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
       progress("saving library");
    }
 
+   if (aot) {
+      // Populate the JIT cache with native code for every unit in the
+      // design so the run command does not need to generate any
+      char path[PATH_MAX];
+      lib_realpath(state->work, "_NVC_JIT", path, sizeof(path));
+      opt_set_str(OPT_JIT_CACHE, path);
+
+      jit_compile_all(state->jit);
+      opt_set_str(OPT_JIT_CACHE, NULL);
+
+      progress("generating native code");
+   }
+
    if (state->cover != NULL) {
       fbuf_t *f = fbuf_open(meta.cover_file, FBUF_OUT, FBUF_CS_NONE);
       if (f == NULL)
@@ -710,6 +824,16 @@ static ieee_warnings_t parse_ieee_warnings(const char *str)
       fatal("specify 'on', 'off' or 'off-at-0' instead of '%s'", str);
 }
 
+static event_queue_t parse_event_queue(const char *str)
+{
+   if (strcasecmp(str, "heap") == 0)
+      return EVENT_QUEUE_HEAP;
+   else if (strcasecmp(str, "wheel") == 0)
+      return EVENT_QUEUE_WHEEL;
+   else
+      fatal("specify 'heap' or 'wheel' instead of '%s'", str);
+}
+
 static vhdl_severity_t parse_severity(const char *str)
 {
    if (strcasecmp(str, "note") == 0)
@@ -756,6 +880,19 @@ static int parse_stop_delta(const char *str)
       return ival;
 }
 
+static int parse_threads(const char *str)
+{
+   const int ival = parse_int(str);
+   if (ival < 1)
+      fatal("$bold$--threads$$ argument must be greater than zero");
+   else if (ival > MAX_THREADS) {
+      warnf("the maximum number of supported threads is %d", MAX_THREADS);
+      return MAX_THREADS;
+   }
+   else
+      return ival;
+}
+
 static void ctrl_c_handler(void *arg)
 {
    rt_model_t *model = arg;
@@ -846,7 +983,7 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
 {
    static struct option long_options[] = {
       { "trace",         no_argument,       0, 't' },
-      { "profile",       no_argument,       0, 'p' },   // DEPRECATED 1.14
+      { "profile",       optional_argument, 0, 'p' },   // Only --profile=FILE
       { "stop-time",     required_argument, 0, 's' },
       { "stats",         no_argument,       0, 'S' },
       { "wave",          optional_argument, 0, 'w' },
@@ -862,14 +999,21 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
       { "vhpi-trace",    no_argument,       0, 'T' },
       { "gtkw",          optional_argument, 0, 'g' },
       { "shuffle",       no_argument,       0, 'H' },
+      { "threads",       required_argument, 0, 'N' },
+      { "jit-cache",     no_argument,       0, 'J' },
+      { "event-queue",   required_argument, 0, 'Q' },
+      { "wave-async",    no_argument,       0, 'A' },
+      { "jit-profile",   required_argument, 0, 'P' },
       { 0, 0, 0, 0 }
    };
 
    wave_format_t wave_fmt = WAVE_FORMAT_FST;
+   bool          jit_cache = false;
    uint64_t      stop_time = TIME_HIGH;
    const char   *wave_fname = NULL;
    const char   *gtkw_fname = NULL;
    const char   *pli_plugins = NULL;
+   const char   *jit_profile = NULL;
 
    static bool have_run = false;
    if (have_run)
@@ -894,7 +1038,11 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
          opt_set_int(OPT_RT_TRACE, 1);
          break;
       case 'p':
-         warnf("the $bold$--profile$$ option is deprecated and has no effect");
+         if (optarg == NULL)
+            warnf("the $bold$--profile$$ option without a file name is "
+                  "deprecated and has no effect");
+         else
+            opt_set_str(OPT_PROFILE_FILE, optarg);
          break;
       case 'T':
          opt_set_str(OPT_PLI_TRACE, "1");
@@ -969,6 +1117,21 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
                "as non-deterministic behaviour");
          opt_set_int(OPT_SHUFFLE_PROCS, 1);
          break;
+      case 'N':
+         opt_set_int(OPT_RT_THREADS, parse_threads(optarg));
+         break;
+      case 'J':
+         jit_cache = true;
+         break;
+      case 'Q':
+         opt_set_int(OPT_EVENT_QUEUE, parse_event_queue(optarg));
+         break;
+      case 'A':
+         opt_set_int(OPT_WAVE_ASYNC, 1);
+         break;
+      case 'P':
+         jit_profile = optarg;
+         break;
       default:
          should_not_reach_here();
       }
@@ -1033,9 +1196,18 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
    if (state->registry == NULL)
       state->registry = unit_registry_new(state->mir);
 
+   if (jit_cache) {
+      char path[PATH_MAX];
+      lib_realpath(state->work, "_NVC_JIT", path, sizeof(path));
+      opt_set_str(OPT_JIT_CACHE, path);
+   }
+
    if (state->jit == NULL)
       state->jit = get_jit(state);
 
+   if (jit_profile != NULL)
+      jit_load_profile(state->jit, jit_profile);
+
    if (state->model == NULL) {
       state->model = model_new(state->jit, state->cover);
       reheat(top, state->registry, state->mir, state->cover, state->model);
@@ -1065,6 +1237,9 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
 
    model_reset(state->model);
 
+   if (opt_get_int(OPT_JIT_PRECOMPILE))
+      jit_compile_all(state->jit);
+
    if (dumper != NULL)
       wave_dumper_restart(dumper, state->model, state->jit);
 
@@ -1076,6 +1251,9 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
 
    set_ctrl_c_handler(NULL, NULL);
 
+   if (jit_profile != NULL)
+      jit_save_profile(state->jit, jit_profile);
+
    const int rc = model_exit_status(state->model);
 
    if (dumper != NULL)
@@ -1805,6 +1983,37 @@ static int coverage_cmd(int argc, char **argv, cmd_state_t *state)
    return 0;
 }
 
+static fbuf_t *open_coverage_file(const char *file)
+{
+   fbuf_t *f = fbuf_open(file, FBUF_IN, FBUF_CS_NONE);
+   if (f == NULL) {
+      // Attempt to redirect the old file name to the new one
+      // TODO: this should be removed at some point
+      const char *slash = strrchr(file, *DIR_SEP) ?: strrchr(file, '/');
+      if (slash != NULL && slash[1] == '_') {
+         const char *tail = strstr(slash, ".covdb");
+         if (tail != NULL && tail[6] == '\0') {
+            ident_t unit_name = ident_new_n(slash + 2, tail - slash - 2);
+            lib_t lib = lib_find(ident_until(unit_name, '.'));
+            if (lib != NULL) {
+               const unit_meta_t *meta;
+               object_t *obj = lib_get_generic(lib, unit_name, &meta);
+               if (obj != NULL && meta->cover_file != NULL) {
+                  warnf("redirecting %s to %s, please update your scripts",
+                        file, meta->cover_file);
+                  f = fbuf_open(meta->cover_file, FBUF_IN, FBUF_CS_NONE);
+               }
+            }
+         }
+      }
+   }
+
+   if (f == NULL)
+      fatal_errno("could not open %s", file);
+
+   return f;
+}
+
 static cover_data_t *merge_coverage_files(int argc, int next_cmd, char **argv,
                                           cover_mask_t rpt_mask,
                                           merge_mode_t mode)
@@ -1816,43 +2025,28 @@ static cover_data_t *merge_coverage_files(int argc, int next_cmd, char **argv,
 
    cover_data_t *merged = NULL;
 
-   for (int i = optind; i < next_cmd; i++) {
-      fbuf_t *f = fbuf_open(argv[i], FBUF_IN, FBUF_CS_NONE);
-      if (f == NULL) {
-         // Attempt to redirect the old file name to the new one
-         // TODO: this should be removed at some point
-         char *slash = strrchr(argv[i], *DIR_SEP) ?: strrchr(argv[i], '/');
-         if (slash != NULL && slash[1] == '_') {
-            char *tail = strstr(slash, ".covdb");
-            if (tail != NULL && tail[6] == '\0') {
-               ident_t unit_name = ident_new_n(slash + 2, tail - slash - 2);
-               lib_t lib = lib_find(ident_until(unit_name, '.'));
-               if (lib != NULL) {
-                  const unit_meta_t *meta;
-                  object_t *obj = lib_get_generic(lib, unit_name, &meta);
-                  if (obj != NULL && meta->cover_file != NULL) {
-                     warnf("redirecting %s to %s, please update your scripts",
-                           argv[i], meta->cover_file);
-                     f = fbuf_open(meta->cover_file, FBUF_IN, FBUF_CS_NONE);
-                  }
-               }
-            }
-         }
-      }
+   // Databases are read and merged in parallel in batches of one per
+   // worker thread to limit the number held in memory at once
+   const int batchsz = MIN(next_cmd - optind, (int)thread_max_workers());
+   fbuf_t **files LOCAL = xmalloc_array(batchsz, sizeof(fbuf_t *));
 
-      if (f == NULL)
-         fatal_errno("could not open %s", argv[i]);
+   for (int i = optind; i < next_cmd; i += batchsz) {
+      const int count = MIN(next_cmd - i, batchsz);
 
-      progress("loading input coverage database %s", argv[i]);
+      for (int j = 0; j < count; j++) {
+         progress("loading input coverage database %s", argv[i + j]);
+         files[j] = open_coverage_file(argv[i + j]);
+      }
 
-      cover_data_t *db = cover_read(f, rpt_mask);
+      cover_data_t *db = cover_read_merge(files, count, rpt_mask, mode);
 
-      if (i == optind)
+      if (merged == NULL)
          merged = db;
       else
          cover_merge(merged, db, mode);
 
-      fbuf_close(f, NULL);
+      for (int j = 0; j < count; j++)
+         fbuf_close(files[j], NULL);
    }
 
    return merged;
@@ -2160,7 +2354,7 @@ static void usage(void)
       struct {
          const char *args;
          const char *usage;
-      } options[16];
+      } options[20];
    } groups[] = {
       { "Commands",
         {
@@ -2219,6 +2413,9 @@ static void usage(void)
            { "--error-limit=NUM", "Stop after NUM errors" },
            { "-f, --files=LIST", "Read files to analyse from LIST" },
            { "-I DIR", "Add DIR to list of Verilog include directories" },
+           { "--incremental",
+             "Skip files unchanged since they were last analysed" },
+           { "--jobs=N", "Analyse up to N independent files in parallel" },
            { "--keywords=VERSION",
              "Use keywords from specified Verilog version" },
            { "--no-save", "Do not save analysed design units" },
@@ -2229,11 +2426,15 @@ static void usage(void)
            { "--relaxed", "Disable certain pedantic rule checks" },
            { "--single-unit",
              "Treat all Verilog files as a single compilation unit" },
+           { "--verbose", "Report files skipped by --incremental" },
            { "-Werror", "Treat all analysis warnings as errors" },
         }
       },
       { "Elaboration options",
         {
+           { "--aot",
+             "Generate native code for the whole design and save it in "
+             "the JIT cache" },
            { "--cover[={statement,branch,expression,toggle,...}]",
              "Enable code coverage collection" },
            { "--cover-file=FILE",
@@ -2254,6 +2455,8 @@ static void usage(void)
         {
            { "--dump-arrays[=N]",
              "Include nested arrays with up to N elements in waveform dump" },
+           { "--event-queue={heap,wheel}",
+             "Data structure used for the simulation event queue" },
            { "--exclude=GLOB",
              "Exclude signals matching GLOB from waveform dump" },
            { "--exit-severity={note,warning,error,failure}",
@@ -2261,12 +2464,22 @@ static void usage(void)
            { "--format={fst,vcd}", "Waveform dump format" },
            { "--include=GLOB",
              "Include signals matching GLOB in waveform dump" },
+           { "--jit-cache",
+             "Reuse and save JIT compiled code between runs" },
+           { "--jit-profile=FILE",
+             "Compile functions listed in FILE eagerly and update it "
+             "with the hot functions from this run" },
+           { "--profile=FILE",
+             "Write per-process time profile to FILE in folded stack format" },
            { "--shuffle", "Run processes in random order" },
            { "--stats", "Print time and memory usage at end of run" },
            { "--stop-delta=N", "Stop after N delta cycles (default 10000)" },
            { "--stop-time=T", "Stop after simulation time T (e.g. 5ns)" },
+           { "--threads=N", "Run processes in parallel using N threads" },
            { "--trace", "Trace simulation events" },
            { "-w, --wave[=FILE]", "Write waveform dump to FILE" },
+           { "--wave-async",
+             "Write waveform dump from a separate background thread" },
         }
       },
       { "Coverage report options",
@@ -2550,6 +2763,11 @@ int main(int argc, char **argv)
    int c, index = 0;
    const char *spec = ":hivL:M:P:G:H:";
    while ((c = getopt_long(next_cmd, argv, spec, long_options, &index)) != -1) {
+      // Passed on to child processes except for plugins which should
+      // only be loaded once and deprecated options
+      if (c != 0 && strchr("lTDfPG?:", c) == NULL)
+         push_option(&state.global_args, long_options, spec, c, optarg);
+
       switch (c) {
       case 0:
          // Set a flag
@@ -2666,5 +2884,7 @@ int main(int argc, char **argv)
    if (state.cover != NULL)
       cover_data_free(state.cover);
 
+   free_args(&state.global_args);
+
    return ret;
 }
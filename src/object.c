@@ -42,6 +42,8 @@ typedef struct _object_arena {
    void           *alloc;
    void           *limit;
    uint32_t       *forward;
+   uint32_t       *live_index;
+   unsigned        live_count;
    mark_mask_t    *mark_bits;
    size_t          mark_sz;
    size_t          mark_low;
@@ -60,6 +62,13 @@ typedef struct _object_arena {
    bool            obsolete;
 } object_arena_t;
 
+typedef struct {
+   char   *base;
+   size_t  alloc;
+} obj_slab_t;
+
+#define OBJ_SLAB_SZ 0x10000
+
 #if !ASAN_ENABLED
 #define OBJECT_UNMAP_UNUSED 1
 #endif
@@ -182,6 +191,11 @@ void arena_set_checksum(object_arena_t *arena, uint32_t checksum)
    arena->checksum = checksum;
 }
 
+uint32_t arena_checksum(object_arena_t *arena)
+{
+   return arena->checksum;
+}
+
 object_t *arena_root(object_arena_t *arena)
 {
    return arena->root ?: (object_t *)arena->base;
@@ -633,7 +647,17 @@ static void object_arena_gc(object_arena_t *arena)
       fatal_trace("GC removed all objects from arena %s",
                   istr(object_arena_name(arena)));
 
+   // Forwarding addresses are increasing so a sorted list of the live
+   // object indexes allows a locus to be resolved by binary search
+   uint32_t *live_index = xmalloc_array(live, sizeof(uint32_t));
+   for (size_t i = 0, j = 0; i < fwdsz; i++) {
+      if (forward[i] != UINT32_MAX)
+         live_index[j++] = i;
+   }
+
    arena->forward = forward;
+   arena->live_index = live_index;
+   arena->live_count = live;
    arena->live_bytes = woffset;
 
    if (opt_get_verbose(OPT_OBJECT_VERBOSE, NULL)) {
@@ -921,6 +945,27 @@ static object_t *object_read_ref(fbuf_t *f, const arena_key_t *key_map)
    return (object_t *)((char *)arena->base + offset);
 }
 
+static obj_array_t *obj_array_slab_alloc(obj_slab_t *slab, unsigned count)
+{
+   // Arrays in an arena read from disk can never grow or be freed so
+   // carve them out of larger chunks to avoid the overhead of a
+   // separate heap allocation for every declaration list
+   const size_t size =
+      ALIGN_UP(sizeof(obj_array_t) + count * sizeof(object_t *),
+               sizeof(object_t *));
+
+   if (size > OBJ_SLAB_SZ / 4)
+      return xmalloc(size);
+   else if (slab->base == NULL || slab->alloc + size > OBJ_SLAB_SZ) {
+      slab->base = xmalloc(OBJ_SLAB_SZ);
+      slab->alloc = 0;
+   }
+
+   obj_array_t *a = (obj_array_t *)(slab->base + slab->alloc);
+   slab->alloc += size;
+   return a;
+}
+
 object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
                       ident_rd_ctx_t ident_ctx, loc_rd_ctx_t *loc_ctx)
 {
@@ -1007,6 +1052,8 @@ object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
       key_map[dkey] = a->key;
    }
 
+   obj_slab_t slab = {};
+
    for (;;) {
       const uint64_t hdr = fbuf_get_uint(f);
       if (hdr == UINT16_MAX) break;
@@ -1034,8 +1081,7 @@ object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
          else if (ITEM_OBJ_ARRAY & mask) {
             const unsigned count = fbuf_get_uint(f);
             if (count > 0) {
-               item->obj_array = xmalloc_flex(sizeof(obj_array_t),
-                                              count, sizeof(object_t *));
+               item->obj_array = obj_array_slab_alloc(&slab, count);
                item->obj_array->count =
                   item->obj_array->limit = count;
                for (unsigned i = 0; i < count; i++) {
@@ -1348,14 +1394,23 @@ object_t *object_from_locus(ident_t module, ptrdiff_t offset,
 
    void *ptr = NULL;
    if (arena->forward != NULL) {
-      // TODO: could do binary search here
-      for (int i = 0; i < (arena->alloc - arena->base) / OBJECT_ALIGN; i++) {
-         if (arena->forward[i] == offset << OBJECT_ALIGN_BITS) {
-            ptr = arena->base + (i << OBJECT_ALIGN_BITS);
+      const uint32_t want = offset << OBJECT_ALIGN_BITS;
+      unsigned low = 0, high = arena->live_count;
+      while (low < high) {
+         const unsigned mid = low + (high - low) / 2;
+         const uint32_t index = arena->live_index[mid];
+         if (arena->forward[index] < want)
+            low = mid + 1;
+         else if (arena->forward[index] > want)
+            high = mid;
+         else {
+            ptr = arena->base + ((size_t)index << OBJECT_ALIGN_BITS);
             break;
          }
       }
-      assert(ptr != NULL);
+
+      if (ptr == NULL)
+         fatal_trace("invalid object locus %s%+"PRIiPTR, istr(module), offset);
    }
    else
       ptr = arena->base + (offset << OBJECT_ALIGN_BITS);
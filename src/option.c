@@ -158,6 +158,7 @@ void set_default_options(void)
    opt_set_int(OPT_JIT_THRESHOLD, get_int_env("NVC_JIT_THRESHOLD", 100));
    opt_set_str(OPT_ASM_VERBOSE, getenv("NVC_ASM_VERBOSE"));
    opt_set_int(OPT_JIT_ASYNC, get_int_env("NVC_JIT_ASYNC", 1));
+   opt_set_int(OPT_JIT_PRECOMPILE, get_int_env("NVC_JIT_PRECOMPILE", 0));
    opt_set_int(OPT_PERF_MAP, get_int_env("NVC_PERF_MAP", 0));
    opt_set_str(OPT_LIB_VERBOSE, getenv("NVC_LIB_VERBOSE"));
    opt_set_str(OPT_PSL_VERBOSE, getenv("NVC_PSL_VERBOSE"));
@@ -186,4 +187,13 @@ void set_default_options(void)
    opt_set_int(OPT_ELAB_STATS, 0);
    opt_set_str(OPT_RELATIVE_PATH, NULL);
    opt_set_int(OPT_EXCL_VERBOSE, get_int_env("NVC_EXCL_VERBOSE", 0));
+   opt_set_int(OPT_RT_THREADS, 1);
+   opt_set_str(OPT_JIT_CACHE, NULL);
+   opt_set_int(OPT_EVENT_QUEUE, EVENT_QUEUE_HEAP);
+   opt_set_int(OPT_WAVE_ASYNC, 0);
+   opt_set_str(OPT_PROFILE_FILE, NULL);
+   opt_set_int(OPT_GC_THREADS, get_int_env("NVC_GC_THREADS", 0));
+   opt_set_int(OPT_GC_GENERATIONAL, get_int_env("NVC_GC_GENERATIONAL", 0));
+   opt_set_int(OPT_LIB_COMPRESS, get_int_env("NVC_LIB_COMPRESS", 0));
+   opt_set_int(OPT_INCREMENTAL, 0);
 }
@@ -53,6 +53,7 @@ typedef enum {
    OPT_JIT_THRESHOLD,
    OPT_ASM_VERBOSE,
    OPT_JIT_ASYNC,
+   OPT_JIT_PRECOMPILE,
    OPT_PERF_MAP,
    OPT_LIB_VERBOSE,
    OPT_PSL_VERBOSE,
@@ -81,6 +82,15 @@ typedef enum {
    OPT_RELATIVE_PATH,
    OPT_RA_VERBOSE,
    OPT_EXCL_VERBOSE,
+   OPT_RT_THREADS,
+   OPT_JIT_CACHE,
+   OPT_EVENT_QUEUE,
+   OPT_WAVE_ASYNC,
+   OPT_PROFILE_FILE,
+   OPT_GC_THREADS,
+   OPT_GC_GENERATIONAL,
+   OPT_LIB_COMPRESS,
+   OPT_INCREMENTAL,
 
    OPT_LAST_NAME
 } opt_name_t;
@@ -91,6 +101,11 @@ typedef enum {
    IEEE_WARNINGS_OFF_AT_0
 } ieee_warnings_t;
 
+typedef enum {
+   EVENT_QUEUE_HEAP,
+   EVENT_QUEUE_WHEEL
+} event_queue_t;
+
 void opt_set_int(opt_name_t name, int val);
 void opt_set_size(opt_name_t name, size_t val);
 void opt_set_str(opt_name_t name, const char *val);
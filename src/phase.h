@@ -58,6 +58,11 @@ void vhdl_dump(tree_t t, int indent);
 // Generate a makefile for the givein unit
 void make(tree_t *targets, int count, FILE *out);
 
+// Analyse source files concurrently respecting dependencies between them
+bool make_analyse(const char *const *files, int count, int njobs,
+                  const char *const *args, jit_t *jit, unit_registry_t *ur,
+                  mir_context_t *mc);
+
 // Read the next unit from the input file
 tree_t parse(void);
 
@@ -24,6 +24,10 @@
 #include <x86intrin.h>
 #endif
 
+#ifdef ARCH_ARM64
+#include <arm_neon.h>
+#endif
+
 #if defined __GNUC__ && !defined __clang__
 #pragma GCC optimize ("O2")
 #endif
@@ -103,3 +107,123 @@ bool _cmp_bytes(const void *a, const void *b, size_t size)
 
    return memcmp(a, b, size) == 0;
 }
+
+// The table lookup kernels below are used to evaluate memoised
+// resolution functions for enumeration types with at most 16 literals
+// such as std_ulogic.  A single byte shuffle performs 16 lookups in
+// parallel with the table held in a vector register.
+
+#ifdef HAVE_SSE41
+__attribute__((target("sse4.1")))
+static void lookup1_bytes_sse41(void *dst, const void *src,
+                                const int8_t table[16], size_t len)
+{
+   const __m128i tab = _mm_loadu_si128((const __m128i *)table);
+
+   for (; len > 15; len -= 16, dst += 16, src += 16) {
+      __m128i in = _mm_loadu_si128((const __m128i *)src);
+      _mm_storeu_si128((__m128i *)dst, _mm_shuffle_epi8(tab, in));
+   }
+
+   for (; len > 0; len--, dst++, src++)
+      *(int8_t *)dst = table[*(const uint8_t *)src];
+}
+
+__attribute__((target("sse4.1")))
+static void lookup2_bytes_sse41(void *dst, const void *a, const void *b,
+                                const int8_t table[][16], int nrows,
+                                size_t len)
+{
+   for (; len > 15; len -= 16, dst += 16, a += 16, b += 16) {
+      __m128i left  = _mm_loadu_si128((const __m128i *)a);
+      __m128i right = _mm_loadu_si128((const __m128i *)b);
+      __m128i out   = _mm_setzero_si128();
+
+      // Look up each row using the right hand value and keep the lanes
+      // where the left hand value selects that row
+      for (int i = 0; i < nrows; i++) {
+         __m128i row  = _mm_loadu_si128((const __m128i *)table[i]);
+         __m128i mask = _mm_cmpeq_epi8(left, _mm_set1_epi8(i));
+         __m128i val  = _mm_shuffle_epi8(row, right);
+         out = _mm_or_si128(out, _mm_and_si128(mask, val));
+      }
+
+      _mm_storeu_si128((__m128i *)dst, out);
+   }
+
+   for (; len > 0; len--, dst++, a++, b++) {
+      const uint8_t left = *(const uint8_t *)a, right = *(const uint8_t *)b;
+      *(int8_t *)dst = table[left][right];
+   }
+}
+#endif
+
+#ifdef ARCH_ARM64
+static void lookup1_bytes_neon(void *dst, const void *src,
+                               const int8_t table[16], size_t len)
+{
+   const uint8x16_t tab = vld1q_u8((const uint8_t *)table);
+
+   for (; len > 15; len -= 16, dst += 16, src += 16) {
+      uint8x16_t in = vld1q_u8(src);
+      vst1q_u8(dst, vqtbl1q_u8(tab, in));
+   }
+
+   for (; len > 0; len--, dst++, src++)
+      *(int8_t *)dst = table[*(const uint8_t *)src];
+}
+
+static void lookup2_bytes_neon(void *dst, const void *a, const void *b,
+                               const int8_t table[][16], int nrows,
+                               size_t len)
+{
+   for (; len > 15; len -= 16, dst += 16, a += 16, b += 16) {
+      uint8x16_t left  = vld1q_u8(a);
+      uint8x16_t right = vld1q_u8(b);
+      uint8x16_t out   = vdupq_n_u8(0);
+
+      for (int i = 0; i < nrows; i++) {
+         uint8x16_t row  = vld1q_u8((const uint8_t *)table[i]);
+         uint8x16_t mask = vceqq_u8(left, vdupq_n_u8(i));
+         out = vorrq_u8(out, vandq_u8(mask, vqtbl1q_u8(row, right)));
+      }
+
+      vst1q_u8(dst, out);
+   }
+
+   for (; len > 0; len--, dst++, a++, b++) {
+      const uint8_t left = *(const uint8_t *)a, right = *(const uint8_t *)b;
+      *(int8_t *)dst = table[left][right];
+   }
+}
+#endif
+
+void lookup1_bytes(void *dst, const void *src, const int8_t table[16],
+                   size_t len)
+{
+#if defined HAVE_SSE41 && !ASAN_ENABLED
+   if (likely(__builtin_cpu_supports("sse4.1")))
+      return lookup1_bytes_sse41(dst, src, table, len);
+#elif defined ARCH_ARM64
+   return lookup1_bytes_neon(dst, src, table, len);
+#endif
+
+   for (; len > 0; len--, dst++, src++)
+      *(int8_t *)dst = table[*(const uint8_t *)src];
+}
+
+void lookup2_bytes(void *dst, const void *a, const void *b,
+                   const int8_t table[][16], int nrows, size_t len)
+{
+#if defined HAVE_SSE41 && !ASAN_ENABLED
+   if (likely(__builtin_cpu_supports("sse4.1")))
+      return lookup2_bytes_sse41(dst, a, b, table, nrows, len);
+#elif defined ARCH_ARM64
+   return lookup2_bytes_neon(dst, a, b, table, nrows, len);
+#endif
+
+   for (; len > 0; len--, dst++, a++, b++) {
+      const uint8_t left = *(const uint8_t *)a, right = *(const uint8_t *)b;
+      *(int8_t *)dst = table[left][right];
+   }
+}
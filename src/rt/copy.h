@@ -45,4 +45,15 @@ static inline bool cmp_bytes(const void *a, const void *b, size_t size)
       return _cmp_bytes(a, b, size);
 }
 
+// Map each byte of SRC through a table of 16 entries.  All input
+// values must be less than 16.
+void lookup1_bytes(void *dst, const void *src, const int8_t table[16],
+                   size_t len);
+
+// Map each pair of bytes from A and B through a two-dimensional table
+// where the values in A are less than NROWS and those in B are less
+// than 16.
+void lookup2_bytes(void *dst, const void *a, const void *b,
+                   const int8_t table[][16], int nrows, size_t len);
+
 #endif   // _RT_COPY_H
@@ -384,6 +384,7 @@ void _nvc_create_cover_scope(jit_scalar_t *args)
                                           suffix);
 
    *ptr = us;
+   jit_write_barrier(ptr, sizeof(user_scope_t *));
 }
 
 DLLEXPORT
@@ -40,6 +40,10 @@
 #include <stdio_ext.h>
 #endif
 
+#ifdef __MINGW32__
+#define getc_unlocked _getc_nolock
+#endif
+
 typedef enum {
    FILE_ORIGIN_BEGIN,
    FILE_ORIGIN_CURRENT,
@@ -76,6 +80,9 @@ typedef struct {
    file_kind_t  kind;
    file_mode_t  mode;
    uint16_t     generation;
+   char        *linebuf;
+   size_t       linelen;
+   size_t       linemax;
 } file_slot_t;
 
 #define HANDLE_BITS      (sizeof(file_handle_t) * 8)
@@ -127,6 +134,8 @@ static file_handle_t handle_for(FILE *f, const char *name, file_kind_t kind,
       for (int i = index; i < new_size; i++) {
          handles[i].file = NULL;
          handles[i].generation = 1;
+         handles[i].linebuf = NULL;
+         handles[i].linemax = 0;
       }
    }
 
@@ -135,6 +144,7 @@ static file_handle_t handle_for(FILE *f, const char *name, file_kind_t kind,
    slot->name = xstrdup(name);
    slot->kind = kind;
    slot->mode = mode;
+   slot->linelen = 0;
 
    free_hint = index + 1;
 
@@ -151,8 +161,11 @@ static bool drop_handle(file_handle_t handle)
       fclose(slot->file);
 
    free(slot->name);
+   free(slot->linebuf);
 
    slot->file = NULL;
+   slot->linebuf = NULL;
+   slot->linemax = 0;
    slot->generation++;
 
    free_hint = slot - handles;
@@ -425,6 +438,54 @@ void __nvc_file_canseek(jit_scalar_t *args)
    args[0].integer = fseek(slot->file, 0, SEEK_CUR) == 0;
 }
 
+DLLEXPORT
+void _std_textio_line_length(jit_scalar_t *args, tlab_t *tlab)
+{
+   file_handle_t *handle = args[1].pointer;
+
+   file_slot_t *slot = decode_handle(*handle);
+   if (slot == NULL)
+      jit_msg(NULL, DIAG_FATAL, "read from closed file");
+
+   // Buffer the whole line here to avoid a call into the runtime for
+   // each character, carriage returns are discarded
+   FILE *f = slot->file;
+   size_t len = 0;
+   int c;
+   while ((c = getc_unlocked(f)) != EOF && c != '\n') {
+      if (c == '\r')
+         continue;
+      else if (len == slot->linemax) {
+         slot->linemax = MAX(slot->linemax * 2, 128);
+         slot->linebuf = xrealloc(slot->linebuf, slot->linemax);
+      }
+
+      slot->linebuf[len++] = c;
+   }
+
+   if (c == EOF && ferror(f))
+      jit_msg(NULL, DIAG_FATAL, "read from file failed");
+
+   slot->linelen = len;
+   args[0].integer = len;
+}
+
+DLLEXPORT
+void _std_textio_line_data(jit_scalar_t *args, tlab_t *tlab)
+{
+   file_handle_t *handle = args[1].pointer;
+   uint8_t *data = args[2].pointer;
+   const int64_t length = ffi_array_length(args[4].integer);
+
+   file_slot_t *slot = decode_handle(*handle);
+   if (slot == NULL)
+      jit_msg(NULL, DIAG_FATAL, "read from closed file");
+
+   assert(length == slot->linelen);
+   memcpy(data, slot->linebuf, MIN(length, slot->linelen));
+   slot->linelen = 0;
+}
+
 void x_file_open(int8_t *status, void **_fp, const uint8_t *name_bytes,
                  int32_t name_len, int8_t mode)
 {
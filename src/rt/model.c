@@ -31,7 +31,9 @@
 #include "rt/copy.h"
 #include "rt/heap.h"
 #include "rt/model.h"
+#include "rt/profile.h"
 #include "rt/random.h"
+#include "rt/wheel.h"
 #include "rt/structs.h"
 #include "thread.h"
 #include "tree.h"
@@ -59,9 +61,30 @@ typedef enum {
    EVENT_PSEUDO,
 } event_kind_t;
 
+typedef enum {
+   TX_SCHED_PROCESS,
+   TX_SCHED_WAVEFORM,
+   TX_SCHED_WAVEFORM_S,
+   TX_SCHED_EVENT,
+   TX_CLEAR_EVENT,
+   TX_ENABLE_TRIGGER,
+   TX_DISABLE_TRIGGER,
+   TX_DISCONNECT,
+   TX_FORCE,
+   TX_RELEASE,
+   TX_DEPOSIT,
+   TX_SCHED_DEPOSIT,
+   TX_PUT_DRIVER,
+   TX_SCHED_INACTIVE,
+   TX_TRANSFER_SIGNAL,
+   TX_SCHED_ACTIVE,
+} tx_kind_t;
+
 #define MEMBLOCK_ALIGN   64
 #define MEMBLOCK_PAGE_SZ 0x800000
 #define TRIGGER_TAB_SIZE 64
+#define PARALLEL_MIN     16
+#define PARALLEL_CHUNK   4
 
 #if ASAN_ENABLED
 #define MEMBLOCK_REDZONE 16
@@ -78,11 +101,34 @@ typedef struct _memblock {
 
 STATIC_ASSERT(sizeof(memblock_t) <= MEMBLOCK_ALIGN);
 
+// Scheduling operations made by a process running on a worker thread
+// are recorded here and replayed in the original order afterwards
+typedef struct {
+   tx_kind_t  kind;
+   uint32_t   offset;
+   int32_t    count;
+   uint32_t   nbytes;
+   void      *ptr;
+   int64_t    after;
+   int64_t    reject;
+   uint8_t    value[];
+} tx_record_t;
+
+STATIC_ASSERT(sizeof(tx_record_t) % 8 == 0);
+
+typedef struct {
+   sig_shared_t *source;
+   uint32_t      soffset;
+} tx_transfer_t;
+
 typedef struct {
    waveform_t    *free_waveforms;
    tlab_t        *tlab;
    rt_wakeable_t *active_obj;
    rt_scope_t    *active_scope;
+   uint8_t       *txbuf;
+   size_t         txlen;
+   size_t         txmax;
 } __attribute__((aligned(64))) model_thread_t;
 
 typedef void (*defer_fn_t)(rt_model_t *, void *);
@@ -98,6 +144,18 @@ typedef struct {
    unsigned      max;
 } deferq_t;
 
+typedef struct {
+   rt_proc_t *proc;
+   int        thread;
+   size_t     start;
+   size_t     end;
+} par_task_t;
+
+typedef struct {
+   unsigned first;
+   unsigned last;
+} par_chunk_t;
+
 typedef struct _rt_model {
    tree_t             top;
    hash_t            *scopes;
@@ -111,11 +169,13 @@ typedef struct _rt_model {
    uint64_t           now;
    uint64_t           trigger_epoch;
    bool               can_create_delta;
+   bool               resetting;
    bool               next_is_delta;
    bool               force_stop;
    bool               blocking_update;
    unsigned           n_signals;
    heap_t            *eventq_heap;
+   wheel_t           *eventq_wheel;
    ihash_t           *res_memo;
    rt_watch_t        *watches;
    deferq_t           procq;
@@ -140,6 +200,16 @@ typedef struct _rt_model {
    bool               shuffle;
    bool               liveness;
    rt_trigger_t      *triggertab[TRIGGER_TAB_SIZE];
+   workq_t           *procwq;
+   unsigned           nthreads;
+   bool               parallel;
+   nvc_lock_t         serial_lock;
+   int                serial_owner;
+   par_task_t        *partasks;
+   unsigned           partasks_max;
+   par_chunk_t       *parchunks;
+   hash_t            *parsafe;
+   rt_profile_t      *profile;
 } rt_model_t;
 
 #define FMT_VALUES_SZ   128
@@ -147,6 +217,11 @@ typedef struct _rt_model {
 #define TRACE_SIGNALS   1
 #define WAVEFORM_CHUNK  256
 #define PENDING_MIN     4
+
+// Tags for the nexus pending pointer
+#define PENDING_LIST    0
+#define PENDING_ONE     1
+#define PENDING_STATIC  2
 #define MAX_RANK        UINT8_MAX
 
 #define TRACE(...) do {                                 \
@@ -158,6 +233,12 @@ typedef struct _rt_model {
    rt_model_t *__save __attribute__((unused, cleanup(__model_exit)));   \
    __model_entry(m, &__save);                                           \
 
+// Serialise access to shared model state from functions which cannot
+// be deferred while processes are running in parallel
+#define MODEL_SERIAL(m)                                                 \
+   rt_model_t *__serial __attribute__((unused, cleanup(__serial_exit))) \
+      = __serial_entry(m);                                              \
+
 static __thread rt_model_t *__model = NULL;
 
 static bool __trace_on = false;
@@ -315,6 +396,28 @@ static void __model_exit(rt_model_t **save)
       diag_remove_hint_fn(model_diag_cb, m);
 }
 
+static rt_model_t *__serial_entry(rt_model_t *m)
+{
+   if (likely(!m->parallel))
+      return NULL;
+
+   nvc_lock(&m->serial_lock);
+   relaxed_store(&m->serial_owner, thread_id());
+   return m;
+}
+
+static void __serial_release(rt_model_t *m)
+{
+   relaxed_store(&m->serial_owner, -1);
+   nvc_unlock(&m->serial_lock);
+}
+
+static void __serial_exit(rt_model_t **pm)
+{
+   if (*pm != NULL)
+      __serial_release(*pm);
+}
+
 static char *fmt_values_r(const void *values, size_t len, char *buf, size_t max)
 {
    char *p = buf;
@@ -365,11 +468,45 @@ static model_thread_t *model_thread(rt_model_t *m)
 
    return m->threads[my_id];
 #else
-   assert(thread_id() == 0);
-   return m->threads[0];
+   // Worker threads only run processes when per-thread state has
+   // already been allocated in model_reset
+   model_thread_t *thread = m->threads[thread_id()];
+   assert(thread != NULL);
+   return thread;
 #endif
 }
 
+static void tx_log(rt_model_t *m, tx_kind_t kind, void *ptr, uint32_t offset,
+                   int32_t count, int64_t after, int64_t reject,
+                   const void *value, size_t nbytes)
+{
+   model_thread_t *thread = model_thread(m);
+
+   const size_t need = sizeof(tx_record_t) + ALIGN_UP(nbytes, 8);
+   if (unlikely(thread->txlen + need > thread->txmax)) {
+      thread->txmax = MAX(thread->txmax * 2, MAX(thread->txlen + need, 4096));
+      thread->txbuf = xrealloc(thread->txbuf, thread->txmax);
+   }
+
+   tx_record_t *tx = (tx_record_t *)(thread->txbuf + thread->txlen);
+   tx->kind   = kind;
+   tx->offset = offset;
+   tx->count  = count;
+   tx->nbytes = nbytes;
+   tx->ptr    = ptr;
+   tx->after  = after;
+   tx->reject = reject;
+
+   // Pad the value to a whole number of words as copy_value_ptr may
+   // read past the end of small values
+   if (nbytes > 0) {
+      memcpy(tx->value, value, nbytes);
+      memset(tx->value + nbytes, '\0', ALIGN_UP(nbytes, 8) - nbytes);
+   }
+
+   thread->txlen += need;
+}
+
 __attribute__((cold, noinline))
 static void deferq_grow(deferq_t *dq)
 {
@@ -469,6 +606,47 @@ static void *static_alloc(rt_model_t *m, size_t size)
    return ptr;
 }
 
+static inline void eventq_insert(rt_model_t *m, uint64_t when, void *e)
+{
+   if (m->eventq_wheel != NULL)
+      wheel_insert(m->eventq_wheel, when, e);
+   else
+      heap_insert(m->eventq_heap, when, e);
+}
+
+static inline size_t eventq_size(rt_model_t *m)
+{
+   if (m->eventq_wheel != NULL)
+      return wheel_size(m->eventq_wheel);
+   else
+      return heap_size(m->eventq_heap);
+}
+
+static inline uint64_t eventq_min_key(rt_model_t *m)
+{
+   if (m->eventq_wheel != NULL)
+      return wheel_min_key(m->eventq_wheel);
+   else
+      return heap_min_key(m->eventq_heap);
+}
+
+static inline void *eventq_extract_min(rt_model_t *m)
+{
+   if (m->eventq_wheel != NULL)
+      return wheel_extract_min(m->eventq_wheel);
+   else
+      return heap_extract_min(m->eventq_heap);
+}
+
+static inline bool eventq_delete(rt_model_t *m, heap_delete_fn_t fn,
+                                 void *context)
+{
+   if (m->eventq_wheel != NULL)
+      return wheel_delete(m->eventq_wheel, fn, context);
+   else
+      return heap_delete(m->eventq_heap, fn, context);
+}
+
 static void run_callbacks(rt_model_t *m, model_phase_t phase)
 {
    rt_callback_t *list = m->phase_cbs[phase];
@@ -489,16 +667,23 @@ rt_model_t *model_new(jit_t *jit, cover_data_t *cover)
    m->jit         = jit;
    m->nexus_tail  = &(m->nexuses);
    m->iteration   = -1;
-   m->eventq_heap = heap_new(512);
    m->res_memo    = ihash_new(128);
    m->cover       = cover;
 
+   if (opt_get_int(OPT_EVENT_QUEUE) == EVENT_QUEUE_WHEEL)
+      m->eventq_wheel = wheel_new();
+   else
+      m->eventq_heap = heap_new(512);
+
    m->driving_heap   = heap_new(64);
    m->effective_heap = heap_new(64);
 
    m->can_create_delta = true;
    m->next_is_delta    = true;
 
+   if (opt_get_str(OPT_PROFILE_FILE) != NULL)
+      m->profile = profile_new();
+
    m->threads[thread_id()] = static_alloc(m, sizeof(model_thread_t));
 
    __trace_on = opt_get_int(OPT_RT_TRACE);
@@ -546,7 +731,7 @@ static void free_waveform(rt_model_t *m, waveform_t *w)
 
 static void cleanup_nexus(rt_model_t *m, rt_nexus_t *n)
 {
-   if (n->pending != NULL && pointer_tag(n->pending) == 0)
+   if (n->pending != NULL && pointer_tag(n->pending) == PENDING_LIST)
       free(n->pending);
 }
 
@@ -610,8 +795,13 @@ void model_free(rt_model_t *m)
             m->ready_rusage.ms, ru.ms, ru.user, ru.sys, ru.rss, mem / 1024);
    }
 
-   while (heap_size(m->eventq_heap) > 0) {
-      void *e = heap_extract_min(m->eventq_heap);
+   if (m->profile != NULL) {
+      profile_write(m->profile, opt_get_str(OPT_PROFILE_FILE));
+      profile_free(m->profile);
+   }
+
+   while (eventq_size(m) > 0) {
+      void *e = eventq_extract_min(m);
       if (pointer_tag(e) == EVENT_TIMEOUT)
          free(untag_pointer(e, rt_callback_t));
    }
@@ -621,10 +811,18 @@ void model_free(rt_model_t *m)
 
    for (int i = 0; i < MAX_THREADS; i++) {
       model_thread_t *thread = m->threads[i];
-      if (thread != NULL)
+      if (thread != NULL) {
          tlab_release(thread->tlab);
+         free(thread->txbuf);
+      }
    }
 
+   if (m->procwq != NULL)
+      workq_free(m->procwq);
+
+   free(m->partasks);
+   free(m->parchunks);
+
    free(m->procq.tasks);
    free(m->next_procq.tasks);
    free(m->postponedq.tasks);
@@ -655,7 +853,10 @@ void model_free(rt_model_t *m)
 
    heap_free(m->effective_heap);
    heap_free(m->driving_heap);
-   heap_free(m->eventq_heap);
+   if (m->eventq_wheel != NULL)
+      wheel_free(m->eventq_wheel);
+   else
+      heap_free(m->eventq_heap);
    hash_free(m->scopes);
    ihash_free(m->res_memo);
    ACLEAR(m->eventsigs);
@@ -702,7 +903,7 @@ rt_watch_t *find_watch(rt_nexus_t *n, sig_event_fn_t fn)
 {
    if (n->pending == NULL)
       return NULL;
-   else if (pointer_tag(n->pending) == 1) {
+   else if (pointer_tag(n->pending) != PENDING_LIST) {
       rt_wakeable_t *obj = untag_pointer(n->pending, rt_wakeable_t);
       if (obj->kind == W_WATCH) {
          rt_watch_t *w = container_of(obj, rt_watch_t, wakeable);
@@ -717,7 +918,7 @@ rt_watch_t *find_watch(rt_nexus_t *n, sig_event_fn_t fn)
 
       for (int i = 0; i < p->count; i++) {
          rt_wakeable_t *obj = untag_pointer(p->wake[i], rt_wakeable_t);
-         if (obj->kind == W_WATCH) {
+         if (obj != NULL && obj->kind == W_WATCH) {
             rt_watch_t *w = container_of(obj, rt_watch_t, wakeable);
             if (w->fn == fn)
                return w;
@@ -866,7 +1067,7 @@ static void deltaq_insert_proc(rt_model_t *m, uint64_t delta, rt_proc_t *proc)
       proc->wakeable.delayed = true;
 
       void *e = tag_pointer(proc, EVENT_PROCESS);
-      heap_insert(m->eventq_heap, m->now + delta, e);
+      eventq_insert(m, m->now + delta, e);
    }
 }
 
@@ -879,7 +1080,7 @@ static void deltaq_insert_driver(rt_model_t *m, uint64_t delta,
    }
    else {
       void *e = tag_pointer(source, EVENT_DRIVER);
-      heap_insert(m->eventq_heap, m->now + delta, e);
+      eventq_insert(m, m->now + delta, e);
    }
 }
 
@@ -981,10 +1182,15 @@ static void run_process(rt_model_t *m, rt_proc_t *proc)
    };
    jit_scalar_t result;
 
+   const uint64_t start = m->profile ? get_timestamp_ns() : 0;
+
    if (!jit_call_closure(m->jit, &proc->closure, &result, state,
                          proc->tlab ?: thread->tlab))
       m->force_stop = true;
 
+   if (unlikely(m->profile != NULL))
+      profile_process(m->profile, proc, get_timestamp_ns() - start);
+
    if (proc->tlab != NULL && result.pointer == NULL) {
       tlab_release(proc->tlab);
       proc->tlab = NULL;
@@ -1014,6 +1220,27 @@ static void reset_scope(rt_model_t *m, rt_scope_t *s)
       reset_property(m, s->properties.items[i]);
 }
 
+static bool is_ieee_resolved(type_t type)
+{
+   // True if the scalar elements of type are resolved by the standard
+   // std_logic resolution function
+   for (type_t t = type; type_kind(t) == T_SUBTYPE; t = type_base(t)) {
+      if (type_has_resolution(t)) {
+         tree_t rname = type_resolution(t);
+         while (tree_kind(rname) == T_ELEM_RESOLUTION)
+            rname = tree_value(tree_assoc(rname, 0));
+
+         return tree_ident2(tree_ref(rname))
+            == well_known(W_IEEE_1164_RESOLVED);
+      }
+   }
+
+   if (type_is_array(type))
+      return is_ieee_resolved(type_elem(type));
+   else
+      return false;
+}
+
 static res_memo_t *memo_resolution_fn(rt_model_t *m, rt_signal_t *signal,
                                       ffi_closure_t *closure, int32_t nlits,
                                       res_flags_t flags)
@@ -1067,10 +1294,37 @@ static res_memo_t *memo_resolution_fn(rt_model_t *m, rt_signal_t *signal,
       }
    }
 
-   if (model_exit_status(m) == 0) {
+   const bool memo_ok = (model_exit_status(m) == 0);
+
+   // The standard std_logic resolution function is defined as applying
+   // the two input table to each driver in turn so any number of drivers
+   // can be resolved with table lookups.  This cannot be inferred for
+   // arbitrary user functions from a finite number of calls so only the
+   // IEEE function is folded, after checking the three input case as a
+   // sanity check on the memoised table.
+
+   bool fold = memo_ok && is_ieee_resolved(tree_type(signal->where));
+   for (int i = 0; fold && i < nlits; i++) {
+      for (int j = 0; fold && j < nlits; j++) {
+         for (int k = 0; fold && k < nlits; k++) {
+            int8_t args[3] = { i, j, k };
+            jit_scalar_t result;
+            if (!jit_try_call(m->jit, memo->closure.handle, &result,
+                              memo->closure.args[0], args, 3))
+               fold = false;
+            else
+               fold = (result.integer == memo->tab2[memo->tab2[i][j]][k]);
+         }
+      }
+   }
+
+   if (memo_ok) {
+      memo->nlits = nlits;
       memo->flags |= R_MEMO;
       if (identity)
          memo->flags |= R_IDENT;
+      if (fold && model_exit_status(m) == 0)
+         memo->flags |= R_FOLD;
    }
 
    TRACE("memoised resolution function %pi for type %pT",
@@ -1553,7 +1807,7 @@ static rt_nexus_t *clone_nexus(rt_model_t *m, rt_nexus_t *old, int offset)
 
    if (old->pending == NULL)
       new->pending = NULL;
-   else if (pointer_tag(old->pending) == 1)
+   else if (pointer_tag(old->pending) != PENDING_LIST)
       new->pending = old->pending;
    else {
       rt_pending_t *old_p = untag_pointer(old->pending, rt_pending_t);
@@ -1561,6 +1815,7 @@ static rt_nexus_t *clone_nexus(rt_model_t *m, rt_nexus_t *old, int offset)
                                          sizeof(rt_wakeable_t *));
 
       new_p->count = new_p->max = old_p->count;
+      new_p->nstatic = old_p->nstatic;
 
       for (int i = 0; i < old_p->count; i++)
          new_p->wake[i] = old_p->wake[i];
@@ -1680,6 +1935,25 @@ static inline rt_nexus_t *split_nexus(rt_model_t *m, rt_signal_t *s,
    return split_nexus_slow(m, s, offset, count);
 }
 
+static rt_nexus_t *find_nexus(rt_model_t *m, rt_signal_t *s, int *offset)
+{
+   // Locate the nexus containing the element at offset without
+   // splitting it so the signal is not modified by read-only queries
+   // while processes are running in parallel
+   rt_nexus_t *n;
+   if (m->parallel && s->index != NULL && !index_valid(s->index, *offset))
+      n = &(s->nexus);   // Do not free the index here
+   else
+      n = lookup_index(s, offset);
+
+   for (; *offset >= n->width; n = n->chain) {
+      *offset -= n->width;
+      assert(n->chain != NULL);
+   }
+
+   return n;
+}
+
 static void setup_signal(rt_model_t *m, rt_signal_t *s, tree_t where,
                          unsigned count, unsigned size, sig_flags_t flags,
                          unsigned offset)
@@ -1828,10 +2102,7 @@ static void call_resolution(rt_model_t *m, rt_nexus_t *n, res_memo_t *r,
       void *resolved = tlab_alloc(thread->tlab, n->width * n->size);
       char *p0 = source_value(n, s0);
 
-      for (int j = 0; j < n->width; j++) {
-         const int index = ((uint8_t *)p0)[j];
-         ((int8_t *)resolved)[j] = r->tab1[index];
-      }
+      lookup1_bytes(resolved, p0, r->tab1, n->width);
 
       put_driving(m, n, resolved);
       tlab_trim(thread->tlab, mark);
@@ -1852,8 +2123,33 @@ static void call_resolution(rt_model_t *m, rt_nexus_t *n, res_memo_t *r,
            s1 = s1->chain_input)
          ;
 
-      for (int j = 0; j < n->width; j++)
-         ((int8_t *)resolved)[j] = r->tab2[(int)p0[j]][(int)p1[j]];
+      lookup2_bytes(resolved, p0, p1, r->tab2, r->nlits, n->width);
+
+      put_driving(m, n, resolved);
+      tlab_trim(thread->tlab, mark);
+   }
+   else if ((r->flags & R_FOLD) && nonnull > 2) {
+      // Resolve any number of drivers by folding the memoised two
+      // input table over the whole width of the nexus at once
+
+      model_thread_t *thread = model_thread(m);
+      assert(thread->tlab != NULL);
+
+      const uint32_t mark = tlab_mark(thread->tlab);
+
+      void *resolved = tlab_alloc(thread->tlab, n->width * n->size);
+      const void *acc = source_value(n, s0);
+
+      for (rt_source_t *s = s0->chain_input; s; s = s->chain_input) {
+         const void *p = source_value(n, s);
+         if (p == NULL)
+            continue;
+
+         lookup2_bytes(resolved, acc, p, r->tab2, r->nlits, n->width);
+         acc = resolved;
+      }
+
+      assert(acc == resolved);
 
       put_driving(m, n, resolved);
       tlab_trim(thread->tlab, mark);
@@ -2230,6 +2526,221 @@ static void check_undriven_std_logic(rt_nexus_t *n)
    n->signal->shared.flags &= ~SIG_F_STD_LOGIC;
 }
 
+#define PAR_SAFE   ((void *)1)
+#define PAR_UNSAFE ((void *)2)
+#define PAR_BUSY   ((void *)3)
+
+typedef struct {
+   rt_model_t      *model;
+   bool             unsafe;
+   A(tree_t)        callees;
+} par_scan_t;
+
+static bool subprogram_parallel_safe(rt_model_t *m, tree_t decl);
+
+static void mark_foreign_subprograms(rt_model_t *m, tree_t container)
+{
+   // Foreign subprograms may have arbitrary side effects so calls to
+   // them must happen on the main thread
+   const int ndecls = tree_decls(container);
+   for (int i = 0; i < ndecls; i++) {
+      tree_t d = tree_decl(container, i);
+      if (tree_kind(d) != T_ATTR_SPEC)
+         continue;
+      else if (ident_casecmp(tree_ident(d), well_known(W_FOREIGN)))
+         hash_put(m->parsafe, tree_ref(d), PAR_UNSAFE);
+   }
+}
+
+static void parallel_scan_cb(tree_t t, void *context)
+{
+   par_scan_t *ps = context;
+
+   switch (tree_kind(t)) {
+   case T_ASSERT:
+   case T_REPORT:
+   case T_PROT_FCALL:
+   case T_PROT_PCALL:
+      ps->unsafe = true;
+      break;
+   case T_REF:
+      if (tree_has_ref(t)) {
+         tree_t decl = tree_ref(t);
+         switch (tree_kind(decl)) {
+         case T_FILE_DECL:
+            ps->unsafe = true;
+            break;
+         case T_VAR_DECL:
+            if (tree_flags(decl) & TREE_F_SHARED)
+               ps->unsafe = true;
+            break;
+         case T_ALIAS:
+            APUSH(ps->callees, decl);
+            break;
+         default:
+            break;
+         }
+      }
+      break;
+   case T_FCALL:
+   case T_PCALL:
+      if (tree_has_ref(t))
+         APUSH(ps->callees, tree_ref(t));
+      break;
+   case T_ATTR_SPEC:
+      if (ident_casecmp(tree_ident(t), well_known(W_FOREIGN)))
+         hash_put(ps->model->parsafe, tree_ref(t), PAR_UNSAFE);
+      break;
+   default:
+      break;
+   }
+}
+
+static bool tree_parallel_safe(rt_model_t *m, tree_t t)
+{
+   par_scan_t ps = { .model = m };
+   tree_visit(t, parallel_scan_cb, &ps);
+
+   // Callees are checked after the visit completes as the object mark
+   // bits cannot be shared by nested visits
+   bool safe = !ps.unsafe;
+   for (int i = 0; safe && i < ps.callees.count; i++)
+      safe = subprogram_parallel_safe(m, ps.callees.items[i]);
+
+   ACLEAR(ps.callees);
+   return safe;
+}
+
+static tree_t find_enclosing_package(tree_t decl)
+{
+   ident_t it = tree_ident2(decl);
+   ident_t lname = ident_walk_selected(&it);
+   ident_t uname = ident_walk_selected(&it);
+   if (uname == NULL)
+      return NULL;
+
+   lib_t lib = lib_find(lname);
+   if (lib == NULL)
+      return NULL;
+
+   object_t *obj = lib_get_generic(lib, ident_prefix(lname, uname, '.'), NULL);
+   if (obj == NULL)
+      return NULL;
+
+   tree_t unit = tree_from_object(obj);
+   if (unit == NULL || !is_package(unit))
+      return NULL;
+
+   return unit;
+}
+
+static tree_t find_subprogram_body(rt_model_t *m, tree_t decl)
+{
+   tree_t unit = find_enclosing_package(decl), body = NULL;
+   if (unit != NULL) {
+      if (tree_kind(unit) == T_PACKAGE)
+         body = body_of(unit);
+
+      // The foreign subprograms in STD.STANDARD only read the
+      // simulation state so are safe to call from any thread
+      if (tree_ident(unit) != well_known(W_STD_STANDARD)
+          && hash_get(m->parsafe, unit) == NULL) {
+         mark_foreign_subprograms(m, unit);
+         if (body != NULL)
+            mark_foreign_subprograms(m, body);
+         hash_put(m->parsafe, unit, PAR_SAFE);
+      }
+   }
+
+   if (hash_get(m->parsafe, decl) == PAR_UNSAFE)
+      return NULL;
+   else if (is_body(decl))
+      return decl;
+
+   ident_t mangled = tree_ident2(decl);
+   tree_t scopes[] = { unit, body };
+   for (int i = 0; i < ARRAY_LEN(scopes); i++) {
+      if (scopes[i] == NULL)
+         continue;
+
+      const int ndecls = tree_decls(scopes[i]);
+      for (int j = 0; j < ndecls; j++) {
+         tree_t d = tree_decl(scopes[i], j);
+         if (is_body(d) && tree_ident2(d) == mangled)
+            return d;
+      }
+   }
+
+   return NULL;
+}
+
+static bool check_subprogram_parallel_safe(rt_model_t *m, tree_t decl)
+{
+   switch (tree_kind(decl)) {
+   case T_FUNC_DECL:
+   case T_PROC_DECL:
+      switch (tree_subkind(decl)) {
+      case S_USER:
+         break;
+      case S_FILE_OPEN1:
+      case S_FILE_OPEN2:
+      case S_FILE_OPEN3:
+      case S_FILE_CLOSE:
+      case S_FILE_READ:
+      case S_FILE_WRITE:
+      case S_FILE_FLUSH:
+      case S_ENDFILE:
+      case S_FILE_MODE:
+      case S_FILE_CANSEEK:
+      case S_FILE_SIZE:
+      case S_FILE_REWIND:
+      case S_FILE_SEEK:
+      case S_FILE_TRUNCATE:
+      case S_FILE_STATE:
+      case S_FILE_POSITION:
+         return false;
+      default:
+         return true;   // Other predefined operations have no side effects
+      }
+      // Fall-through
+   case T_FUNC_BODY:
+   case T_PROC_BODY:
+      {
+         tree_t body = find_subprogram_body(m, decl);
+         if (body == NULL)
+            return false;
+
+         return tree_parallel_safe(m, body);
+      }
+   case T_FUNC_INST:
+   case T_PROC_INST:
+      if (!is_body(tree_ref(decl)))
+         return false;   // Deferred instantiation
+
+      return tree_parallel_safe(m, decl);
+   case T_ALIAS:
+      if (!tree_has_value(decl))
+         return true;
+
+      return tree_parallel_safe(m, tree_value(decl));
+   default:
+      return false;   // Generic subprograms, etc.
+   }
+}
+
+static bool subprogram_parallel_safe(rt_model_t *m, tree_t decl)
+{
+   void *memo = hash_get(m->parsafe, decl);
+   if (memo != NULL)
+      return memo == PAR_SAFE;   // Recursive calls are treated as unsafe
+
+   hash_put(m->parsafe, decl, PAR_BUSY);
+
+   const bool safe = check_subprogram_parallel_safe(m, decl);
+   hash_put(m->parsafe, decl, safe ? PAR_SAFE : PAR_UNSAFE);
+   return safe;
+}
+
 static void create_processes(rt_model_t *m, rt_scope_t *s)
 {
    for (int i = 0; i < s->children.count; i++) {
@@ -2249,6 +2760,9 @@ static void create_processes(rt_model_t *m, rt_scope_t *s)
    ident_t path = ident_new(tb_get(tb));
    ident_t sym_prefix = tree_ident2(hier);
 
+   if (m->parsafe != NULL)
+      mark_foreign_subprograms(m, s->where);
+
    const int nstmts = tree_stmts(s->where);
    for (int i = 0; i < nstmts; i++) {
       tree_t t = tree_stmt(s->where, i);
@@ -2273,6 +2787,13 @@ static void create_processes(rt_model_t *m, rt_scope_t *s)
             p->wakeable.delayed   = false;
             p->wakeable.postponed = !!(tree_flags(t) & TREE_F_POSTPONED);
 
+            // A process can only run on a worker thread if it does not
+            // touch state shared with other processes or produce any
+            // output, otherwise the result would depend on the thread
+            // schedule rather than matching a serial run
+            if (m->parsafe != NULL)
+               p->wakeable.serial = !tree_parallel_safe(m, t);
+
             APUSH(s->procs, p);
          }
          break;
@@ -2317,15 +2838,44 @@ void model_reset(rt_model_t *m)
    m->stop_delta = opt_get_int(OPT_STOP_DELTA);
    m->shuffle    = opt_get_int(OPT_SHUFFLE_PROCS);
 
+   const int nthreads = opt_get_int(OPT_RT_THREADS);
+   if (nthreads > 1 && m->cover != NULL)
+      warnf("parallel process execution is not supported when collecting "
+            "coverage, running with one thread");
+   else if (nthreads > 1 && m->procwq == NULL) {
+      m->nthreads     = nthreads;
+      m->procwq       = workq_new(m);
+      m->serial_owner = -1;
+      m->parchunks    = xcalloc_array(nthreads * PARALLEL_CHUNK + 1,
+                                      sizeof(par_chunk_t));
+
+      // Any worker thread may pick up a chunk of processes so allocate
+      // the per-thread state for all of them up-front
+      for (int i = 0; i < MAX_THREADS; i++) {
+         if (m->threads[i] == NULL)
+            m->threads[i] = static_alloc(m, sizeof(model_thread_t));
+      }
+   }
+
    __trace_on = opt_get_int(OPT_RT_TRACE);
 
+   if (m->procwq != NULL)
+      m->parsafe = hash_new(256);
+
    create_processes(m, m->root);
 
+   if (m->parsafe != NULL) {
+      hash_free(m->parsafe);
+      m->parsafe = NULL;
+   }
+
    nvc_rusage(&m->ready_rusage);
 
    // Initialisation is described in LRM 93 section 12.6.4
 
+   m->resetting = true;
    reset_scope(m, m->root);
+   m->resetting = false;
 
    if (m->force_stop)
       return;   // Error in intialisation
@@ -2435,26 +2985,43 @@ static void update_property(rt_model_t *m, rt_prop_t *prop)
 
 static void sched_event(rt_model_t *m, void **pending, rt_wakeable_t *obj)
 {
+   // Anything registered during reset is assumed to be permanent
+   const bool is_static = m->resetting;
+
    if (*pending == NULL)
-      *pending = tag_pointer(obj, 1);
-   else if (pointer_tag(*pending) == 1) {
+      *pending = tag_pointer(obj, is_static ? PENDING_STATIC : PENDING_ONE);
+   else if (pointer_tag(*pending) != PENDING_LIST) {
       rt_wakeable_t *cur = untag_pointer(*pending, rt_wakeable_t);
-      if (cur == obj)
+      const bool cur_static = pointer_tag(*pending) == PENDING_STATIC;
+      if (cur == obj) {
+         if (is_static)
+            *pending = tag_pointer(obj, PENDING_STATIC);
          return;
+      }
 
       rt_pending_t *p = xmalloc_flex(sizeof(rt_pending_t), PENDING_MIN,
                                      sizeof(rt_wakeable_t *));
       p->max = PENDING_MIN;
       p->count = 2;
-      p->wake[0] = cur;
-      p->wake[1] = obj;
+      p->nstatic = cur_static + is_static;
+
+      if (is_static && !cur_static) {
+         p->wake[0] = obj;
+         p->wake[1] = cur;
+      }
+      else {
+         p->wake[0] = cur;
+         p->wake[1] = obj;
+      }
 
-      *pending = tag_pointer(p, 0);
+      *pending = tag_pointer(p, PENDING_LIST);
    }
    else {
       rt_pending_t *p = untag_pointer(*pending, rt_pending_t);
 
-      for (int i = 0; i < p->count; i++) {
+      const unsigned first = is_static ? 0 : p->nstatic;
+      const unsigned last = is_static ? p->nstatic : p->count;
+      for (int i = first; i < last; i++) {
          if (p->wake[i] == NULL || p->wake[i] == obj) {
             p->wake[i] = obj;
             return;
@@ -2465,23 +3032,41 @@ static void sched_event(rt_model_t *m, void **pending, rt_wakeable_t *obj)
          p->max = MAX(PENDING_MIN, p->max * 2);
          p = xrealloc_flex(p, sizeof(rt_pending_t), p->max,
                            sizeof(rt_wakeable_t *));
-         *pending = tag_pointer(p, 0);
+         *pending = tag_pointer(p, PENDING_LIST);
       }
 
-      p->wake[p->count++] = obj;
+      if (is_static) {
+         // Move the first dynamic entry to the end to make space
+         p->wake[p->count++] = p->wake[p->nstatic];
+         p->wake[p->nstatic++] = obj;
+      }
+      else
+         p->wake[p->count++] = obj;
    }
 }
 
 static void clear_event(rt_model_t *m, void **pending, rt_wakeable_t *obj)
 {
-   if (pointer_tag(*pending) == 1) {
+   if (*pending == NULL)
+      return;
+   else if (pointer_tag(*pending) != PENDING_LIST) {
       rt_wakeable_t *wake = untag_pointer(*pending, rt_wakeable_t);
       if (wake == obj)
          *pending = NULL;
    }
-   else if (*pending != NULL) {
+   else {
       rt_pending_t *p = untag_pointer(*pending, rt_pending_t);
-      for (int i = 0; i < p->count; i++) {
+
+      // Search the dynamic entries first as these are the most likely
+      // to be cleared
+      for (int i = p->nstatic; i < p->count; i++) {
+         if (p->wake[i] == obj) {
+            p->wake[i] = NULL;
+            return;
+         }
+      }
+
+      for (int i = 0; i < p->nstatic; i++) {
          if (p->wake[i] == obj) {
             p->wake[i] = NULL;
             return;
@@ -2553,46 +3138,51 @@ static bool will_observe_active(rt_nexus_t *n, const void *value, waveform_t *w)
    return false;
 }
 
-static void sched_driver(rt_model_t *m, rt_nexus_t *n, uint64_t after,
-                         uint64_t reject, const void *value, rt_proc_t *proc)
+static inline void sched_fast_driver(rt_model_t *m, rt_nexus_t *n,
+                                     const void *value)
 {
-   if (after == 0 && (n->flags & NET_F_FAST_DRIVER)) {
-      rt_source_t *d = &(n->sources);
-      assert(n->n_sources == 1);
-
-      waveform_t *w = &d->u.driver.waveforms;
-      w->when = m->now;
-      assert(w->next == NULL);
+   rt_source_t *d = &(n->sources);
+   assert(n->n_sources == 1);
 
-      rt_signal_t *signal = n->signal;
-      rt_source_t *d0 = &(signal->nexus.sources);
+   waveform_t *w = &d->u.driver.waveforms;
+   w->when = m->now;
+   assert(w->next == NULL);
 
-      if (d->fastqueued)
-         assert(m->next_is_delta);
-      else if ((signal->shared.flags & NET_F_FAST_DRIVER) && d0->sigqueued) {
-         assert(m->next_is_delta);
-         d->fastqueued = 1;
-      }
-      else if (!will_observe_active(n, value, w)) {
-         m->next_is_delta = true;
-         d->was_active = (n->active_delta == m->iteration);
-         n->active_delta = m->iteration + 1;
-         return;
-      }
-      else if (signal->shared.flags & NET_F_FAST_DRIVER) {
-         deferq_do(&m->driverq, async_fast_all_drivers, signal);
-         m->next_is_delta = true;
-         d0->sigqueued = 1;
-         d->fastqueued = 1;
-      }
-      else {
-         deferq_do(&m->driverq, async_fast_driver, d);
-         m->next_is_delta = true;
-         d->fastqueued = 1;
-      }
+   rt_signal_t *signal = n->signal;
+   rt_source_t *d0 = &(signal->nexus.sources);
 
-      copy_value_ptr(n, &w->value, value);
+   if (d->fastqueued)
+      assert(m->next_is_delta);
+   else if ((signal->shared.flags & NET_F_FAST_DRIVER) && d0->sigqueued) {
+      assert(m->next_is_delta);
+      d->fastqueued = 1;
+   }
+   else if (!will_observe_active(n, value, w)) {
+      m->next_is_delta = true;
+      d->was_active = (n->active_delta == m->iteration);
+      n->active_delta = m->iteration + 1;
+      return;
+   }
+   else if (signal->shared.flags & NET_F_FAST_DRIVER) {
+      deferq_do(&m->driverq, async_fast_all_drivers, signal);
+      m->next_is_delta = true;
+      d0->sigqueued = 1;
+      d->fastqueued = 1;
    }
+   else {
+      deferq_do(&m->driverq, async_fast_driver, d);
+      m->next_is_delta = true;
+      d->fastqueued = 1;
+   }
+
+   copy_value_ptr(n, &w->value, value);
+}
+
+static void sched_driver(rt_model_t *m, rt_nexus_t *n, uint64_t after,
+                         uint64_t reject, const void *value, rt_proc_t *proc)
+{
+   if (after == 0 && (n->flags & NET_F_FAST_DRIVER))
+      sched_fast_driver(m, n, value);
    else {
       rt_source_t *d = find_driver(n, proc);
       assert(d != NULL);
@@ -2798,7 +3388,7 @@ static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj)
          if (proc->wakeable.delayed) {
             // This process was already scheduled to run at a later
             // time so we need to delete it from the simulation queue
-            heap_delete(m->eventq_heap, heap_delete_proc_cb, proc);
+            eventq_delete(m, heap_delete_proc_cb, proc);
             proc->wakeable.delayed = false;
          }
 
@@ -2853,11 +3443,13 @@ static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj)
 
 static void wakeup_all(rt_model_t *m, void **pending)
 {
-   if (pointer_tag(*pending) == 1) {
+   if (*pending == NULL)
+      return;
+   else if (pointer_tag(*pending) != PENDING_LIST) {
       rt_wakeable_t *wake = untag_pointer(*pending, rt_wakeable_t);
       wakeup_one(m, wake);
    }
-   else if (*pending != NULL) {
+   else {
       rt_pending_t *p = untag_pointer(*pending, rt_pending_t);
       for (int i = 0; i < p->count; i++) {
          if (p->wake[i] != NULL)
@@ -2874,6 +3466,9 @@ static void notify_event(rt_model_t *m, rt_nexus_t *n)
    if (n->flags & NET_F_CACHE_EVENT)
       n->signal->shared.flags |= SIG_F_EVENT_FLAG;
 
+   if (unlikely(m->profile != NULL))
+      profile_event(m->profile, n->signal);
+
    wakeup_all(m, &(n->pending));
 }
 
@@ -2888,6 +3483,9 @@ static void put_effective(rt_model_t *m, rt_nexus_t *n, const void *value)
 
    n->active_delta = m->iteration;
 
+   if (unlikely(m->profile != NULL))
+      profile_transaction(m->profile, n->signal);
+
    if (!cmp_bytes(eff, value, valuesz)) {
       copy2(last, eff, value, valuesz);
       notify_event(m, n);
@@ -3175,6 +3773,218 @@ static void sync_event_cache(rt_model_t *m)
    }
 }
 
+static void tx_replay(rt_model_t *m, const par_task_t *pt)
+{
+   model_thread_t *thread = model_thread(m);
+   thread->active_obj = &(pt->proc->wakeable);
+   thread->active_scope = pt->proc->scope;
+
+   const uint8_t *txbuf = m->threads[pt->thread]->txbuf;
+
+   for (size_t pos = pt->start; pos < pt->end; ) {
+      const tx_record_t *tx = (const tx_record_t *)(txbuf + pos);
+      void *value = (void *)tx->value;
+
+      switch (tx->kind) {
+      case TX_SCHED_PROCESS:
+         x_sched_process(tx->after);
+         break;
+      case TX_SCHED_WAVEFORM:
+         x_sched_waveform(tx->ptr, tx->offset, value, tx->count,
+                          tx->after, tx->reject);
+         break;
+      case TX_SCHED_WAVEFORM_S:
+         x_sched_waveform_s(tx->ptr, tx->offset, *(uint64_t *)value,
+                            tx->after, tx->reject);
+         break;
+      case TX_SCHED_EVENT:
+         x_sched_event(tx->ptr, tx->offset, tx->count);
+         break;
+      case TX_SCHED_ACTIVE:
+         x_sched_active(tx->ptr, tx->offset, tx->count);
+         break;
+      case TX_CLEAR_EVENT:
+         x_clear_event(tx->ptr, tx->offset, tx->count);
+         break;
+      case TX_ENABLE_TRIGGER:
+         x_enable_trigger(tx->ptr);
+         break;
+      case TX_DISABLE_TRIGGER:
+         x_disable_trigger(tx->ptr);
+         break;
+      case TX_DISCONNECT:
+         x_disconnect(tx->ptr, tx->offset, tx->count, tx->after, tx->reject);
+         break;
+      case TX_FORCE:
+         x_force(tx->ptr, tx->offset, tx->count, value);
+         break;
+      case TX_RELEASE:
+         x_release(tx->ptr, tx->offset, tx->count);
+         break;
+      case TX_DEPOSIT:
+         x_deposit_signal(tx->ptr, tx->offset, tx->count, value);
+         break;
+      case TX_SCHED_DEPOSIT:
+         x_sched_deposit(tx->ptr, tx->offset, tx->count, value, tx->after);
+         break;
+      case TX_PUT_DRIVER:
+         x_put_driver(tx->ptr, tx->offset, tx->count, value);
+         break;
+      case TX_SCHED_INACTIVE:
+         x_sched_inactive();
+         break;
+      case TX_TRANSFER_SIGNAL:
+         {
+            const tx_transfer_t *tt = value;
+            x_transfer_signal(tx->ptr, tx->offset, tt->source, tt->soffset,
+                              tx->count, tx->after, tx->reject);
+         }
+         break;
+      }
+
+      pos += sizeof(tx_record_t) + ALIGN_UP(tx->nbytes, 8);
+   }
+
+   thread->active_obj = NULL;
+   thread->active_scope = NULL;
+}
+
+static void parallel_chunk_cb(void *context, void *arg)
+{
+   rt_model_t *m = context;
+   const par_chunk_t *chunk = arg;
+
+   MODEL_ENTRY(m);
+
+   const int my_id = thread_id();
+
+   model_thread_t *thread = model_thread(m);
+   if (thread->tlab == NULL)
+      thread->tlab = tlab_acquire(m->mspace);
+
+   for (unsigned i = chunk->first; i < chunk->last; i++) {
+      par_task_t *pt = &(m->partasks[i]);
+      assert(pt->proc->wakeable.pending);
+      pt->proc->wakeable.pending = false;
+
+      pt->thread = my_id;
+      pt->start  = thread->txlen;
+
+      run_process(m, pt->proc);
+
+      pt->end = thread->txlen;
+
+      // The process may have been aborted while holding the lock
+      if (unlikely(relaxed_load(&m->serial_owner) == my_id))
+         __serial_release(m);
+   }
+}
+
+static void parallel_segment(rt_model_t *m, unsigned first, unsigned last)
+{
+   // Run the processes in [first, last) concurrently and then replay
+   // their scheduling operations in the original order
+
+   for (int i = 0; i < MAX_THREADS; i++)
+      m->threads[i]->txlen = 0;
+
+   const unsigned count = last - first;
+   const unsigned nchunks = MIN(m->nthreads * PARALLEL_CHUNK,
+                                count / PARALLEL_CHUNK);
+   const unsigned per_chunk = (count + nchunks - 1) / nchunks;
+
+   m->parallel = true;
+
+   unsigned nchunk = 0;
+   for (unsigned i = first; i < last; i += per_chunk, nchunk++) {
+      m->parchunks[nchunk] = (par_chunk_t){ i, MIN(i + per_chunk, last) };
+      workq_do(m->procwq, parallel_chunk_cb, &(m->parchunks[nchunk]));
+   }
+
+   workq_start(m->procwq);
+   workq_drain(m->procwq);
+
+   m->parallel = false;
+
+   for (unsigned i = first; i < last; i++)
+      tx_replay(m, &(m->partasks[i]));
+}
+
+static void parallel_run(rt_model_t *m, deferq_t *dq)
+{
+   // Processes only read signal values during this phase so they can
+   // execute concurrently as long as any updates they schedule are
+   // applied afterwards in the same order as a serial run
+
+   assert(m->reschedq.count == 0);
+
+   const unsigned count = dq->count;
+
+   if (count > m->partasks_max) {
+      m->partasks_max = MAX(count, m->partasks_max * 2);
+      m->partasks = xrealloc_array(m->partasks, m->partasks_max,
+                                   sizeof(par_task_t));
+   }
+
+   unsigned neligible = 0;
+   for (unsigned i = 0; i < count; i++) {
+      const defer_task_t *task = &(dq->tasks[i]);
+      rt_proc_t *proc = NULL;
+
+      if (task->fn == async_run_process) {
+         proc = task->arg;
+         if (tree_kind(proc->where) != T_PROCESS)
+            proc = NULL;   // Verilog processes have other side effects
+         else if (proc->wakeable.serial)
+            proc = NULL;   // Touches shared state or produces output
+         else if (proc->wakeable.trigger != NULL) {
+            // Evaluate the trigger here so the workers only read the
+            // cached result
+            run_trigger(m, proc->wakeable.trigger);
+         }
+      }
+
+      m->partasks[i] = (par_task_t){ .proc = proc };
+
+      if (proc != NULL)
+         neligible++;
+   }
+
+   if (neligible < PARALLEL_MIN) {
+      deferq_run(m, dq);
+      return;
+   }
+
+   // Tasks which must run on the main thread split the queue into
+   // segments so each one still observes the effects of every task
+   // before it and none of those after it
+   for (unsigned first = 0; first < count; ) {
+      unsigned last = first;
+      while (last < count && m->partasks[last].proc != NULL)
+         last++;
+
+      if (last - first >= PARALLEL_MIN)
+         parallel_segment(m, first, last);
+      else {
+         for (unsigned i = first; i < last; i++)
+            (*dq->tasks[i].fn)(m, dq->tasks[i].arg);
+      }
+
+      if (last < count)
+         (*dq->tasks[last].fn)(m, dq->tasks[last].arg);
+
+      first = last + 1;
+   }
+
+   assert(dq->count == count);
+   dq->count = 0;
+
+   if (m->reschedq.count > 0) {
+      deferq_swap(&m->reschedq, dq);
+      deferq_run(m, dq);
+   }
+}
+
 static void model_cycle(rt_model_t *m)
 {
    // Simulation cycle is described in LRM 93 section 12.6.4
@@ -3185,7 +3995,7 @@ static void model_cycle(rt_model_t *m)
    if (is_delta_cycle)
       m->iteration = m->iteration + 1;
    else {
-      m->now = heap_min_key(m->eventq_heap);
+      m->now = eventq_min_key(m);
       m->iteration = 0;
    }
 
@@ -3205,7 +4015,7 @@ static void model_cycle(rt_model_t *m)
 
    if (!is_delta_cycle) {
       for (;;) {
-         void *e = heap_extract_min(m->eventq_heap);
+         void *e = eventq_extract_min(m);
          switch (pointer_tag(e)) {
          case EVENT_PROCESS:
             {
@@ -3235,9 +4045,9 @@ static void model_cycle(rt_model_t *m)
             break;
          }
 
-         if (heap_size(m->eventq_heap) == 0)
+         if (eventq_size(m) == 0)
             break;
-         else if (heap_min_key(m->eventq_heap) > m->now)
+         else if (eventq_min_key(m) > m->now)
             break;
       }
    }
@@ -3282,7 +4092,10 @@ static void model_cycle(rt_model_t *m)
 
    // Run all non-postponed processes and event callbacks
    deferq_swap(&m->next_procq, &m->procq);
-   deferq_run(m, &m->next_procq);
+   if (m->procwq != NULL && m->next_procq.count >= PARALLEL_MIN)
+      parallel_run(m, &m->next_procq);
+   else
+      deferq_run(m, &m->next_procq);
 
    run_callbacks(m, END_OF_PROCESSES);
 
@@ -3333,10 +4146,10 @@ static bool should_stop_now(rt_model_t *m, uint64_t stop_time)
    }
    else if (m->next_is_delta)
       return false;
-   else if (heap_size(m->eventq_heap) == 0)
+   else if (eventq_size(m) == 0)
       return true;
    else
-      return heap_min_key(m->eventq_heap) > stop_time;
+      return eventq_min_key(m) > stop_time;
 }
 
 static void check_liveness_properties(rt_model_t *m, rt_scope_t *s)
@@ -3508,6 +4321,9 @@ void deposit_signal(rt_model_t *m, rt_signal_t *s, const void *values,
          if (n->flags & NET_F_CACHE_EVENT)
             n->signal->shared.flags |= SIG_F_EVENT_FLAG;
 
+         if (unlikely(m->profile != NULL))
+            profile_event(m->profile, n->signal);
+
          wakeup_all(m, &(n->pending));
       }
 
@@ -3551,7 +4367,7 @@ void sched_deposit(rt_model_t *m, rt_signal_t *s, const void *values,
          }
          else if (after > 0) {
             void *e = tag_pointer(src, EVENT_PSEUDO);
-            heap_insert(m->eventq_heap, m->now + after, e);
+            eventq_insert(m, m->now + after, e);
          }
 
          src->pseudoqueued = 1;  // TODO: should be after == 0 branch
@@ -3576,10 +4392,10 @@ int64_t model_now(rt_model_t *m, unsigned *deltas)
 
 int64_t model_next_time(rt_model_t *m)
 {
-   if (heap_size(m->eventq_heap) == 0)
+   if (eventq_size(m) == 0)
       return TIME_HIGH;
    else
-      return heap_min_key(m->eventq_heap);
+      return eventq_min_key(m);
 }
 
 void model_stop(rt_model_t *m)
@@ -3613,7 +4429,7 @@ void model_set_timeout_cb(rt_model_t *m, uint64_t when, rt_event_fn_t fn,
    assert(when > m->now);   // TODO: delta timeouts?
 
    void *e = tag_pointer(cb, EVENT_TIMEOUT);
-   heap_insert(m->eventq_heap, when, e);
+   eventq_insert(m, when, e);
 }
 
 rt_watch_t *watch_new(rt_model_t *m, sig_event_fn_t fn, void *user,
@@ -4023,7 +4839,12 @@ void x_sched_process(int64_t delay)
    TRACE("schedule process %s delay=%s", istr(proc->name), trace_time(delay));
 
    check_delay(delay);
-   deltaq_insert_proc(get_model(), delay, proc);
+
+   rt_model_t *m = get_model();
+   if (unlikely(m->parallel))
+      tx_log(m, TX_SCHED_PROCESS, NULL, 0, 0, delay, 0, NULL, 0);
+   else
+      deltaq_insert_proc(m, delay, proc);
 }
 
 void x_sched_inactive(void)
@@ -4031,6 +4852,11 @@ void x_sched_inactive(void)
    rt_proc_t *proc = get_active_proc();
    rt_model_t *m = get_model();
 
+   if (unlikely(m->parallel)) {
+      tx_log(m, TX_SCHED_INACTIVE, NULL, 0, 0, 0, 0, NULL, 0);
+      return;
+   }
+
    TRACE("schedule process %s in inactive region", istr(proc->name));
 
    set_pending(&proc->wakeable);
@@ -4038,6 +4864,32 @@ void x_sched_inactive(void)
    m->next_is_delta = true;
 }
 
+void x_sched_delta_s(sig_shared_t *ss, uint32_t offset, uint64_t scalar)
+{
+   rt_signal_t *s = container_of(ss, rt_signal_t, shared);
+   RT_LOCK(s->lock);
+
+   TRACE("_sched_delta_s %s+%d value=%"PRIi64, istr(tree_ident(s->where)),
+         offset, scalar);
+
+   rt_proc_t *proc = get_active_proc();
+   check_postponed(0, proc);
+
+   rt_model_t *m = get_model();
+   if (unlikely(m->parallel)) {
+      tx_log(m, TX_SCHED_WAVEFORM_S, ss, offset, 1, 0, 0,
+             &scalar, sizeof(scalar));
+      return;
+   }
+
+   rt_nexus_t *n = split_nexus(m, s, offset, 1);
+
+   if (likely(n->flags & NET_F_FAST_DRIVER))
+      sched_fast_driver(m, n, &scalar);
+   else
+      sched_driver(m, n, 0, 0, &scalar, proc);
+}
+
 void x_sched_waveform_s(sig_shared_t *ss, uint32_t offset, uint64_t scalar,
                         int64_t after, int64_t reject)
 {
@@ -4055,6 +4907,12 @@ void x_sched_waveform_s(sig_shared_t *ss, uint32_t offset, uint64_t scalar,
    check_reject_limit(s, after, reject);
 
    rt_model_t *m = get_model();
+   if (unlikely(m->parallel)) {
+      tx_log(m, TX_SCHED_WAVEFORM_S, ss, offset, 1, after, reject,
+             &scalar, sizeof(scalar));
+      return;
+   }
+
    rt_nexus_t *n = split_nexus(m, s, offset, 1);
 
    sched_driver(m, n, after, reject, &scalar, proc);
@@ -4078,6 +4936,12 @@ void x_sched_waveform(sig_shared_t *ss, uint32_t offset, void *values,
    check_reject_limit(s, after, reject);
 
    rt_model_t *m = get_model();
+   if (unlikely(m->parallel)) {
+      tx_log(m, TX_SCHED_WAVEFORM, ss, offset, count, after, reject,
+             values, count * s->nexus.size);
+      return;
+   }
+
    rt_nexus_t *n = split_nexus(m, s, offset, count);
    char *vptr = values;
    for (; count > 0; n = n->chain) {
@@ -4107,6 +4971,12 @@ void x_transfer_signal(sig_shared_t *target_ss, uint32_t toffset,
    check_reject_limit(target, after, reject);
 
    rt_model_t *m = get_model();
+   if (unlikely(m->parallel)) {
+      const tx_transfer_t tt = { source_ss, soffset };
+      tx_log(m, TX_TRANSFER_SIGNAL, target_ss, toffset, count, after, reject,
+             &tt, sizeof(tt));
+      return;
+   }
 
    rt_transfer_t *t = static_alloc(m, sizeof(rt_transfer_t));
    t->proc   = proc;
@@ -4145,18 +5015,19 @@ int32_t x_test_net_event(sig_shared_t *ss, uint32_t offset, int32_t count)
 
    int32_t result = 0;
    rt_model_t *m = get_model();
-   rt_nexus_t *n = split_nexus(m, s, offset, count);
-   for (; count > 0; n = n->chain) {
+   int skip = offset;
+   rt_nexus_t *n = find_nexus(m, s, &skip);
+   for (; count > 0; n = n->chain, skip = 0) {
       if (n->last_event == m->now && n->event_delta == m->iteration) {
          result = 1;
          break;
       }
 
-      count -= n->width;
-      assert(count >= 0);
+      count -= n->width - skip;
    }
 
    if (ss->size == s->nexus.size) {
+      MODEL_SERIAL(m);
       assert(!(ss->flags & SIG_F_CACHE_EVENT));   // Should have taken fast-path
       ss->flags |= SIG_F_CACHE_EVENT | (result ? SIG_F_EVENT_FLAG : 0);
       s->nexus.flags |= NET_F_CACHE_EVENT;
@@ -4175,13 +5046,13 @@ int32_t x_test_net_active(sig_shared_t *ss, uint32_t offset, int32_t count)
          istr(tree_ident(s->where)), offset, count);
 
    rt_model_t *m = get_model();
-   rt_nexus_t *n = split_nexus(m, s, offset, count);
-   for (; count > 0; n = n->chain) {
+   int skip = offset;
+   rt_nexus_t *n = find_nexus(m, s, &skip);
+   for (; count > 0; n = n->chain, skip = 0) {
       if (nexus_active(m, n))
          return 1;
 
-      count -= n->width;
-      assert(count >= 0);
+      count -= n->width - skip;
    }
 
    return 0;
@@ -4198,6 +5069,11 @@ void x_sched_event(sig_shared_t *ss, uint32_t offset, int32_t count)
    rt_wakeable_t *obj = get_active_wakeable();
 
    rt_model_t *m = get_model();
+   if (unlikely(m->parallel)) {
+      tx_log(m, TX_SCHED_EVENT, ss, offset, count, 0, 0, NULL, 0);
+      return;
+   }
+
    rt_nexus_t *n = split_nexus(m, s, offset, count);
    for (; count > 0; n = n->chain) {
       sched_event(m, &(n->pending), obj);
@@ -4216,6 +5092,11 @@ void x_clear_event(sig_shared_t *ss, uint32_t offset, int32_t count)
          istr(tree_ident(s->where)), offset, count);
 
    rt_model_t *m = get_model();
+   if (unlikely(m->parallel)) {
+      tx_log(m, TX_CLEAR_EVENT, ss, offset, count, 0, 0, NULL, 0);
+      return;
+   }
+
    rt_proc_t *proc = get_active_proc();
    rt_nexus_t *n = split_nexus(m, s, offset, count);
    for (; count > 0; n = n->chain) {
@@ -4235,7 +5116,12 @@ void x_sched_active(sig_shared_t *ss, uint32_t offset, int32_t count)
          offset, count);
 
    rt_wakeable_t *obj = get_active_wakeable();
+
    rt_model_t *m = get_model();
+   if (unlikely(m->parallel)) {
+      tx_log(m, TX_SCHED_ACTIVE, ss, offset, count, 0, 0, NULL, 0);
+      return;
+   }
 
    rt_nexus_t *n = split_nexus(m, s, offset, count);
    for (; count > 0; n = n->chain) {
@@ -4260,7 +5146,10 @@ void x_enable_trigger(rt_trigger_t *trigger)
    rt_wakeable_t *obj = get_active_wakeable();
    rt_model_t *m = get_model();
 
-   sched_event(m, &(trigger->pending), obj);
+   if (unlikely(m->parallel))
+      tx_log(m, TX_ENABLE_TRIGGER, trigger, 0, 0, 0, 0, NULL, 0);
+   else
+      sched_event(m, &(trigger->pending), obj);
 }
 
 void x_disable_trigger(rt_trigger_t *trigger)
@@ -4270,7 +5159,10 @@ void x_disable_trigger(rt_trigger_t *trigger)
    rt_wakeable_t *obj = get_active_wakeable();
    rt_model_t *m = get_model();
 
-   clear_event(m, &(trigger->pending), obj);
+   if (unlikely(m->parallel))
+      tx_log(m, TX_DISABLE_TRIGGER, trigger, 0, 0, 0, 0, NULL, 0);
+   else
+      clear_event(m, &(trigger->pending), obj);
 }
 
 void x_enter_state(int32_t state, bool strong)
@@ -4311,13 +5203,13 @@ int64_t x_last_event(sig_shared_t *ss, uint32_t offset, int32_t count)
    int64_t last = TIME_HIGH;
 
    rt_model_t *m = get_model();
-   rt_nexus_t *n = split_nexus(m, s, offset, count);
-   for (; count > 0; n = n->chain) {
+   int skip = offset;
+   rt_nexus_t *n = find_nexus(m, s, &skip);
+   for (; count > 0; n = n->chain, skip = 0) {
       if (n->last_event <= m->now)
          last = MIN(last, m->now - n->last_event);
 
-      count -= n->width;
-      assert(count >= 0);
+      count -= n->width - skip;
    }
 
    return last;
@@ -4334,12 +5226,12 @@ int64_t x_last_active(sig_shared_t *ss, uint32_t offset, int32_t count)
    int64_t last = TIME_HIGH;
 
    rt_model_t *m = get_model();
-   rt_nexus_t *n = split_nexus(m, s, offset, count);
-   for (; count > 0; n = n->chain) {
+   int skip = offset;
+   rt_nexus_t *n = find_nexus(m, s, &skip);
+   for (; count > 0; n = n->chain, skip = 0) {
       last = MIN(last, nexus_last_active(m, n));
 
-      count -= n->width;
-      assert(count >= 0);
+      count -= n->width - skip;
    }
 
    return last;
@@ -4491,9 +5383,11 @@ bool x_driving(sig_shared_t *ss, uint32_t offset, int32_t count)
    int ntotal = 0, ndriving = 0;
    bool found = false;
    rt_model_t *m = get_model();
+
    rt_proc_t *proc = get_active_proc();
-   rt_nexus_t *n = split_nexus(m, s, offset, count);
-   for (; count > 0; n = n->chain) {
+   int skip = offset;
+   rt_nexus_t *n = find_nexus(m, s, &skip);
+   for (; count > 0; n = n->chain, skip = 0) {
       if (n->n_sources > 0) {
          rt_source_t *src = find_driver(n, proc);
          if (src != NULL) {
@@ -4503,8 +5397,7 @@ bool x_driving(sig_shared_t *ss, uint32_t offset, int32_t count)
       }
 
       ntotal++;
-      count -= n->width;
-      assert(count >= 0);
+      count -= n->width - skip;
    }
 
    if (!found)
@@ -4523,20 +5416,21 @@ void *x_driving_value(sig_shared_t *ss, uint32_t offset, int32_t count)
          offset, count);
 
    rt_model_t *m = get_model();
-   rt_nexus_t *n = split_nexus(m, s, offset, count);
+   int skip = offset;
+   rt_nexus_t *n = find_nexus(m, s, &skip);
 
    rt_proc_t *proc = get_active_proc();
    if (proc->wakeable.reschedule) {   // Called in output conversion
       if (n->flags & NET_F_EFFECTIVE)
-         return nexus_driving(n);
+         return (uint8_t *)nexus_driving(n) + skip * n->size;
       else
-         return nexus_effective(n);
+         return (uint8_t *)nexus_effective(n) + skip * n->size;
    }
 
    void *result = tlab_alloc(model_thread(m)->tlab, s->shared.size);
 
    uint8_t *p = result;
-   for (; count > 0; n = n->chain) {
+   for (; count > 0; n = n->chain, skip = 0) {
       rt_source_t *src = find_driver(n, proc);
       if (src == NULL)
          jit_msg(NULL, DIAG_FATAL, "process %s does not contain a driver "
@@ -4548,11 +5442,11 @@ void *x_driving_value(sig_shared_t *ss, uint32_t offset, int32_t count)
       else
          driving = value_ptr(n, &(src->u.driver.waveforms.value));
 
-      memcpy(p, driving, n->width * n->size);
-      p += n->width * n->size;
+      const int width = MIN(n->width - skip, count);
+      memcpy(p, driving + skip * n->size, width * n->size);
+      p += width * n->size;
 
-      count -= n->width;
-      assert(count >= 0);
+      count -= width;
    }
 
    return result;
@@ -4573,6 +5467,11 @@ void x_disconnect(sig_shared_t *ss, uint32_t offset, int32_t count,
    check_reject_limit(s, after, reject);
 
    rt_model_t *m = get_model();
+   if (unlikely(m->parallel)) {
+      tx_log(m, TX_DISCONNECT, ss, offset, count, after, reject, NULL, 0);
+      return;
+   }
+
    rt_nexus_t *n = split_nexus(m, s, offset, count);
    for (; count > 0; n = n->chain) {
       count -= n->width;
@@ -4594,7 +5493,11 @@ void x_force(sig_shared_t *ss, uint32_t offset, int32_t count, void *values)
 
    check_postponed(0, proc);
 
-   force_signal(m, s, values, offset, count);
+   if (unlikely(m->parallel))
+      tx_log(m, TX_FORCE, ss, offset, count, 0, 0, values,
+             count * s->nexus.size);
+   else
+      force_signal(m, s, values, offset, count);
 }
 
 void x_release(sig_shared_t *ss, uint32_t offset, int32_t count)
@@ -4609,7 +5512,10 @@ void x_release(sig_shared_t *ss, uint32_t offset, int32_t count)
 
    check_postponed(0, proc);
 
-   release_signal(m, s, offset, count);
+   if (unlikely(m->parallel))
+      tx_log(m, TX_RELEASE, ss, offset, count, 0, 0, NULL, 0);
+   else
+      release_signal(m, s, offset, count);
 }
 
 void x_deposit_signal(sig_shared_t *ss, uint32_t offset, int32_t count,
@@ -4618,7 +5524,11 @@ void x_deposit_signal(sig_shared_t *ss, uint32_t offset, int32_t count,
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
    rt_model_t *m = get_model();
 
-   deposit_signal(m, s, values, offset, count);
+   if (unlikely(m->parallel))
+      tx_log(m, TX_DEPOSIT, ss, offset, count, 0, 0, values,
+             count * s->nexus.size);
+   else
+      deposit_signal(m, s, values, offset, count);
 }
 
 void x_sched_deposit(sig_shared_t *ss, uint32_t offset, int32_t count,
@@ -4627,7 +5537,11 @@ void x_sched_deposit(sig_shared_t *ss, uint32_t offset, int32_t count,
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
    rt_model_t *m = get_model();
 
-   sched_deposit(m, s, values, offset, count, after, true);
+   if (unlikely(m->parallel))
+      tx_log(m, TX_SCHED_DEPOSIT, ss, offset, count, after, 0, values,
+             count * s->nexus.size);
+   else
+      sched_deposit(m, s, values, offset, count, after, true);
 }
 
 void x_put_driver(sig_shared_t *ss, uint32_t offset, int32_t count,
@@ -4640,6 +5554,13 @@ void x_put_driver(sig_shared_t *ss, uint32_t offset, int32_t count,
 
    rt_proc_t *proc = get_active_proc();
    rt_model_t *m = get_model();
+
+   if (unlikely(m->parallel)) {
+      tx_log(m, TX_PUT_DRIVER, ss, offset, count, 0, 0, values,
+             count * s->nexus.size);
+      return;
+   }
+
    rt_nexus_t *n = split_nexus(m, s, offset, count);
    const char *vptr = values;
    for (; count > 0; n = n->chain) {
@@ -4739,6 +5660,7 @@ void *x_function_trigger(jit_handle_t handle, unsigned nargs,
                          const jit_scalar_t *args)
 {
    rt_model_t *m = get_model();
+   MODEL_SERIAL(m);
 
    uint64_t hash = mix_bits_32(handle);
    for (int i = 0; i < nargs; i++)
@@ -4753,6 +5675,7 @@ void *x_function_trigger(jit_handle_t handle, unsigned nargs,
 rt_trigger_t *x_or_trigger(rt_trigger_t *left, rt_trigger_t *right)
 {
    rt_model_t *m = get_model();
+   MODEL_SERIAL(m);
 
    uint64_t hash = mix_bits_64(left) ^ mix_bits_64(right);
 
@@ -4769,6 +5692,7 @@ rt_trigger_t *x_or_trigger(rt_trigger_t *left, rt_trigger_t *right)
 void *x_cmp_trigger(sig_shared_t *ss, uint32_t offset, int64_t right)
 {
    rt_model_t *m = get_model();
+   MODEL_SERIAL(m);
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
 
    uint64_t hash = mix_bits_64(s) ^ mix_bits_32(offset) ^ mix_bits_64(right);
@@ -4788,6 +5712,7 @@ void *x_cmp_trigger(sig_shared_t *ss, uint32_t offset, int64_t right)
 void *x_level_trigger(sig_shared_t *ss, uint32_t offset, int32_t count)
 {
    rt_model_t *m = get_model();
+   MODEL_SERIAL(m);
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
 
    uint64_t hash = mix_bits_64(s) ^ mix_bits_32(offset) ^ mix_bits_32(count);
@@ -40,6 +40,34 @@
 
 STATIC_ASSERT(OVERRUN_MARGIN % LINE_SIZE == 0);
 
+// Free runs are segregated into bins by the base two logarithm of their
+// size in lines with the last bin holding all larger runs
+#define NUM_BINS 16
+
+// Small objects are allocated from per-thread caches of free lines
+// which are always a whole number of 64-line head mask words so
+// threads can update the mask without locking
+#define SMALL_LINES 32
+#define CACHE_LINES 256
+#define MASK_LINES  64
+
+STATIC_ASSERT(CACHE_LINES % MASK_LINES == 0);
+
+// Heaps at least this large are marked in parallel by default
+#define PARALLEL_HEAP (64 * 1024 * 1024)
+
+// Number of grey objects moved at once between a marking thread and
+// the shared pool
+#define MARK_BATCH 64
+
+// Objects that survive a collection are promoted to the old generation
+// and are only traced again by a full collection or if the write
+// barrier marks one of their cards dirty
+#define CARD_SIZE  (1 << MSPACE_CARD_SHIFT)
+#define CARD_LINES (CARD_SIZE / LINE_SIZE)
+
+STATIC_ASSERT(CARD_SIZE % LINE_SIZE == 0);
+
 typedef A(uint64_t) work_list_t;
 typedef struct _linked_tlab linked_tlab_t;
 
@@ -59,8 +87,14 @@ struct _mptr {
 };
 
 typedef struct {
+   mspace_t         *mspace;
+   bool              minor;
    bit_mask_t        markmask;
+   bit_mask_t        pinmask;
    work_list_t       worklist;
+   work_list_t       pinned;
+   int               pool_lock;
+   int               active;
    struct cpu_state  cpu[MAX_THREADS];
 #if ASAN_ENABLED
    void             *fake_stack[MAX_THREADS];
@@ -75,6 +109,12 @@ struct _free_list {
    size_t       size;
 };
 
+typedef struct {
+   char *next;
+   char *limit;
+   bool  busy;
+} __attribute__((aligned(64))) line_cache_t;
+
 struct _mspace {
    nvc_lock_t       lock;
    size_t           maxsize;
@@ -84,22 +124,58 @@ struct _mspace {
    mptr_t           roots;
    mptr_t           free_mptrs;
    mspace_oom_fn_t  oomfn;
-   free_list_t     *free_list;
+   free_list_t     *free_bins[NUM_BINS];
    uint64_t         create_us;
    linked_tlab_t   *live_tlabs;
    linked_tlab_t   *free_tlabs;
    unsigned         total_gc;
    unsigned         num_cycles;
+   unsigned         num_minor;
+   int              gc_threads;
+   bool             generational;
+   bit_mask_t       oldmask;
+   size_t           oldlines;
+   size_t           major_limit;
+   uint8_t         *cards;
 #ifdef DEBUG
    bool             stress;
 #endif
+   line_cache_t     caches[MAX_THREADS];
 };
 
 static intptr_t *stack_limit[MAX_THREADS];
 
-static void mspace_gc(mspace_t *m);
+static void mspace_gc(mspace_t *m, bool major);
 static bool is_mspace_ptr(mspace_t *m, char *p);
 
+static inline int mspace_bin(size_t nlines)
+{
+   assert(nlines > 0);
+   return MIN(63 - __builtin_clzll(nlines), NUM_BINS - 1);
+}
+
+static void mspace_add_free(mspace_t *m, char *ptr, size_t nlines)
+{
+   free_list_t *f = xmalloc(sizeof(free_list_t));
+   f->ptr  = ptr;
+   f->size = nlines * LINE_SIZE;
+
+   const int bin = mspace_bin(nlines);
+   f->next = m->free_bins[bin];
+   m->free_bins[bin] = f;
+}
+
+static void mspace_clear_bins(mspace_t *m)
+{
+   for (int i = 0; i < NUM_BINS; i++) {
+      for (free_list_t *it = m->free_bins[i], *tmp; it; it = tmp) {
+         tmp = it->next;
+         free(it);
+      }
+      m->free_bins[i] = NULL;
+   }
+}
+
 mspace_t *mspace_new(size_t size)
 {
    mspace_t *m = xcalloc(sizeof(mspace_t));
@@ -112,19 +188,25 @@ mspace_t *mspace_new(size_t size)
 
    DEBUG_ONLY(m->stress = opt_get_int(OPT_GC_STRESS));
 
+   const int gc_threads = opt_get_int(OPT_GC_THREADS);
+   if (gc_threads > 0)
+      m->gc_threads = MIN(gc_threads, MAX_THREADS / 2);
+   else if (m->maxsize >= PARALLEL_HEAP)
+      m->gc_threads = MIN(nvc_nprocs(), DEFAULT_THREADS);
+   else
+      m->gc_threads = 1;
+
+   m->generational = opt_get_int(OPT_GC_GENERATIONAL);
+
    m->space = map_huge_pages(LINE_SIZE, m->maxsize);
+   m->cards = xcalloc((m->maxsize + CARD_SIZE - 1) / CARD_SIZE);
 
    ASAN_POISON(m->space, m->maxsize);
 
    mask_init(&(m->headmask), m->maxlines);
    mask_setall(&(m->headmask));
 
-   free_list_t *f = xmalloc(sizeof(free_list_t));
-   f->next = NULL;
-   f->ptr  = m->space;
-   f->size = m->maxsize - OVERRUN_MARGIN;
-
-   m->free_list = f;
+   mspace_add_free(m, m->space, m->maxlines);
 
    m->create_us = get_timestamp_us();
    return m;
@@ -151,14 +233,12 @@ void mspace_destroy(mspace_t *m)
    if (opt_get_verbose(OPT_GC_VERBOSE, NULL) && m->num_cycles > 0) {
       const uint64_t destroy_us = get_timestamp_us();
       const double gc_frac = m->total_gc / (double)(destroy_us - m->create_us);
-      debugf("GC: %d collection cycles; %d us total; %.1f%% of overall "
-             "run time", m->num_cycles, m->total_gc, gc_frac * 100.0);
+      debugf("GC: %d collection cycles (%d minor); %d us total; %.1f%% of "
+             "overall run time", m->num_cycles, m->num_minor, m->total_gc,
+             gc_frac * 100.0);
    }
 
-   for (free_list_t *it = m->free_list, *tmp; it; it = tmp) {
-      tmp = it->next;
-      free(it);
-   }
+   mspace_clear_bins(m);
 
    for (mptr_t p = m->free_mptrs, tmp; p; p = tmp) {
       tmp = p->next;
@@ -166,7 +246,9 @@ void mspace_destroy(mspace_t *m)
    }
 
    mask_free(&(m->headmask));
+   mask_free(&(m->oldmask));
    nvc_munmap(m->space, m->maxsize);
+   free(m->cards);
    free(m);
 }
 
@@ -176,43 +258,117 @@ void mspace_stack_limit(void *limit)
    atomic_store(&(stack_limit[thread_id()]), limit);
 }
 
-static void *mspace_try_alloc(mspace_t *m, size_t size)
+static void mspace_commit(mspace_t *m, char *base, size_t nlines,
+                          size_t size)
 {
-   // Add one to size before rounding up to LINE_SIZE to allow a valid
-   // pointer to point at one element past the end of an array
-   const size_t nlines = (size + LINE_SIZE) / LINE_SIZE;
+   assert((uintptr_t)base % LINE_SIZE == 0);
+   assert(base >= m->space);
+   assert(base < m->space + m->maxsize);
+
+   ASAN_UNPOISON(base, size + OVERRUN_MARGIN - 1);
+
+   const ptrdiff_t line = (base - m->space) / LINE_SIZE;
+   mask_set(&(m->headmask), line);
+   if (nlines > 1)
+      mask_clear_range(&(m->headmask), line + 1, nlines - 1);
+
+   // Make sure the first fault to the page is a write to allocate THP
+   // on Linux
+   *(volatile char *)base = 0;
+}
+
+static void *mspace_cache_alloc(mspace_t *m, line_cache_t *c, size_t nlines,
+                                size_t size)
+{
+   // The garbage collector may suspend this thread at any point and
+   // must not reclaim the cache while it is being updated
+   relaxed_store(&(c->busy), true);
+   signal_barrier();
+
+   char *base = c->next;
+   if (base != NULL && base + nlines * LINE_SIZE <= c->limit) {
+      mspace_commit(m, base, nlines, size);
+      signal_barrier();
+      c->next = base + nlines * LINE_SIZE;
+   }
+   else
+      base = NULL;
+
+   signal_barrier();
+   relaxed_store(&(c->busy), false);
+
+   return base;
+}
+
+static bool mspace_refill_cache(mspace_t *m, line_cache_t *c)
+{
+   assert_lock_held(&(m->lock));
+
+   if (c->next != NULL && c->next < c->limit)
+      mspace_add_free(m, c->next, (c->limit - c->next) / LINE_SIZE);
+
+   c->next = c->limit = NULL;
+
+   // Any run of at least twice the mask word size contains one whole
+   // aligned word so only the first run in each bin needs checking
+   for (int bin = mspace_bin(MASK_LINES * 2); bin < NUM_BINS; bin++) {
+      free_list_t *f = m->free_bins[bin];
+      if (f == NULL)
+         continue;
+
+      const size_t first = (f->ptr - m->space) / LINE_SIZE;
+      const size_t last = first + f->size / LINE_SIZE;
+      const size_t start = ALIGN_UP(first, MASK_LINES);
+      const size_t end = MIN(start + CACHE_LINES, last & ~(MASK_LINES - 1));
+      assert(end > start);
+
+      m->free_bins[bin] = f->next;
+      free(f);
+
+      if (start > first)
+         mspace_add_free(m, m->space + first * LINE_SIZE, start - first);
+      if (last > end)
+         mspace_add_free(m, m->space + end * LINE_SIZE, last - end);
+
+      c->next  = m->space + start * LINE_SIZE;
+      c->limit = m->space + end * LINE_SIZE;
+      return true;
+   }
+
+   return false;
+}
+
+static void *mspace_bin_alloc(mspace_t *m, size_t nlines, size_t size)
+{
+   assert_lock_held(&(m->lock));
+
    const size_t asize = nlines * LINE_SIZE;
 
-   SCOPED_LOCK(m->lock);
+   // Every run in a bin above the first one searched is large enough
+   // so only the first and last bins need a linear scan
+   for (int bin = mspace_bin(nlines); bin < NUM_BINS; bin++) {
+      for (free_list_t **it = &(m->free_bins[bin]); *it; it = &((*it)->next)) {
+         free_list_t *f = *it;
+         assert(f->size % LINE_SIZE == 0);
 
-   for (free_list_t **it = &(m->free_list); *it; it = &((*it)->next)) {
-      assert((*it)->size % LINE_SIZE == 0);
-      if ((*it)->size >= asize) {
-         char *base = (*it)->ptr;
-         assert((uintptr_t)base % LINE_SIZE == 0);
-         assert(base >= m->space);
-         assert(base < m->space + m->maxsize);
-
-         ASAN_UNPOISON(base, size + OVERRUN_MARGIN - 1);
-
-         const ptrdiff_t line = (base - m->space) / LINE_SIZE;
-         mask_set(&(m->headmask), line);
-         if (nlines > 1)
-            mask_clear_range(&(m->headmask), line + 1, nlines - 1);
-
-         if ((*it)->size == asize) {
-            free_list_t *next = (*it)->next;
-            free(*it);
-            *it = next;
-         }
+         if (f->size < asize)
+            continue;
+
+         char *base = f->ptr;
+         mspace_commit(m, base, nlines, size);
+
+         *it = f->next;
+
+         if (f->size == asize)
+            free(f);
          else {
-            (*it)->size -= asize;
-            (*it)->ptr += asize;
-         }
+            f->size -= asize;
+            f->ptr += asize;
 
-         // Make sure the first fault to the page is a write to
-         // allocate THP on Linux
-         *(volatile char *)base = 0;
+            const int newbin = mspace_bin(f->size / LINE_SIZE);
+            f->next = m->free_bins[newbin];
+            m->free_bins[newbin] = f;
+         }
 
          return base;
       }
@@ -221,6 +377,32 @@ static void *mspace_try_alloc(mspace_t *m, size_t size)
    return NULL;
 }
 
+static void *mspace_try_alloc(mspace_t *m, size_t size)
+{
+   // Add one to size before rounding up to LINE_SIZE to allow a valid
+   // pointer to point at one element past the end of an array
+   const size_t nlines = (size + LINE_SIZE) / LINE_SIZE;
+
+   if (nlines <= SMALL_LINES) {
+      line_cache_t *c = &(m->caches[thread_id()]);
+
+      void *ptr = mspace_cache_alloc(m, c, nlines, size);
+      if (likely(ptr != NULL))
+         return ptr;
+
+      SCOPED_LOCK(m->lock);
+
+      if (mspace_refill_cache(m, c))
+         return mspace_cache_alloc(m, c, nlines, size);
+      else
+         return mspace_bin_alloc(m, nlines, size);
+   }
+   else {
+      SCOPED_LOCK(m->lock);
+      return mspace_bin_alloc(m, nlines, size);
+   }
+}
+
 void *mspace_alloc(mspace_t *m, size_t size)
 {
    if (size == 0)
@@ -230,17 +412,22 @@ void *mspace_alloc(mspace_t *m, size_t size)
    if (stack_limit[thread_id()] == NULL)
       fatal_trace("cannot allocate without setting stack limit");
    else if (m->stress)
-      mspace_gc(m);
+      mspace_gc(m, false);
 #endif
 
-   int retry = 1;
-   do {
+   // Fall back to a full collection if a minor collection did not free
+   // enough space
+   for (int attempt = 0; attempt < 2; attempt++) {
       void *ptr = mspace_try_alloc(m, size);
       if (ptr != NULL)
          return ptr;
 
-      mspace_gc(m);
-   } while (retry--);
+      mspace_gc(m, attempt > 0);
+   }
+
+   void *ptr = mspace_try_alloc(m, size);
+   if (ptr != NULL)
+      return ptr;
 
    if (m->oomfn) {
       (*m->oomfn)(m, size);
@@ -335,6 +522,18 @@ static bool tlab_on_list(linked_tlab_t *lt, linked_tlab_t *list)
 }
 #endif
 
+void tlab_init(tlab_t *t, mspace_t *m)
+{
+   memset(t, '\0', sizeof(tlab_t));
+
+   // Generated code marks cards inline using these fields and does
+   // nothing if the heap size is zero
+   t->mspace   = m;
+   t->heap     = m->space;
+   t->heapsize = m->generational ? m->maxsize : 0;
+   t->cards    = m->cards;
+}
+
 tlab_t *tlab_acquire(mspace_t *m)
 {
    SCOPED_LOCK(m->lock);
@@ -342,7 +541,7 @@ tlab_t *tlab_acquire(mspace_t *m)
    linked_tlab_t *lt = m->free_tlabs;
    if (lt == NULL) {
       lt = xmalloc(sizeof(linked_tlab_t) + TLAB_SIZE);
-      lt->tlab.mspace = m;
+      tlab_init(&(lt->tlab), m);
    }
    else {
       assert(!tlab_on_list(lt, m->live_tlabs));
@@ -418,30 +617,187 @@ static inline bool is_mspace_ptr(mspace_t *m, char *p)
    return p >= m->space && p < m->space + m->maxsize;
 }
 
-static void mspace_mark_root(mspace_t *m, intptr_t p, gc_state_t *state)
+static uint64_t mspace_object_at(mspace_t *m, char *p)
 {
-   if (is_mspace_ptr(m, (char *)p)) {
-      ptrdiff_t line = ((char *)p - m->space) / LINE_SIZE;
-      assert(line < UINT32_MAX);   // Enforced by MAX_HEAP
+   ptrdiff_t line = (p - m->space) / LINE_SIZE;
+   assert(line < UINT32_MAX);   // Enforced by MAX_HEAP
+
+   // Scan backwards to the start of the object
+   line = mask_scan_backwards(&(m->headmask), line);
+   assert(line != -1);
+
+   size_t objlen = 1;
+   if (line + 1 < m->maxlines)
+      objlen += mask_count_clear(&(m->headmask), line + 1);
+   assert(objlen < UINT32_MAX);
+
+   return ((uint64_t)line << 32) | objlen;
+}
+
+static void mspace_dirty_cards(mspace_t *m, size_t line, size_t count)
+{
+   const size_t ncards = (m->maxsize + CARD_SIZE - 1) / CARD_SIZE;
+   const size_t first = line / CARD_LINES;
+   const size_t last = MIN((line + count - 1) / CARD_LINES, ncards - 1);
+
+   for (size_t i = first; i <= last; i++)
+      relaxed_store(&(m->cards[i]), 1);
+}
+
+void mspace_write_barrier(mspace_t *m, void *ptr, size_t size)
+{
+   if (m->generational && is_mspace_ptr(m, ptr) && size > 0) {
+      const ptrdiff_t off = (char *)ptr - m->space;
+      const size_t count = (size + off % LINE_SIZE + LINE_SIZE - 1) / LINE_SIZE;
+      mspace_dirty_cards(m, off / LINE_SIZE, count);
+   }
+}
+
+static void mspace_mark_object(uint64_t enc, gc_state_t *state,
+                               work_list_t *wl)
+{
+   const uint32_t line = enc >> 32;
+   const uint32_t objlen = enc & 0xffffffff;
+
+   if (!mask_test(&(state->markmask), line)
+       && mask_claim_range(&(state->markmask), line, objlen))
+      APUSH(*wl, enc);
+}
+
+static void mspace_mark_root(mspace_t *m, intptr_t p, gc_state_t *state,
+                             work_list_t *wl)
+{
+   if (is_mspace_ptr(m, (char *)p))
+      mspace_mark_object(mspace_object_at(m, (char *)p), state, wl);
+}
 
-      // Scan backwards to the start of the object
-      line = mask_scan_backwards(&(m->headmask), line);
-      assert(line != -1);
+static void mspace_mark_stack_root(mspace_t *m, intptr_t p, gc_state_t *state)
+{
+   // Native code in the runtime may store into an object it holds on
+   // the stack without a write barrier so treat these objects as dirty
+   // for both this and the next collection
+   if (is_mspace_ptr(m, (char *)p)) {
+      const uint64_t enc = mspace_object_at(m, (char *)p);
+      mspace_mark_object(enc, state, &(state->worklist));
 
-      size_t objlen = 1;
-      if (line + 1 < m->maxlines)
-         objlen += mask_count_clear(&(m->headmask), line + 1);
-      assert(objlen < UINT32_MAX);
+      if (!m->generational || mask_test_and_set(&(state->pinmask), enc >> 32))
+         return;
 
-      if (!mask_test(&(state->markmask), line)) {
-         mask_set_range(&(state->markmask), line, objlen);
+      APUSH(state->pinned, enc);
 
-         uint64_t enc = ((uint64_t)line << 32) | objlen;
+      if (state->minor && mask_test(&(m->oldmask), enc >> 32))
          APUSH(state->worklist, enc);
+   }
+}
+
+__attribute__((no_sanitize_address))
+static void mspace_scan_object(mspace_t *m, uint64_t enc, gc_state_t *state,
+                               work_list_t *wl)
+{
+   const uint32_t line = enc >> 32;
+   const uint32_t objlen = enc & 0xffffffff;
+
+   for (size_t i = 0; i < objlen; i++) {
+      const ptrdiff_t off = (uintptr_t)(line + i) * LINE_SIZE;
+      intptr_t *words = (intptr_t *)(m->space + off);
+      for (int j = 0; j < LINE_WORDS; j++)
+         mspace_mark_root(m, words[j], state, wl);
+   }
+}
+
+__attribute__((no_sanitize_address))
+static void mspace_scan_cards(mspace_t *m, gc_state_t *state)
+{
+   // Old objects written since the last collection may now point to
+   // young objects
+   const size_t ncards = (m->maxsize + CARD_SIZE - 1) / CARD_SIZE;
+   for (size_t i = 0; i < ncards; i++) {
+      if (!m->cards[i])
+         continue;
+
+      const size_t first = i * CARD_LINES;
+      const size_t last = MIN(first + CARD_LINES, m->maxlines);
+      for (size_t line = first; line < last; line++) {
+         if (!mask_test(&(m->oldmask), line))
+            continue;
+
+         intptr_t *words = (intptr_t *)(m->space + line * LINE_SIZE);
+         for (int j = 0; j < LINE_WORDS; j++)
+            mspace_mark_root(m, words[j], state, &(state->worklist));
       }
    }
 }
 
+static void mspace_pool_lock(gc_state_t *state)
+{
+   // Cannot use nvc_lock here as it may need to park on a mutex held
+   // by a suspended thread
+   while (!atomic_cas(&(state->pool_lock), 0, 1))
+      progressive_backoff();
+}
+
+static void mspace_pool_unlock(gc_state_t *state)
+{
+   store_release(&(state->pool_lock), 0);
+}
+
+static bool mspace_mark_steal(gc_state_t *state, work_list_t *local)
+{
+   assert(local->count == 0);
+
+   atomic_add(&(state->active), -1);
+
+   for (;;) {
+      if (relaxed_load(&(state->worklist.count)) > 0) {
+         atomic_add(&(state->active), 1);
+
+         mspace_pool_lock(state);
+
+         for (int i = 0; i < MARK_BATCH && state->worklist.count > 0; i++)
+            APUSH(*local, APOP(state->worklist));
+
+         mspace_pool_unlock(state);
+
+         if (local->count > 0)
+            return true;
+
+         atomic_add(&(state->active), -1);
+      }
+      else if (atomic_load(&(state->active)) == 0)
+         return false;   // All threads idle and no work remaining
+      else
+         progressive_backoff();
+   }
+}
+
+static void mspace_mark_task(void *context, void *arg)
+{
+   gc_state_t *state = context;
+   mspace_t *m = state->mspace;
+
+   atomic_add(&(state->active), 1);
+
+   work_list_t local = AINIT;
+   while (mspace_mark_steal(state, &local)) {
+      while (local.count > 0) {
+         mspace_scan_object(m, APOP(local), state, &local);
+
+         // Share work if other threads are idle
+         if (local.count >= 2 * MARK_BATCH
+             && relaxed_load(&(state->worklist.count)) == 0) {
+            mspace_pool_lock(state);
+
+            for (int i = 0; i < MARK_BATCH; i++)
+               APUSH(state->worklist, APOP(local));
+
+            mspace_pool_unlock(state);
+         }
+      }
+   }
+
+   ACLEAR(local);
+}
+
 static void mspace_suspend_cb(int thread_id, struct cpu_state *cpu, void *arg)
 {
    gc_state_t *state = arg;
@@ -453,7 +809,7 @@ static void mspace_suspend_cb(int thread_id, struct cpu_state *cpu, void *arg)
 }
 
 __attribute__((no_sanitize_address, noinline))
-static void mspace_gc(mspace_t *m)
+static void mspace_gc(mspace_t *m, bool major)
 {
    const uint64_t start_ticks = get_timestamp_us();
 
@@ -466,13 +822,32 @@ static void mspace_gc(mspace_t *m)
    return;   // Cannot reliably suspend threads with tsan
 #endif
 
-   gc_state_t state = {};
+   if (m->gc_threads > 1)
+      gc_threads_start(m->gc_threads - 1);
+
+   gc_state_t state = { .mspace = m };
    mask_init(&(state.markmask), m->maxlines);
 
    SCOPED_LOCK(m->lock);
 
+   // Only trace objects allocated since the last collection unless the
+   // old generation has grown too large
+   state.minor = m->generational && !major && m->oldmask.size > 0
+      && m->oldlines <= m->major_limit;
+
+   if (state.minor)
+      mask_copy(&(state.markmask), &(m->oldmask));
+
+   if (m->generational)
+      mask_init(&(state.pinmask), m->maxlines);
+
    stop_world(mspace_suspend_cb, &state);
 
+   if (state.minor)
+      mspace_scan_cards(m, &state);
+
+   memset(m->cards, '\0', (m->maxsize + CARD_SIZE - 1) / CARD_SIZE);
+
    for (int i = 0; i < MAX_THREADS; i++) {
       if (get_thread(i) == NULL)
          continue;
@@ -482,13 +857,13 @@ static void mspace_gc(mspace_t *m)
          continue;
 
       for (int j = 0; j < MAX_CPU_REGS; j++)
-         mspace_mark_root(m, state.cpu[i].regs[j], &state);
+         mspace_mark_stack_root(m, state.cpu[i].regs[j], &state);
 
       intptr_t *stack_top = (intptr_t *)state.cpu[i].sp;
       assert(stack_top <= limit);   // Stack must grow down
 
       for (intptr_t *p = stack_top; p < limit; p++) {
-         mspace_mark_root(m, *p, &state);
+         mspace_mark_stack_root(m, *p, &state);
 
 #if ASAN_ENABLED
          // Address sanitiser relocates possibly-escaping stack
@@ -499,7 +874,7 @@ static void mspace_gc(mspace_t *m)
             if (__asan_addr_is_in_fake_stack(state.fake_stack[i], (void *)*p,
                                              &beg, &end)) {
                for (intptr_t *p2 = beg; p2 < (intptr_t *)end; p2++)
-                  mspace_mark_root(m, *p2, &state);
+                  mspace_mark_stack_root(m, *p2, &state);
             }
          }
 #endif
@@ -507,24 +882,37 @@ static void mspace_gc(mspace_t *m)
    }
 
    for (mptr_t p = m->roots; p; p = p->next)
-      mspace_mark_root(m, (intptr_t)p->ptr, &state);
+      mspace_mark_root(m, (intptr_t)p->ptr, &state, &state.worklist);
 
    for (linked_tlab_t *lt = m->live_tlabs; lt; lt = lt->next) {
       for (char *p = lt->tlab.data; p < lt->tlab.data + lt->tlab.alloc;
            p += sizeof(intptr_t))
-         mspace_mark_root(m, *(intptr_t *)p, &state);
+         mspace_mark_root(m, *(intptr_t *)p, &state, &state.worklist);
    }
 
-   while (state.worklist.count > 0) {
-      const uint64_t enc = APOP(state.worklist);
-      const uint32_t line = enc >> 32;
-      const uint32_t objlen = enc & 0xffffffff;
+   for (int i = 0; i < MAX_THREADS; i++) {
+      line_cache_t *c = &(m->caches[i]);
+      if (c->next == NULL)
+         continue;
+      else if (c->busy) {
+         // Thread was suspended while allocating from its cache so
+         // keep the unused lines out of the free list
+         const ptrdiff_t line = (c->next - m->space) / LINE_SIZE;
+         const size_t count = (c->limit - c->next) / LINE_SIZE;
+         if (count > 0)
+            mask_set_range(&(state.markmask), line, count);
+      }
+      else
+         c->next = c->limit = NULL;
+   }
 
-      for (size_t i = 0; i < objlen; i++) {
-         const ptrdiff_t off = (uintptr_t)(line + i) * LINE_SIZE;
-         intptr_t *words = (intptr_t *)(m->space + off);
-         for (int j = 0; j < LINE_WORDS; j++)
-            mspace_mark_root(m, words[j], &state);
+   int nthreads = 1;
+   if (m->gc_threads > 1)
+      nthreads = gc_threads_run(mspace_mark_task, &state);
+   else {
+      while (state.worklist.count > 0) {
+         const uint64_t enc = APOP(state.worklist);
+         mspace_scan_object(m, enc, &state, &state.worklist);
       }
    }
 
@@ -535,14 +923,14 @@ static void mspace_gc(mspace_t *m)
    }
 #endif
 
-   for (free_list_t *it = m->free_list, *tmp; it; it = tmp) {
-      tmp = it->next;
-      free(it);
-   }
-   m->free_list = NULL;
+   mspace_clear_bins(m);
+
+   // Keep each bin sorted by address
+   free_list_t **tails[NUM_BINS];
+   for (int i = 0; i < NUM_BINS; i++)
+      tails[i] = &(m->free_bins[i]);
 
    int freefrags = 0, freelines = 0;
-   free_list_t **tail = &(m->free_list);
    for (size_t line = 0; line < m->maxlines;) {
       const size_t clear = mask_count_clear(&(state.markmask), line);
       if (clear == 0)
@@ -553,8 +941,9 @@ static void mspace_gc(mspace_t *m)
          f->ptr  = m->space + line * LINE_SIZE;
          f->size = clear * LINE_SIZE;
 
-         *tail = f;
-         tail = &(f->next);
+         const int bin = mspace_bin(clear);
+         *tails[bin] = f;
+         tails[bin] = &(f->next);
 
          mask_set_range(&(m->headmask), line, clear);
 
@@ -565,22 +954,59 @@ static void mspace_gc(mspace_t *m)
       }
    }
 
+   if (m->generational) {
+      // Every surviving object is promoted to the old generation but
+      // the free lines held in a busy cache remain young
+      for (int i = 0; i < MAX_THREADS; i++) {
+         line_cache_t *c = &(m->caches[i]);
+         if (c->next != NULL && c->next < c->limit) {
+            const ptrdiff_t line = (c->next - m->space) / LINE_SIZE;
+            const size_t count = (c->limit - c->next) / LINE_SIZE;
+            mask_clear_range(&(state.markmask), line, count);
+         }
+      }
+
+      for (int i = 0; i < state.pinned.count; i++) {
+         const uint64_t enc = state.pinned.items[i];
+         mspace_dirty_cards(m, enc >> 32, enc & 0xffffffff);
+      }
+
+      mask_free(&(m->oldmask));
+      m->oldmask = state.markmask;
+      m->oldlines = mask_popcount(&(m->oldmask));
+
+      if (!state.minor)
+         m->major_limit = m->oldlines + (m->maxlines - m->oldlines) / 2;
+
+      state.markmask = (bit_mask_t){};
+   }
+
    start_world();
 
    if (opt_get_verbose(OPT_GC_VERBOSE, NULL)) {
+      const size_t live = m->generational
+         ? m->oldlines : mask_popcount(&(state.markmask));
+
       const int ticks = get_timestamp_us() - start_ticks;
-      debugf("GC: allocated %zd/%zu; fragmentation %.2g%% [%d us]",
-             mask_popcount(&(state.markmask)) * LINE_SIZE, m->maxsize,
-             ((double)(freefrags - 1) / (double)freelines) * 100.0, ticks);
+      debugf("GC: %s collection allocated %zd/%zu; fragmentation %.2g%% "
+             "[%d us, %d thread%s]", state.minor ? "minor" : "major",
+             live * LINE_SIZE, m->maxsize,
+             ((double)(freefrags - 1) / (double)freelines) * 100.0,
+             ticks, nthreads, nthreads == 1 ? "" : "s");
 
       m->total_gc += ticks;
       m->num_cycles++;
+
+      if (state.minor)
+         m->num_minor++;
    }
 
    mask_free(&(state.markmask));
+   mask_free(&(state.pinmask));
 
    assert(state.worklist.count == 0);
    ACLEAR(state.worklist);
+   ACLEAR(state.pinned);
 }
 
 void *mspace_find(mspace_t *m, void *ptr, size_t *size)
@@ -590,16 +1016,10 @@ void *mspace_find(mspace_t *m, void *ptr, size_t *size)
       return NULL;
    }
 
-   ptrdiff_t line = ((char *)ptr - m->space) / LINE_SIZE;
-
-   // Scan backwards to the start of the object
-   line = mask_scan_backwards(&(m->headmask), line);
-   assert(line != -1);
-
-   size_t objlen = 1;
-   if (line + 1 < m->maxlines)
-      objlen += mask_count_clear(&(m->headmask), line + 1);
+   const uint64_t enc = mspace_object_at(m, ptr);
+   const uint32_t line = enc >> 32;
+   const uint32_t objlen = enc & 0xffffffff;
 
    *size = objlen * LINE_SIZE;
-   return m->space + line * LINE_SIZE;
+   return m->space + (size_t)line * LINE_SIZE;
 }
@@ -29,11 +29,18 @@ typedef void (*mspace_oom_fn_t)(mspace_t *, size_t);
 
 #define TLAB_SIZE (64 * 1024)
 
+// Each card covers 1 << MSPACE_CARD_SHIFT bytes of the heap
+#define MSPACE_CARD_SHIFT 9
+
 // The code generator knows the layout of this struct
 typedef struct _tlab {
    mspace_t *mspace;
    uint32_t  alloc;
    uint32_t  limit;
+   char     *heap;       // Base address of the heap
+   size_t    heapsize;   // Zero unless the heap is generational
+   uint8_t  *cards;      // Card table indexed by offset from heap
+   uintptr_t pad;        // Keep data aligned to 16 bytes
    char      data[0];
 } tlab_t;
 
@@ -56,7 +63,9 @@ void *mspace_alloc_array(mspace_t *m, int nelems, size_t size);
 void *mspace_alloc_flex(mspace_t *m, size_t fixed, int nelems, size_t size);
 void mspace_set_oom_handler(mspace_t *m, mspace_oom_fn_t fn);
 void *mspace_find(mspace_t *m, void *ptr, size_t *size);
+void mspace_write_barrier(mspace_t *m, void *ptr, size_t size);
 
+void tlab_init(tlab_t *t, mspace_t *m);
 tlab_t *tlab_acquire(mspace_t *m);
 void tlab_release(tlab_t *t);
 void *tlab_alloc(tlab_t *t, size_t size);
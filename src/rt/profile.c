@@ -0,0 +1,236 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "array.h"
+#include "diag.h"
+#include "hash.h"
+#include "ident.h"
+#include "rt/model.h"
+#include "rt/profile.h"
+#include "rt/rt.h"
+#include "rt/structs.h"
+#include "thread.h"
+#include "tree.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROFILE_TOP_N 10
+
+typedef struct {
+   const void *obj;
+   uint64_t    ns;
+   uint64_t    count;
+   uint64_t    trans;
+} prof_entry_t;
+
+typedef A(prof_entry_t *) entry_list_t;
+
+typedef struct _rt_profile {
+   chash_t      *procmap;
+   chash_t      *sigmap;
+   nvc_lock_t    lock;
+   entry_list_t  procs;
+   entry_list_t  signals;
+} rt_profile_t;
+
+rt_profile_t *profile_new(void)
+{
+   rt_profile_t *p = xcalloc(sizeof(rt_profile_t));
+   p->procmap = chash_new(1024);
+   p->sigmap  = chash_new(1024);
+
+   return p;
+}
+
+void profile_free(rt_profile_t *p)
+{
+   for (int i = 0; i < p->procs.count; i++)
+      free(p->procs.items[i]);
+   ACLEAR(p->procs);
+
+   for (int i = 0; i < p->signals.count; i++)
+      free(p->signals.items[i]);
+   ACLEAR(p->signals);
+
+   chash_free(p->procmap);
+   chash_free(p->sigmap);
+   free(p);
+}
+
+static prof_entry_t *profile_get(rt_profile_t *p, chash_t *map,
+                                 entry_list_t *list, const void *obj)
+{
+   prof_entry_t *e = chash_get(map, obj);
+   if (likely(e != NULL))
+      return e;
+
+   prof_entry_t *new = xcalloc(sizeof(prof_entry_t));
+   new->obj = obj;
+
+   if ((e = chash_cas(map, obj, NULL, new)) != NULL) {
+      free(new);   // Another thread inserted it first
+      return e;
+   }
+
+   RT_LOCK(p->lock);
+   APUSH(*list, new);
+   return new;
+}
+
+void profile_process(rt_profile_t *p, rt_proc_t *proc, uint64_t ns)
+{
+   prof_entry_t *e = profile_get(p, p->procmap, &p->procs, proc);
+   relaxed_add(&e->ns, ns);
+   relaxed_add(&e->count, 1);
+}
+
+void profile_event(rt_profile_t *p, rt_signal_t *s)
+{
+   prof_entry_t *e = profile_get(p, p->sigmap, &p->signals, s);
+   relaxed_add(&e->count, 1);
+}
+
+void profile_transaction(rt_profile_t *p, rt_signal_t *s)
+{
+   prof_entry_t *e = profile_get(p, p->sigmap, &p->signals, s);
+   relaxed_add(&e->trans, 1);
+}
+
+static int profile_cmp_ns(const void *a, const void *b)
+{
+   const prof_entry_t *ea = *(const prof_entry_t **)a;
+   const prof_entry_t *eb = *(const prof_entry_t **)b;
+
+   if (ea->ns != eb->ns)
+      return ea->ns < eb->ns ? 1 : -1;
+   else
+      return ea->count < eb->count ? 1 : (ea->count > eb->count ? -1 : 0);
+}
+
+static int profile_cmp_count(const void *a, const void *b)
+{
+   const prof_entry_t *ea = *(const prof_entry_t **)a;
+   const prof_entry_t *eb = *(const prof_entry_t **)b;
+
+   if (ea->count != eb->count)
+      return ea->count < eb->count ? 1 : -1;
+   else
+      return ea->trans < eb->trans ? 1 : (ea->trans > eb->trans ? -1 : 0);
+}
+
+static void profile_signal_name(rt_signal_t *s, text_buf_t *tb)
+{
+   rt_scope_t *scope = s->parent;
+   while (is_signal_scope(scope))
+      scope = scope->parent;
+
+   get_path_name(scope, tb);
+   tb_append(tb, ':');
+
+   if (is_signal_scope(s->parent)) {
+      tb_istr(tb, s->parent->name);
+      tb_append(tb, '.');
+   }
+
+   tb_istr(tb, tree_ident(s->where));
+   tb_downcase(tb);
+}
+
+static void profile_write_folded(rt_profile_t *p, FILE *f)
+{
+   // One line per process in the format expected by flamegraph.pl
+   // with the hierarchical path as the stack and the time in
+   // nanoseconds as the sample count
+
+   for (int i = 0; i < p->procs.count; i++) {
+      const prof_entry_t *e = p->procs.items[i];
+      const rt_proc_t *proc = e->obj;
+
+      const char *name = istr(proc->name);
+      if (*name == ':')
+         name++;
+
+      for (const char *c = name; *c; c++)
+         fputc(*c == ':' ? ';' : *c, f);
+
+      fprintf(f, " %"PRIu64"\n", e->ns);
+   }
+}
+
+static void profile_print_summary(rt_profile_t *p)
+{
+   uint64_t total_ns = 0;
+   for (int i = 0; i < p->procs.count; i++)
+      total_ns += p->procs.items[i]->ns;
+
+   qsort(p->procs.items, p->procs.count, sizeof(prof_entry_t *),
+         profile_cmp_ns);
+
+   printf("\nTop processes by time:\n\n");
+   printf("%8s %6s %12s  %s\n", "Time", "%", "Wakeups", "Process");
+
+   const int nprocs = MIN(p->procs.count, PROFILE_TOP_N);
+   for (int i = 0; i < nprocs; i++) {
+      const prof_entry_t *e = p->procs.items[i];
+      const rt_proc_t *proc = e->obj;
+
+      printf("%6"PRIu64"ms %5.1f%% %12"PRIu64"  %s\n", e->ns / 1000000,
+             total_ns ? 100.0 * e->ns / total_ns : 0.0, e->count,
+             istr(proc->name));
+   }
+
+   qsort(p->signals.items, p->signals.count, sizeof(prof_entry_t *),
+         profile_cmp_count);
+
+   printf("\nTop signals by events:\n\n");
+   printf("%12s %12s  %s\n", "Events", "Transactions", "Signal");
+
+   LOCAL_TEXT_BUF tb = tb_new();
+
+   const int nsignals = MIN(p->signals.count, PROFILE_TOP_N);
+   for (int i = 0; i < nsignals; i++) {
+      const prof_entry_t *e = p->signals.items[i];
+
+      tb_rewind(tb);
+      profile_signal_name((rt_signal_t *)e->obj, tb);
+
+      printf("%12"PRIu64" %12"PRIu64"  %s\n", e->count, e->trans,
+             tb_get(tb));
+   }
+
+   printf("\n");
+   fflush(stdout);
+}
+
+void profile_write(rt_profile_t *p, const char *file)
+{
+   FILE *f = fopen(file, "w");
+   if (f == NULL)
+      fatal_errno("%s", file);
+
+   profile_write_folded(p, f);
+   fclose(f);
+
+   profile_print_summary(p);
+
+   notef("wrote profile for %u processes to %s", p->procs.count, file);
+}
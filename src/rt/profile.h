@@ -0,0 +1,32 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _RT_PROFILE_H
+#define _RT_PROFILE_H
+
+#include "prim.h"
+
+typedef struct _rt_profile rt_profile_t;
+
+rt_profile_t *profile_new(void);
+void profile_free(rt_profile_t *p);
+void profile_process(rt_profile_t *p, rt_proc_t *proc, uint64_t ns);
+void profile_event(rt_profile_t *p, rt_signal_t *s);
+void profile_transaction(rt_profile_t *p, rt_signal_t *s);
+void profile_write(rt_profile_t *p, const char *file);
+
+#endif  // _RT_PROFILE_H
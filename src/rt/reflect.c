@@ -778,11 +778,13 @@ static subtype_mirror *get_subtype_mirror(void *context, type_t type,
 
          cache->f_subtype_cache = tmp;
          cache->f_max_subtypes = new_max;
+         jit_write_barrier(&(cache->f_subtype_cache), sizeof(cache_elem_t *));
       }
 
       cache_elem_t *e = &(cache->f_subtype_cache[cache->f_num_subtypes++]);
       e->f_type = type;
       e->f_mirror = sm;
+      jit_write_barrier(&(e->f_mirror), sizeof(subtype_mirror *));
    }
 
    const char *simple = strrchr(istr(type_ident(type)), '.') + 1;
@@ -43,6 +43,7 @@ typedef enum {
    R_MEMO      = (1 << 0),
    R_IDENT     = (1 << 1),
    R_COMPOSITE = (1 << 2),
+   R_FOLD      = (1 << 3),
 } res_flags_t;
 
 #define NET_F_FORCED       (1 << 0)
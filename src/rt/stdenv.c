@@ -577,6 +577,8 @@ void _std_env_dir_open(directory_t *dir, const uint8_t *path_ptr,
    next += sizeof(ffi_uarray_t) + resolvedsz;
    assert(next == mem + memsz);
 
+   jit_write_barrier(dir, sizeof(*dir));
+
    *status = 0;
 }
 
@@ -627,6 +629,7 @@ void _std_env_file_name(ffi_uarray_t **ptr)
    const char *file = loc_file_str(&(stack->frames[1].loc));
    const char *sep = find_dir_separator(file);
    *ptr = to_line(sep ? sep + 1 : file);
+   jit_write_barrier(ptr, sizeof(ffi_uarray_t *));
 }
 
 DLLEXPORT
@@ -644,6 +647,8 @@ void _std_env_file_path(ffi_uarray_t **ptr)
       *sep = '\0';
       *ptr = to_absolute_path(file);
    }
+
+   jit_write_barrier(ptr, sizeof(ffi_uarray_t *));
 }
 
 DLLEXPORT
@@ -50,6 +50,7 @@ typedef struct {
    unsigned        delayed : 1;
    unsigned        zombie : 1;
    unsigned        reschedule : 1;
+   unsigned        serial : 1;
    rt_trigger_t   *trigger;
 } rt_wakeable_t;
 
@@ -105,9 +106,13 @@ struct waveform {
 
 STATIC_ASSERT(sizeof(waveform_t) <= 24);
 
+// Wakeables registered during reset, such as processes with a static
+// sensitivity list, are kept before the first nstatic entries and are
+// never rescanned when registering or clearing a dynamic wait
 typedef struct {
    unsigned       count;
    unsigned       max;
+   unsigned       nstatic;
    rt_wakeable_t *wake[];
 } rt_pending_t;
 
@@ -157,6 +162,7 @@ STATIC_ASSERT(sizeof(rt_source_t) <= 64);
 typedef struct {
    ffi_closure_t closure;
    res_flags_t   flags;
+   uint8_t       nlits;
    int8_t        tab2[16][16];
    int8_t        tab1[16];
 } res_memo_t;
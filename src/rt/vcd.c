@@ -0,0 +1,341 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "array.h"
+#include "rt/vcd.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define VCD_BUFSZ  (1 << 20)
+#define VCD_ID_MAX 8
+
+typedef struct {
+   uint32_t len;
+   bool     real;
+   char     id[VCD_ID_MAX];
+   uint8_t  idlen;
+} vcd_var_t;
+
+typedef enum {
+   VCD_DEFINITIONS,
+   VCD_DUMPVARS,
+   VCD_CHANGES,
+} vcd_state_t;
+
+typedef struct _vcd_writer {
+   FILE         *file;
+   bool          piped;
+   vcd_state_t   state;
+   char         *buf;
+   size_t        wptr;
+   A(vcd_var_t)  vars;
+} vcd_writer_t;
+
+// These match the names used by the FST reader when converting to VCD
+static const char *vartypes[] = {
+   "event", "integer", "parameter", "real", "real_parameter", "reg",
+   "supply0", "supply1", "time", "tri", "triand", "trior", "trireg",
+   "tri0", "tri1", "wand", "wire", "wor", "port", "sparray", "realtime",
+   "string", "bit", "logic", "int", "shortint", "longint", "byte", "enum",
+   "shortreal"
+};
+
+static const char *scopetypes[] = {
+   "module", "task", "function", "begin", "fork", "generate", "struct",
+   "union", "class", "interface", "package", "program",
+   "vhdl_architecture", "vhdl_procedure", "vhdl_function", "vhdl_record",
+   "vhdl_process", "vhdl_block", "vhdl_for_generate", "vhdl_if_generate",
+   "vhdl_generate", "vhdl_package"
+};
+
+STATIC_ASSERT(ARRAY_LEN(vartypes) == FST_VT_MAX + 1);
+STATIC_ASSERT(ARRAY_LEN(scopetypes) == FST_ST_MAX + 1);
+
+static void vcd_flush(vcd_writer_t *vw)
+{
+   if (vw->wptr > 0 && fwrite(vw->buf, vw->wptr, 1, vw->file) != 1)
+      fatal_errno("failed writing VCD file");
+
+   vw->wptr = 0;
+}
+
+static void vcd_write(vcd_writer_t *vw, const void *data, size_t len)
+{
+   if (unlikely(vw->wptr + len > VCD_BUFSZ)) {
+      vcd_flush(vw);
+
+      if (len > VCD_BUFSZ) {
+         if (fwrite(data, len, 1, vw->file) != 1)
+            fatal_errno("failed writing VCD file");
+         return;
+      }
+   }
+
+   memcpy(vw->buf + vw->wptr, data, len);
+   vw->wptr += len;
+}
+
+static inline void vcd_putc(vcd_writer_t *vw, char ch)
+{
+   if (unlikely(vw->wptr == VCD_BUFSZ))
+      vcd_flush(vw);
+
+   vw->buf[vw->wptr++] = ch;
+}
+
+__attribute__((format(printf, 2, 3)))
+static void vcd_printf(vcd_writer_t *vw, const char *fmt, ...)
+{
+   char buf[256];
+
+   va_list ap;
+   va_start(ap, fmt);
+   const int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+   va_end(ap);
+
+   if (len < sizeof(buf))
+      vcd_write(vw, buf, len);
+   else {
+      va_start(ap, fmt);
+      char *big LOCAL = xvasprintf(fmt, ap);
+      va_end(ap);
+
+      vcd_write(vw, big, len);
+   }
+}
+
+static void vcd_write_id(vcd_writer_t *vw, const vcd_var_t *var)
+{
+   vcd_write(vw, var->id, var->idlen);
+}
+
+static FILE *vcd_open(const char *file, bool *piped)
+{
+   *piped = false;
+
+#ifndef __MINGW32__
+   // Stream through an external compressor if the file name has a
+   // well-known extension
+   static const struct {
+      const char *ext;
+      const char *cmd;
+   } compressors[] = {
+      { ".gz", "gzip -c" },
+      { ".zst", "zstd -q -c" },
+      { ".xz", "xz -c" },
+   };
+
+   const size_t flen = strlen(file);
+   for (int i = 0; i < ARRAY_LEN(compressors); i++) {
+      const size_t elen = strlen(compressors[i].ext);
+      if (flen <= elen || strcmp(file + flen - elen, compressors[i].ext))
+         continue;
+
+      LOCAL_TEXT_BUF tb = tb_new();
+      tb_printf(tb, "%s > '", compressors[i].cmd);
+      for (const char *p = file; *p; p++) {
+         if (*p == '\'')
+            tb_cat(tb, "'\\''");
+         else
+            tb_append(tb, *p);
+      }
+      tb_append(tb, '\'');
+
+      FILE *f = popen(tb_get(tb), "w");
+      if (f == NULL)
+         fatal_errno("failed to run %s", compressors[i].cmd);
+
+      *piped = true;
+      return f;
+   }
+#endif
+
+   FILE *f = fopen(file, "wb");
+   if (f == NULL)
+      fatal_errno("%s", file);
+
+   return f;
+}
+
+vcd_writer_t *vcd_writer_new(const char *file, const char *version)
+{
+   vcd_writer_t *vw = xcalloc(sizeof(vcd_writer_t));
+   vw->file  = vcd_open(file, &vw->piped);
+   vw->buf   = xmalloc(VCD_BUFSZ);
+   vw->state = VCD_DEFINITIONS;
+
+   const time_t now = time(NULL);
+   char datebuf[64];
+   strftime(datebuf, sizeof(datebuf), "%a %b %d %H:%M:%S %Y", localtime(&now));
+
+   vcd_printf(vw, "$date\n\t%s\n$end\n", datebuf);
+   vcd_printf(vw, "$version\n\t%s\n$end\n", version);
+   vcd_printf(vw, "$timescale\n\t1fs\n$end\n");
+
+   return vw;
+}
+
+void vcd_writer_close(vcd_writer_t *vw, uint64_t now)
+{
+   vcd_emit_time_change(vw, now);
+
+   if (vw->state == VCD_DUMPVARS)
+      vcd_printf(vw, "$end\n");
+
+   vcd_flush(vw);
+
+   if (vw->piped) {
+#ifndef __MINGW32__
+      if (pclose(vw->file) != 0)
+         fatal("VCD compressor process failed");
+#endif
+   }
+   else if (fclose(vw->file) != 0)
+      fatal_errno("failed writing VCD file");
+
+   ACLEAR(vw->vars);
+   free(vw->buf);
+   free(vw);
+}
+
+void vcd_set_scope(vcd_writer_t *vw, enum fstScopeType st, const char *name)
+{
+   assert(vw->state == VCD_DEFINITIONS);
+   assert(st <= FST_ST_MAX);
+
+   vcd_printf(vw, "$scope %s %s $end\n", scopetypes[st], name);
+}
+
+void vcd_set_upscope(vcd_writer_t *vw)
+{
+   assert(vw->state == VCD_DEFINITIONS);
+   vcd_printf(vw, "$upscope $end\n");
+}
+
+fstHandle vcd_create_var(vcd_writer_t *vw, enum fstVarType vt, uint32_t len,
+                         const char *name, fstHandle alias)
+{
+   assert(vw->state == VCD_DEFINITIONS);
+   assert(vt <= FST_VT_MAX);
+
+   const bool real = vt == FST_VT_VCD_REAL || vt == FST_VT_VCD_REAL_PARAMETER
+      || vt == FST_VT_VCD_REALTIME || vt == FST_VT_SV_SHORTREAL;
+
+   const vcd_var_t *var;
+   fstHandle handle;
+   if (alias != 0) {
+      assert(alias <= vw->vars.count);
+      var = &(vw->vars.items[alias - 1]);
+      handle = alias;
+   }
+   else {
+      vcd_var_t new = { .len = len, .real = real };
+
+      // Same identifier encoding as the FST reader
+      for (unsigned value = vw->vars.count + 1; value; value /= 94) {
+         assert(new.idlen < VCD_ID_MAX);
+         value--;
+         new.id[new.idlen++] = '!' + value % 94;
+      }
+
+      APUSH(vw->vars, new);
+      var = &(vw->vars.items[vw->vars.count - 1]);
+      handle = vw->vars.count;
+   }
+
+   uint32_t vcdlen = len;
+   if (vt == FST_VT_SV_SHORTREAL)
+      vcdlen = 32;
+   else if (real)
+      vcdlen = 64;
+   else if (vt == FST_VT_GEN_STRING)
+      vcdlen = 0;
+
+   vcd_printf(vw, "$var %s %"PRIu32" %.*s %s $end\n", vartypes[vt],
+              vcdlen, var->idlen, var->id, name);
+
+   return handle;
+}
+
+void vcd_emit_time_change(vcd_writer_t *vw, uint64_t time)
+{
+   switch (vw->state) {
+   case VCD_DEFINITIONS:
+      vcd_printf(vw, "$enddefinitions $end\n#%"PRIu64"\n$dumpvars\n", time);
+      vw->state = VCD_DUMPVARS;
+      break;
+   case VCD_DUMPVARS:
+      vcd_printf(vw, "$end\n#%"PRIu64"\n", time);
+      vw->state = VCD_CHANGES;
+      break;
+   case VCD_CHANGES:
+      vcd_printf(vw, "#%"PRIu64"\n", time);
+      break;
+   }
+}
+
+void vcd_emit_value_change(vcd_writer_t *vw, fstHandle handle,
+                           const void *val)
+{
+   assert(handle > 0 && handle <= vw->vars.count);
+   const vcd_var_t *var = &(vw->vars.items[handle - 1]);
+
+   if (var->real) {
+      double d;
+      memcpy(&d, val, sizeof(double));
+      vcd_printf(vw, "r%.16g ", d);
+   }
+   else if (var->len == 1)
+      vcd_putc(vw, *(const char *)val);
+   else {
+      vcd_putc(vw, 'b');
+      vcd_write(vw, val, var->len);
+      vcd_putc(vw, ' ');
+   }
+
+   vcd_write_id(vw, var);
+   vcd_putc(vw, '\n');
+}
+
+void vcd_emit_variable_length_value_change(vcd_writer_t *vw, fstHandle handle,
+                                           const void *val, uint32_t len)
+{
+   assert(handle > 0 && handle <= vw->vars.count);
+   const vcd_var_t *var = &(vw->vars.items[handle - 1]);
+
+   unsigned char small[64], *esc = small;
+   if (len * 4 + 1 > sizeof(small))
+      esc = xmalloc(len * 4 + 1);
+
+   const int esclen = fstUtilityBinToEsc(esc, val, len);
+
+   vcd_putc(vw, 's');
+   vcd_write(vw, esc, esclen);
+   vcd_putc(vw, ' ');
+   vcd_write_id(vw, var);
+   vcd_putc(vw, '\n');
+
+   if (esc != small)
+      free(esc);
+}
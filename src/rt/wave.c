@@ -26,22 +26,19 @@
 #include "rt/model.h"
 #include "rt/rt.h"
 #include "rt/structs.h"
+#include "rt/vcd.h"
 #include "rt/wave.h"
 #include "printf.h"
+#include "thread.h"
 #include "tree.h"
 #include "type.h"
 #include "vlog/vlog-node.h"
 #include "vlog/vlog-util.h"
 
 #include <assert.h>
-#include <unistd.h>
 #include <limits.h>
 #include <string.h>
 
-#if !defined __CYGWIN__ && !defined __MINGW32__
-#include <libgen.h>
-#endif
-
 #define USE_FST_ENUMS 0
 
 typedef struct {
@@ -53,7 +50,7 @@ typedef A(glob_t) glob_array_t;
 
 typedef struct _fst_data fst_data_t;
 
-typedef void (*fst_fmt_fn_t)(rt_watch_t *, fst_data_t *);
+typedef void (*fst_fmt_fn_t)(fst_data_t *, const void *);
 
 typedef struct {
    int64_t  mult;
@@ -106,13 +103,32 @@ typedef struct {
    bool        end_of_record;
 } gtkw_writer_t;
 
+// Value changes are passed to the writer thread through a single
+// producer, single consumer ring buffer of variable length records
+typedef struct {
+   fst_data_t *data;
+   uint64_t    time;
+   size_t      skip;
+   uint8_t     value[];
+} wave_record_t;
+
+typedef struct {
+   nvc_thread_t *thread;
+   uint8_t      *buf;
+   bool          stop;
+   size_t        wptr __attribute__((aligned(64)));
+   size_t        rptr __attribute__((aligned(64)));
+} wave_ring_t;
+
+#define WAVE_RING_SIZE (1 << 22)
+
 typedef struct _wave_dumper {
    tree_t         top;
    void          *fst_ctx;
    rt_model_t    *model;
    gtkw_writer_t *gtkw;
-   FILE          *vcdfile;
-   char          *tmpfst;
+   vcd_writer_t  *vcd;
+   wave_ring_t   *ring;
    uint64_t       last_time;
    jit_t         *jit;
    hash_t        *typecache;
@@ -126,6 +142,7 @@ static glob_array_t excl;
 static void fst_process_signal(wave_dumper_t *wd, rt_scope_t *scope, tree_t d,
                                type_t type, text_buf_t *tb);
 static bool wave_should_dump(rt_scope_t *scope, ident_t id);
+static void wave_ring_stop(wave_dumper_t *wd);
 
 static bool should_dump_array(tree_t where, unsigned length)
 {
@@ -145,40 +162,81 @@ static bool should_dump_array(tree_t where, unsigned length)
    return false;
 }
 
-static void fst_close(rt_model_t *m, void *arg)
+static void wave_set_scope(wave_dumper_t *wd, enum fstScopeType st,
+                           const char *name, const char *component)
 {
-   wave_dumper_t *wd = arg;
+   if (wd->vcd != NULL)
+      vcd_set_scope(wd->vcd, st, name);
+   else
+      fstWriterSetScope(wd->fst_ctx, st, name, component);
+}
+
+static void wave_set_upscope(wave_dumper_t *wd)
+{
+   if (wd->vcd != NULL)
+      vcd_set_upscope(wd->vcd);
+   else
+      fstWriterSetUpscope(wd->fst_ctx);
+}
 
-   fstWriterEmitTimeChange(wd->fst_ctx, model_now(m, NULL));
-   fstWriterClose(wd->fst_ctx);
+static void wave_set_attr_end(wave_dumper_t *wd)
+{
+   if (wd->vcd == NULL)
+      fstWriterSetAttrEnd(wd->fst_ctx);
+}
 
-   if (wd->vcdfile) {
-      void *xc = fstReaderOpen(wd->tmpfst);
-      if (xc == NULL)
-         fatal("fstReaderOpen failed for temporary FST file");
+static fstHandle wave_create_var(wave_dumper_t *wd, enum fstVarType vt,
+                                 enum fstVarDir vd, uint32_t len,
+                                 const char *name, fstHandle alias,
+                                 const char *type, enum fstSupplementalVarType svt,
+                                 enum fstSupplementalDataType sdt)
+{
+   if (wd->vcd != NULL)
+      return vcd_create_var(wd->vcd, vt, len, name, alias);
+   else
+      return fstWriterCreateVar2(wd->fst_ctx, vt, vd, len, name, alias,
+                                 type, svt, sdt);
+}
 
-      fstReaderSetVcdExtensions(xc, 1);
-      if (!fstReaderProcessHier(xc, wd->vcdfile))
-         fatal("fstReaderProcessHier failed");
+static inline void wave_emit_time_change(wave_dumper_t *wd, uint64_t now)
+{
+   if (wd->vcd != NULL)
+      vcd_emit_time_change(wd->vcd, now);
+   else
+      fstWriterEmitTimeChange(wd->fst_ctx, now);
+}
 
-      fstReaderSetFacProcessMaskAll(xc);
-      fstReaderIterBlocks(xc, NULL, NULL, wd->vcdfile);
+static inline void wave_emit_value_change(wave_dumper_t *wd, fstHandle handle,
+                                          const void *val)
+{
+   if (wd->vcd != NULL)
+      vcd_emit_value_change(wd->vcd, handle, val);
+   else
+      fstWriterEmitValueChange(wd->fst_ctx, handle, val);
+}
 
-      fstReaderClose(xc);
-      fclose(wd->vcdfile);
-      wd->vcdfile = NULL;
+static inline void wave_emit_varlen_change(wave_dumper_t *wd, fstHandle handle,
+                                           const void *val, uint32_t len)
+{
+   if (wd->vcd != NULL)
+      vcd_emit_variable_length_value_change(wd->vcd, handle, val, len);
+   else
+      fstWriterEmitVariableLengthValueChange(wd->fst_ctx, handle, val, len);
+}
 
-      if (unlink(wd->tmpfst) != 0)
-         fatal_errno("unlink: %s", wd->tmpfst);
+static void fst_close(rt_model_t *m, void *arg)
+{
+   wave_dumper_t *wd = arg;
 
-#if !defined __CYGWIN__ && !defined __MINGW32__
-      char *tmpdir = dirname(wd->tmpfst);
-      if (rmdir(tmpdir) != 0)
-         fatal_errno("rmdir: %s", tmpdir);
-#endif
+   wave_ring_stop(wd);
 
-      free(wd->tmpfst);
-      wd->tmpfst = NULL;
+   if (wd->vcd != NULL) {
+      vcd_writer_close(wd->vcd, model_now(m, NULL));
+      wd->vcd = NULL;
+   }
+   else {
+      fstWriterEmitTimeChange(wd->fst_ctx, model_now(m, NULL));
+      fstWriterClose(wd->fst_ctx);
    }
 
    wd->fst_ctx = NULL;
@@ -192,29 +250,42 @@ static inline void fst_write_binary(uint64_t val, size_t size, char *buf)
    buf[size] = '\0';
 }
 
-static void fst_fmt_int(rt_watch_t *w, fst_data_t *data)
+static void fst_expand(fst_data_t *data, const void *value, uint64_t *buf,
+                       size_t max)
+{
+   const size_t total = signal_width(data->signal);
+
+#define FST_EXPAND_U64(type) do {                               \
+      const type *sp = value;                                   \
+      for (int i = 0; i < max && i < total; i++)                \
+         buf[i] = sp[i];                                        \
+   } while (0)
+
+   FOR_ALL_SIZES(signal_size(data->signal), FST_EXPAND_U64);
+}
+
+static void fst_fmt_int(fst_data_t *data, const void *value)
 {
    uint64_t val[data->count];
-   signal_expand(data->signal, val, data->count);
+   fst_expand(data, value, val, data->count);
 
    for (int i = 0; i < data->count; i++) {
       char buf[data->type->size + 1];
       fst_write_binary(val[i], data->type->size, buf);
 
-      fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i], buf);
+      wave_emit_value_change(data->dumper, data->handle[i], buf);
    }
 }
 
-static void fst_fmt_real(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_real(fst_data_t *data, const void *value)
 {
-   const void *buf = signal_value(data->signal);
-   fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[0], buf);
+   wave_emit_value_change(data->dumper, data->handle[0], value);
 }
 
-static void fst_fmt_physical(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_physical(fst_data_t *data, const void *value)
 {
    uint64_t val;
-   signal_expand(data->signal, &val, 1);
+   fst_expand(data, value, &val, 1);
 
    fst_unit_t *unit = data->type->u.units;
    while ((val % unit->mult) != 0)
@@ -224,68 +295,194 @@ static void fst_fmt_physical(rt_watch_t *w, fst_data_t *data)
    checked_sprintf(buf, sizeof(buf), "%"PRIi64" %s",
                    val / unit->mult, unit->name);
 
-   fstWriterEmitVariableLengthValueChange(
-      data->dumper->fst_ctx, data->handle[0], buf, strlen(buf));
+   wave_emit_varlen_change(data->dumper, data->handle[0], buf, strlen(buf));
 }
 
-static void fst_fmt_chars(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_chars(fst_data_t *data, const void *value)
 {
-   const uint8_t *p = signal_value(data->signal);
+   const uint8_t *p = value;
    for (int i = 0; i < data->count; i++, p += data->size) {
       if (likely(data->type->u.map != NULL)) {
          char buf[data->size];
          for (int j = 0; j < data->size; j++)
             buf[j] = data->type->u.map[p[j]];
-         fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i], buf);
+         wave_emit_value_change(data->dumper, data->handle[i], buf);
       }
       else
-         fstWriterEmitVariableLengthValueChange(
-            data->dumper->fst_ctx, data->handle[i], p, data->size);
+         wave_emit_varlen_change(data->dumper, data->handle[i], p, data->size);
    }
 }
 
 #if !USE_FST_ENUMS
-static void fst_fmt_enum(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_enum(fst_data_t *data, const void *value)
 {
    uint64_t val[data->count];
-   signal_expand(data->signal, val, data->count);
+   fst_expand(data, value, val, data->count);
 
    for (int i = 0; i < data->count; i++) {
       fst_enum_t *e = &(data->type->u.literals);
       assert(val[i] < e->count);
 
       const char *literal = e->strings + val[i] * e->size;
-      fstWriterEmitVariableLengthValueChange(data->dumper->fst_ctx,
-                                             data->handle[i],
-                                             literal,
-                                             strnlen(literal, e->size));
+      wave_emit_varlen_change(data->dumper, data->handle[i], literal,
+                              strnlen(literal, e->size));
    }
 }
 #endif
 
-static void fst_fmt_verilog(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_verilog(fst_data_t *data, const void *value)
 {
-   const uint8_t *p = signal_value(data->signal);
+   const uint8_t *p = value;
    for (int i = 0; i < data->count; i++, p += data->size) {
       char buf[data->size];
       for (int j = 0; j < data->size; j++)
          buf[j] = data->type->u.map[p[j] & 3];
-      fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i], buf);
+      wave_emit_value_change(data->dumper, data->handle[i], buf);
+   }
+}
+
+static void wave_format(fst_data_t *data, uint64_t now, const void *value)
+{
+   if (now != data->dumper->last_time) {
+      wave_emit_time_change(data->dumper, now);
+      data->dumper->last_time = now;
+   }
+
+   (*data->type->fn)(data, value);
+}
+
+static inline const wave_record_t *wave_ring_peek(wave_ring_t *r,
+                                                  size_t *rptr)
+{
+   const size_t mask = WAVE_RING_SIZE - 1;
+
+   // Records never straddle the end of the buffer
+   if (WAVE_RING_SIZE - (*rptr & mask) < sizeof(wave_record_t)) {
+      *rptr = (*rptr | mask) + 1;
+      return NULL;
+   }
+
+   const wave_record_t *rec = (wave_record_t *)(r->buf + (*rptr & mask));
+   *rptr += rec->skip;
+   return rec->data != NULL ? rec : NULL;
+}
+
+static void *wave_writer_thread(void *arg)
+{
+   wave_ring_t *r = arg;
+
+   size_t rptr = relaxed_load(&r->rptr);
+   for (int idle = 0;;) {
+      const size_t wptr = load_acquire(&r->wptr);
+      if (rptr == wptr) {
+         if (load_acquire(&r->stop) && load_acquire(&r->wptr) == rptr)
+            break;
+         else if (++idle < 1000)
+            spin_wait();
+         else
+            thread_sleep(50);
+         continue;
+      }
+
+      idle = 0;
+
+      do {
+         const wave_record_t *rec = wave_ring_peek(r, &rptr);
+         if (rec != NULL)
+            wave_format(rec->data, rec->time, rec->value);
+
+         // Publish after formatting so the producer never overwrites a
+         // record that is still in use
+         store_release(&r->rptr, rptr);
+      } while (rptr != wptr);
+   }
+
+   return NULL;
+}
+
+static void wave_ring_wait(wave_ring_t *r, size_t need)
+{
+   for (int spins = 0;
+        r->wptr + need - load_acquire(&r->rptr) > WAVE_RING_SIZE;) {
+      if (++spins < 1000)
+         spin_wait();
+      else
+         thread_sleep(10);
+   }
+}
+
+static void wave_ring_put(wave_ring_t *r, fst_data_t *data, uint64_t now,
+                          const void *value, size_t size)
+{
+   const size_t need = ALIGN_UP(sizeof(wave_record_t) + size, 8);
+   const size_t off = r->wptr & (WAVE_RING_SIZE - 1);
+   const size_t tail = WAVE_RING_SIZE - off;
+
+   if (unlikely(need > WAVE_RING_SIZE / 4)) {
+      // Very large values are formatted synchronously once the writer
+      // thread has caught up
+      wave_ring_wait(r, WAVE_RING_SIZE);
+      wave_format(data, now, value);
+      return;
    }
+
+   const size_t pad = tail < need ? tail : 0;
+   wave_ring_wait(r, pad + need);
+
+   if (pad >= sizeof(wave_record_t)) {
+      wave_record_t *skip = (wave_record_t *)(r->buf + off);
+      skip->data = NULL;
+      skip->skip = pad;
+   }
+
+   const size_t roff = (off + pad) & (WAVE_RING_SIZE - 1);
+
+   wave_record_t *rec = (wave_record_t *)(r->buf + roff);
+   rec->data = data;
+   rec->time = now;
+   rec->skip = need;
+   memcpy(rec->value, value, size);
+
+   store_release(&r->wptr, r->wptr + pad + need);
+}
+
+static void wave_ring_start(wave_dumper_t *wd)
+{
+   wave_ring_t *r = xcalloc(sizeof(wave_ring_t));
+   r->buf = xmalloc(WAVE_RING_SIZE);
+
+   wd->ring = r;
+   r->thread = thread_create(wave_writer_thread, r, "wave writer");
+}
+
+static void wave_ring_stop(wave_dumper_t *wd)
+{
+   wave_ring_t *r = wd->ring;
+   if (r == NULL)
+      return;
+
+   store_release(&r->stop, true);
+   thread_join(r->thread);
+
+   assert(r->rptr == r->wptr);
+
+   free(r->buf);
+   free(r);
+   wd->ring = NULL;
 }
 
 static void fst_event_cb(uint64_t now, rt_signal_t *s, rt_watch_t *w,
                          void *user)
 {
    fst_data_t *data = user;
+   wave_ring_t *r = data->dumper->ring;
 
-   if (now != data->dumper->last_time) {
-      fstWriterEmitTimeChange(data->dumper->fst_ctx, now);
-      data->dumper->last_time = now;
+   if (r != NULL) {
+      const size_t size = signal_width(s) * signal_size(s);
+      wave_ring_put(r, data, now, signal_value(s), size);
    }
-
-   if (likely(data != NULL))
-      (*data->type->fn)(w, data);
+   else
+      wave_format(data, now, signal_value(s));
 }
 
 static fst_unit_t *fst_make_unit_map(type_t type)
@@ -585,8 +782,8 @@ static fstHandle fst_create_handle(wave_dumper_t *wd, fst_data_t *data,
    if (data->type->vartype == FST_VT_SV_ENUM)
       fstWriterEmitEnumTableRef(wd->fst_ctx, data->type->u.enumh);
 
-   return fstWriterCreateVar2(
-      wd->fst_ctx,
+   return wave_create_var(
+      wd,
       data->type->vartype,
       dir,
       data->size,
@@ -704,7 +901,7 @@ static void fst_create_array_var(wave_dumper_t *wd, tree_t d, rt_signal_t *s,
                         vd, type, tb);
       assert(pos == length);
 
-      fstWriterSetAttrEnd(wd->fst_ctx);
+      wave_set_attr_end(wd);
    }
    else {
       data = xcalloc_flex(sizeof(fst_data_t), length, sizeof(fstHandle));
@@ -725,7 +922,7 @@ static void fst_create_array_var(wave_dumper_t *wd, tree_t d, rt_signal_t *s,
          data->handle[i] = fst_create_handle(wd, data, tb_get(tb), vd, elem, 0);
       }
 
-      fstWriterSetAttrEnd(wd->fst_ctx);
+      wave_set_attr_end(wd);
    }
 
    assert(find_watch(&(s->nexus), fst_event_cb) == NULL);
@@ -843,7 +1040,7 @@ static void fst_create_record_var(wave_dumper_t *wd, tree_t d,
    tb_cat(tb, suffix);
    tb_downcase(tb);
 
-   fstWriterSetScope(wd->fst_ctx, FST_ST_VHDL_RECORD, tb_get(tb), NULL);
+   wave_set_scope(wd, FST_ST_VHDL_RECORD, tb_get(tb), NULL);
 
    size_t hlen = 0;
    if (wd->gtkw != NULL) {
@@ -859,7 +1056,7 @@ static void fst_create_record_var(wave_dumper_t *wd, tree_t d,
       fst_process_signal(wd, scope, f, tree_type(cons ?: f), tb);
    }
 
-   fstWriterSetUpscope(wd->fst_ctx);
+   wave_set_upscope(wd);
 
    if (wd->gtkw != NULL) {
       tb_trim(wd->gtkw->hier, hlen);
@@ -1057,8 +1254,8 @@ static void fst_process_verilog(wave_dumper_t *wd, rt_scope_t *scope,
 
    enum fstVarDir dir = FST_VD_IMPLICIT;
 
-   data->handle[0] = fstWriterCreateVar2(
-      wd->fst_ctx,
+   data->handle[0] = wave_create_var(
+      wd,
       data->type->vartype,
       dir,
       data->size,
@@ -1102,14 +1299,16 @@ static void fst_enter_scope(wave_dumper_t *wd, tree_t unit, rt_scope_t *scope,
    }
 
    const loc_t *loc = tree_loc(unit);
-   fstWriterSetSourceStem(wd->fst_ctx, loc_file_str(loc), loc->first_line, 1);
+   if (wd->vcd == NULL)
+      fstWriterSetSourceStem(wd->fst_ctx, loc_file_str(loc),
+                             loc->first_line, 1);
 
    tb_rewind(tb);
    tb_istr(tb, tree_ident(scope->where));
    tb_downcase(tb);
 
    // TODO: store the component name in T_HIER somehow?
-   fstWriterSetScope(wd->fst_ctx, st, tb_get(tb), "");
+   wave_set_scope(wd, st, tb_get(tb), "");
 
    if (wd->gtkw != NULL) {
       if (scope->kind == SCOPE_INSTANCE && tb_len(wd->gtkw->hier) > 0)
@@ -1124,7 +1323,7 @@ static void fst_enter_scope(wave_dumper_t *wd, tree_t unit, rt_scope_t *scope,
 
 static void fst_leave_scope(wave_dumper_t *wd)
 {
-   fstWriterSetUpscope(wd->fst_ctx);
+   wave_set_upscope(wd);
 
    if (wd->gtkw != NULL) {
       const char *h = tb_get(wd->gtkw->hier);
@@ -1251,6 +1450,9 @@ void wave_dumper_restart(wave_dumper_t *wd, rt_model_t *m, jit_t *jit)
       wd->gtkw = NULL;
    }
 
+   if (opt_get_int(OPT_WAVE_ASYNC) && wd->ring == NULL)
+      wave_ring_start(wd);
+
    // Emitting the initial values must happen after all FST variables
    // are created to avoid expensive mmap/munmap calls
    for (int i = 0; i < wd->dumped.count; i++) {
@@ -1269,40 +1471,21 @@ wave_dumper_t *wave_dumper_new(const char *file, const char *gtkw_file,
    wd->last_time = UINT64_MAX;
    wd->typecache = hash_new(128);
 
-   if (format == WAVE_FORMAT_VCD) {
-#if defined __CYGWIN__ || defined __MINGW32__
-      const char *tmpdir = ".";
-#else
-      char tmpdir[PATH_MAX] = "/tmp/vcdXXXXXX";
-      checked_sprintf(tmpdir, PATH_MAX, "%s/vcdXXXXXX",
-                      getenv("TMPDIR") ?: "/tmp");
-      if (mkdtemp(tmpdir) == NULL)
-         fatal_errno("mkdtemp");
-#endif
-
-      wd->vcdfile = fopen(file, "wb");
-      if (wd->vcdfile == NULL)
-         fatal_errno("%s", file);
-
-      wd->tmpfst  = xasprintf("%s" DIR_SEP "temp.fst", tmpdir);
-      wd->fst_ctx = fstWriterCreate(wd->tmpfst, 1);
-   }
+   if (format == WAVE_FORMAT_VCD)
+      wd->vcd = vcd_writer_new(file, PACKAGE_STRING);
    else {
-      wd->vcdfile = NULL;
-      wd->tmpfst  = NULL;
       wd->fst_ctx = fstWriterCreate(file, 1);
+      if (wd->fst_ctx == NULL)
+         fatal("fstWriterCreate failed");
+
+      fstWriterSetFileType(wd->fst_ctx, FST_FT_VHDL);
+      fstWriterSetTimescale(wd->fst_ctx, -15);
+      fstWriterSetVersion(wd->fst_ctx, PACKAGE_STRING);
+      fstWriterSetPackType(wd->fst_ctx, 0);
+      fstWriterSetRepackOnClose(wd->fst_ctx, 1);
+      fstWriterSetParallelMode(wd->fst_ctx, 0);
    }
 
-   if (wd->fst_ctx == NULL)
-      fatal("fstWriterCreate failed");
-
-   fstWriterSetFileType(wd->fst_ctx, FST_FT_VHDL);
-   fstWriterSetTimescale(wd->fst_ctx, -15);
-   fstWriterSetVersion(wd->fst_ctx, PACKAGE_STRING);
-   fstWriterSetPackType(wd->fst_ctx, 0);
-   fstWriterSetRepackOnClose(wd->fst_ctx, 1);
-   fstWriterSetParallelMode(wd->fst_ctx, 0);
-
    if (gtkw_file != NULL) {
       wd->gtkw = xcalloc(sizeof(gtkw_writer_t));
       if ((wd->gtkw->file = fopen(gtkw_file, "w")) == NULL)
@@ -1317,6 +1500,8 @@ wave_dumper_t *wave_dumper_new(const char *file, const char *gtkw_file,
 
 void wave_dumper_free(wave_dumper_t *wd)
 {
+   wave_ring_stop(wd);
+
    for (int i = 0; i < wd->dumped.count; i++)
       free(wd->dumped.items[i]);
    ACLEAR(wd->dumped);
@@ -0,0 +1,249 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "rt/heap.h"
+#include "rt/rt.h"
+#include "rt/wheel.h"
+#include "thread.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+// Hierarchical timing wheel where each level divides the key into
+// WHEEL_BITS wide digits relative to a base key which only increases
+// as entries are extracted.  An entry is stored at the level of the
+// most significant digit where it differs from the base.  Keys that
+// are too far in the future or earlier than the base are kept in a
+// binary heap.
+
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 6
+#define WHEEL_SPAN   (WHEEL_BITS * WHEEL_LEVELS)
+
+typedef struct {
+   uint64_t  key;
+   void     *user;
+} wheel_entry_t;
+
+typedef struct {
+   wheel_entry_t *items;
+   unsigned       count;
+   unsigned       max;
+} wheel_slot_t;
+
+struct _wheel {
+   uint64_t      base;
+   size_t        count;
+   uint64_t      occupied[WHEEL_LEVELS];
+   wheel_slot_t  slots[WHEEL_LEVELS][WHEEL_SLOTS];
+   heap_t       *overflow;
+   nvc_lock_t    lock;
+};
+
+wheel_t *wheel_new(void)
+{
+   wheel_t *w = xcalloc(sizeof(wheel_t));
+   w->overflow = heap_new(64);
+   return w;
+}
+
+void wheel_free(wheel_t *w)
+{
+   for (int i = 0; i < WHEEL_LEVELS; i++) {
+      for (int j = 0; j < WHEEL_SLOTS; j++)
+         free(w->slots[i][j].items);
+   }
+
+   heap_free(w->overflow);
+   free(w);
+}
+
+static void wheel_place(wheel_t *w, uint64_t key, void *user)
+{
+   const uint64_t diff = key ^ w->base;
+   if (key < w->base || (diff >> WHEEL_SPAN) != 0) {
+      heap_insert(w->overflow, key, user);
+      return;
+   }
+
+   const int level = diff == 0 ? 0 : (63 - __builtin_clzll(diff)) / WHEEL_BITS;
+   const int index = (key >> (level * WHEEL_BITS)) & (WHEEL_SLOTS - 1);
+
+   wheel_slot_t *s = &(w->slots[level][index]);
+   if (s->count == s->max) {
+      s->max = MAX(s->max * 2, 16);
+      s->items = xrealloc_array(s->items, s->max, sizeof(wheel_entry_t));
+   }
+
+   s->items[s->count++] = (wheel_entry_t){ key, user };
+   w->occupied[level] |= UINT64_C(1) << index;
+   w->count++;
+}
+
+static void wheel_remove(wheel_t *w, int level, int index, unsigned pos)
+{
+   wheel_slot_t *s = &(w->slots[level][index]);
+   assert(pos < s->count);
+
+   s->items[pos] = s->items[--(s->count)];
+   w->count--;
+
+   if (s->count == 0)
+      w->occupied[level] &= ~(UINT64_C(1) << index);
+}
+
+static uint64_t wheel_peek(wheel_t *w)
+{
+   assert(w->count > 0);
+
+   for (int level = 0; level < WHEEL_LEVELS; level++) {
+      if (w->occupied[level] == 0)
+         continue;
+
+      const int index = __builtin_ctzll(w->occupied[level]);
+      const wheel_slot_t *s = &(w->slots[level][index]);
+
+      if (level == 0)
+         return s->items[0].key;   // All entries have the same key
+
+      uint64_t min = UINT64_MAX;
+      for (unsigned i = 0; i < s->count; i++)
+         min = MIN(min, s->items[i].key);
+
+      return min;
+   }
+
+   should_not_reach_here();
+}
+
+static void wheel_cascade(wheel_t *w)
+{
+   assert(w->count > 0);
+
+   while (w->occupied[0] == 0) {
+      int level = 1;
+      while (w->occupied[level] == 0)
+         level++;
+
+      assert(level < WHEEL_LEVELS);
+
+      const int index = __builtin_ctzll(w->occupied[level]);
+      const int shift = (level + 1) * WHEEL_BITS;
+
+      // Advance the base to the start of this slot then redistribute
+      // its entries to lower levels
+      w->base = ((w->base >> shift) << shift)
+         | ((uint64_t)index << (level * WHEEL_BITS));
+
+      wheel_slot_t *s = &(w->slots[level][index]);
+      const unsigned count = s->count;
+      wheel_entry_t *items = s->items;
+
+      s->items = NULL;
+      s->count = s->max = 0;
+      w->occupied[level] &= ~(UINT64_C(1) << index);
+      w->count -= count;
+
+      for (unsigned i = 0; i < count; i++)
+         wheel_place(w, items[i].key, items[i].user);
+
+      free(items);
+   }
+}
+
+static void wheel_refill(wheel_t *w)
+{
+   assert(w->count == 0);
+   assert(heap_size(w->overflow) > 0);
+
+   w->base = heap_min_key(w->overflow);
+
+   do {
+      const uint64_t key = heap_min_key(w->overflow);
+      if ((key ^ w->base) >> WHEEL_SPAN)
+         break;
+
+      wheel_place(w, key, heap_extract_min(w->overflow));
+   } while (heap_size(w->overflow) > 0);
+}
+
+void *wheel_extract_min(wheel_t *w)
+{
+   RT_LOCK(w->lock);
+
+   if (w->count == 0)
+      wheel_refill(w);
+   else if (heap_size(w->overflow) > 0
+            && heap_min_key(w->overflow) < wheel_peek(w))
+      return heap_extract_min(w->overflow);
+
+   wheel_cascade(w);
+
+   const int index = __builtin_ctzll(w->occupied[0]);
+   wheel_slot_t *s = &(w->slots[0][index]);
+
+   void *user = s->items[s->count - 1].user;
+   wheel_remove(w, 0, index, s->count - 1);
+   return user;
+}
+
+uint64_t wheel_min_key(wheel_t *w)
+{
+   RT_LOCK(w->lock);
+
+   if (w->count == 0)
+      return heap_min_key(w->overflow);
+   else if (heap_size(w->overflow) > 0)
+      return MIN(heap_min_key(w->overflow), wheel_peek(w));
+   else
+      return wheel_peek(w);
+}
+
+void wheel_insert(wheel_t *w, uint64_t key, void *user)
+{
+   RT_LOCK(w->lock);
+   wheel_place(w, key, user);
+}
+
+bool wheel_delete(wheel_t *w, heap_delete_fn_t fn, void *context)
+{
+   RT_LOCK(w->lock);
+
+   for (int level = 0; level < WHEEL_LEVELS; level++) {
+      for (uint64_t bits = w->occupied[level]; bits != 0; bits &= bits - 1) {
+         const int index = __builtin_ctzll(bits);
+         const wheel_slot_t *s = &(w->slots[level][index]);
+
+         for (unsigned i = 0; i < s->count; i++) {
+            if ((*fn)(s->items[i].key, s->items[i].user, context)) {
+               wheel_remove(w, level, index, i);
+               return true;
+            }
+         }
+      }
+   }
+
+   return heap_delete(w->overflow, fn, context);
+}
+
+size_t wheel_size(wheel_t *w)
+{
+   RT_LOCK(w->lock);
+   return w->count + heap_size(w->overflow);
+}
@@ -74,6 +74,9 @@ static macro_stack_t     macro_stack;
 static vlog_version_t    default_keywords = VLOG_1800_2023;
 static keywords_stack_t  keywords_stack;
 static string_list_t     include_dirs;
+static input_fill_fn_t   fill_fn;
+static void             *fill_ctx;
+static input_buf_t       fill_buf;
 
 extern int yylex(void);
 
@@ -81,6 +84,7 @@ extern void reset_scanner(void);
 
 static bool pp_cond_analysis_expr(void);
 static void pp_defines_init(void);
+static void macro_hint_cb(diag_t *d, void *ctx);
 
 yylval_t yylval;
 loc_t yylloc;
@@ -105,6 +109,9 @@ void input_from_buffer(const char *buf, size_t len, file_ref_t file_ref,
    src_kind = kind;
    pperrors = 0;
 
+   fill_fn  = NULL;
+   fill_ctx = NULL;
+
    switch (kind) {
    case SOURCE_VERILOG:
       reset_verilog_parser();
@@ -182,6 +189,19 @@ void input_from_file(const char *file)
    close(fd);
 }
 
+void input_from_stream(input_fill_fn_t fn, void *ctx)
+{
+   // The current input becomes the source for the fill function and
+   // the lexer reads the text it generates on demand
+   assert(buf_stack.count == 0);
+   fill_buf = input_buf;
+
+   input_from_buffer(NULL, 0, fill_buf.file_ref, src_kind);
+
+   fill_fn  = fn;
+   fill_ctx = ctx;
+}
+
 void push_buffer(const char *buf, size_t len, file_ref_t file_ref)
 {
    APUSH(buf_stack, input_buf);
@@ -337,12 +357,55 @@ token_t make_token(token_t tok, scan_buf_t buf, yylval_t lval)
    return tok;
 }
 
+static size_t input_fill(void)
+{
+   // Swap in the state of the stream source while the fill function
+   // runs as it uses the same scanner to read its own input
+   const input_buf_t saved_buf = input_buf;
+   const macro_stack_t saved_macros = macro_stack;
+   const loc_t saved_loc = yylloc;
+   const yylval_t saved_lval = yylval;
+
+   if (saved_macros.count > 0)
+      diag_remove_hint_fn(macro_hint_cb, NULL);
+
+   input_buf = fill_buf;
+   macro_stack = (macro_stack_t)AINIT;
+
+   const char *chunk = NULL;
+   const size_t len = (*fill_fn)(&chunk, fill_ctx);
+
+   assert(buf_stack.count == 0);
+   assert(macro_stack.count == 0);
+
+   fill_buf = input_buf;
+   input_buf = saved_buf;
+   macro_stack = saved_macros;
+   yylloc = saved_loc;
+   yylval = saved_lval;
+
+   if (saved_macros.count > 0)
+      diag_add_hint_fn(macro_hint_cb, NULL);
+
+   input_buf.file_start = chunk;
+   input_buf.read_ptr   = chunk;
+   input_buf.file_sz    = len;
+
+   if (len == 0)
+      fill_fn = NULL;   // End of stream
+
+   return len;
+}
+
 int get_next_char(char *b, int max_buffer)
 {
-   const ptrdiff_t navail =
+   ptrdiff_t navail =
       (input_buf.file_start - input_buf.read_ptr) + input_buf.file_sz;
    assert(navail >= 0);
 
+   if (navail == 0 && fill_fn != NULL)
+      navail = input_fill();
+
    if (navail == 0)
       return 0;
 
@@ -59,9 +59,12 @@ typedef enum {
    VLOG_1800_2023,
 } vlog_version_t;
 
+typedef size_t (*input_fill_fn_t)(const char **, void *);
+
 void input_from_file(const char *file);
 void input_from_buffer(const char *buf, size_t len, file_ref_t file_ref,
                        hdl_kind_t hdl);
+void input_from_stream(input_fill_fn_t fn, void *ctx);
 void push_buffer(const char *buf, size_t len, file_ref_t file_ref);
 void push_file(const char *file, const loc_t *srcloc);
 void pop_buffer(void);
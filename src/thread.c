@@ -212,6 +212,7 @@ typedef enum {
    MAIN_THREAD,
    USER_THREAD,
    WORKER_THREAD,
+   GC_THREAD,
 } thread_kind_t;
 
 typedef char thread_name_t[THREAD_NAME_LEN];
@@ -283,6 +284,28 @@ static pthread_mutex_t    wakelock = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
 static sem_t stop_sem;
 #endif
 
+// Garbage collector helper threads are not suspended by stop_world and
+// so must never touch mutator state or locks that a suspended thread
+// may hold
+typedef struct {
+   task_fn_t  fn;
+   void      *context;
+   unsigned   generation;
+   int        pending;
+   int        count;
+   int        ready;
+} gc_job_t;
+
+static gc_job_t gc_job;
+
+#ifdef __MINGW32__
+static CONDITION_VARIABLE gc_wake = CONDITION_VARIABLE_INIT;
+static CRITICAL_SECTION   gc_lock;
+#else
+static pthread_cond_t     gc_wake = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t    gc_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 #ifdef DEBUG
 static lock_stats_t  lock_stats[MAX_THREADS];
 static workq_stats_t workq_stats[MAX_THREADS];
@@ -392,11 +415,16 @@ static void join_worker_threads(void)
    }
    platform_mutex_unlock(&wakelock);
 
+   platform_mutex_lock(&gc_lock);
+   platform_cond_broadcast(&gc_wake);
+   platform_mutex_unlock(&gc_lock);
+
    for (int i = 0; i < join_list.count; i++) {
       nvc_thread_t *t = join_list.items[i];
 
       switch (relaxed_load(&t->kind)) {
       case WORKER_THREAD:
+      case GC_THREAD:
          thread_join(t);
          continue;  // Freed thread struct
       case USER_THREAD:
@@ -495,6 +523,7 @@ void thread_init(void)
 
 #ifdef __MINGW32__
    InitializeCriticalSectionAndSpinCount(&wakelock, LOCK_SPINS);
+   InitializeCriticalSectionAndSpinCount(&gc_lock, LOCK_SPINS);
    InitializeConditionVariable(&wake_workers);
 
    for (int i = 0; i < PARKING_BAYS; i++) {
@@ -565,6 +594,12 @@ bool thread_attached(void)
    return my_thread != NULL;
 }
 
+unsigned thread_max_workers(void)
+{
+   assert(max_workers > 0);
+   return max_workers;
+}
+
 void thread_sleep(int usec)
 {
    usleep(usec);
@@ -1083,7 +1118,7 @@ static bool steal_task(void)
    return false;
 }
 
-static void progressive_backoff(void)
+void progressive_backoff(void)
 {
    if (my_thread->spins++ < YIELD_SPINS)
       spin_wait();
@@ -1126,7 +1161,8 @@ static void create_workers(int needed)
    if (relaxed_load(&should_stop))
       return;
 
-   while (relaxed_load(&running_threads) < MIN(max_workers, needed)) {
+   while (relaxed_load(&running_threads) - relaxed_load(&gc_job.count)
+          < MIN(max_workers, needed)) {
       static int counter = 0;
       thread_name_t name;
       checked_sprintf(name, THREAD_NAME_LEN, "worker thread %d",
@@ -1313,7 +1349,7 @@ void stop_world(stop_world_fn_t callback, void *arg)
    const int maxthread = relaxed_load(&max_thread_id);
    for (int i = 0; i <= maxthread; i++) {
       nvc_thread_t *thread = atomic_load(&threads[i]);
-      if (thread == NULL || thread == my_thread)
+      if (thread == NULL || thread == my_thread || thread->kind == GC_THREAD)
          continue;
 
       if (SuspendThread(thread->handle) != 0)
@@ -1333,7 +1369,7 @@ void stop_world(stop_world_fn_t callback, void *arg)
    const int maxthread = relaxed_load(&max_thread_id);
    for (int i = 0; i <= maxthread; i++) {
       nvc_thread_t *thread = atomic_load(&threads[i]);
-      if (thread == NULL || thread == my_thread)
+      if (thread == NULL || thread == my_thread || thread->kind == GC_THREAD)
          continue;
 
       assert(thread->port != MACH_PORT_NULL);
@@ -1381,7 +1417,7 @@ void stop_world(stop_world_fn_t callback, void *arg)
    const int maxthread = relaxed_load(&max_thread_id);
    for (int i = 0; i <= maxthread; i++) {
       nvc_thread_t *thread = atomic_load(&threads[i]);
-      if (thread == NULL || thread == my_thread)
+      if (thread == NULL || thread == my_thread || thread->kind == GC_THREAD)
          continue;
 
       PTHREAD_CHECK(pthread_kill, thread->handle, SIGSUSPEND);
@@ -1417,7 +1453,7 @@ void start_world(void)
 #ifdef __MINGW32__
    for (int i = 0; i <= maxthread; i++) {
       nvc_thread_t *thread = atomic_load(&threads[i]);
-      if (thread == NULL || thread == my_thread)
+      if (thread == NULL || thread == my_thread || thread->kind == GC_THREAD)
          continue;
 
       if (ResumeThread(thread->handle) != 1)
@@ -1426,7 +1462,7 @@ void start_world(void)
 #elif defined __APPLE__
    for (int i = 0; i <= maxthread; i++) {
       nvc_thread_t *thread = atomic_load(&threads[i]);
-      if (thread == NULL || thread == my_thread)
+      if (thread == NULL || thread == my_thread || thread->kind == GC_THREAD)
          continue;
 
       kern_return_t kern_result;
@@ -1443,7 +1479,7 @@ void start_world(void)
    int signalled = 0;
    for (int i = 0; i <= maxthread; i++) {
       nvc_thread_t *thread = atomic_load(&threads[i]);
-      if (thread == NULL || thread == my_thread)
+      if (thread == NULL || thread == my_thread || thread->kind == GC_THREAD)
          continue;
 
       PTHREAD_CHECK(pthread_kill, thread->handle, SIGRESUME);
@@ -1467,6 +1503,89 @@ void start_world(void)
    nvc_unlock(&stop_lock);
 }
 
+static void *gc_thread_fn(void *arg)
+{
+   const int index = (intptr_t)arg;
+
+   platform_mutex_lock(&gc_lock);
+   unsigned generation = gc_job.generation;
+   atomic_add(&gc_job.ready, 1);
+
+   for (;;) {
+      while (gc_job.generation == generation && !relaxed_load(&should_stop))
+         platform_cond_wait(&gc_wake, &gc_lock);
+
+      if (relaxed_load(&should_stop))
+         break;
+
+      generation = gc_job.generation;
+
+      task_fn_t fn = gc_job.fn;
+      void *context = gc_job.context;
+
+      platform_mutex_unlock(&gc_lock);
+
+      (*fn)(context, (void *)(intptr_t)index);
+      atomic_add(&gc_job.pending, -1);
+
+      platform_mutex_lock(&gc_lock);
+   }
+
+   platform_mutex_unlock(&gc_lock);
+   return NULL;
+}
+
+void gc_threads_start(int count)
+{
+   assert(count < MAX_THREADS);
+
+   // Avoid races with stop_world
+   SCOPED_LOCK(stop_lock);
+
+   while (relaxed_load(&gc_job.count) < count) {
+      const int index = relaxed_load(&gc_job.count) + 1;
+
+      thread_name_t name;
+      checked_sprintf(name, THREAD_NAME_LEN, "gc thread %d", index);
+
+      nvc_thread_t *thread =
+         thread_new(gc_thread_fn, (void *)(intptr_t)index, GC_THREAD, name);
+      thread_start(thread);
+
+      atomic_add(&gc_job.count, 1);
+   }
+
+   // Make sure new threads do not miss the next job
+   while (atomic_load(&gc_job.ready) < count)
+      progressive_backoff();
+}
+
+int gc_threads_run(task_fn_t fn, void *context)
+{
+   // The calling thread participates with index zero and waits for all
+   // the helper threads to finish: this is safe to call while the
+   // world is stopped
+   const int count = relaxed_load(&gc_job.count);
+   if (count > 0) {
+      platform_mutex_lock(&gc_lock);
+      {
+         gc_job.fn = fn;
+         gc_job.context = context;
+         atomic_store(&gc_job.pending, count);
+         gc_job.generation++;
+         platform_cond_broadcast(&gc_wake);
+      }
+      platform_mutex_unlock(&gc_lock);
+   }
+
+   (*fn)(context, (void *)0);
+
+   while (atomic_load(&gc_job.pending) > 0)
+      progressive_backoff();
+
+   return count + 1;
+}
+
 void thread_wx_mode(wx_mode_t mode)
 {
 #ifdef __APPLE__
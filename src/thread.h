@@ -47,6 +47,7 @@
 #define load_acquire(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
 
 #define full_barrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define signal_barrier() __atomic_signal_fence(__ATOMIC_SEQ_CST)
 
 #define MAX_THREADS 64
 #define DEFAULT_THREADS 8
@@ -59,6 +60,7 @@ void thread_init(void);
 int thread_id(void);
 bool thread_attached(void);
 void thread_sleep(int usec);
+unsigned thread_max_workers(void);
 
 typedef void *(*thread_fn_t)(void *);
 
@@ -69,6 +71,7 @@ void *thread_join(nvc_thread_t *thread);
 nvc_thread_t *get_thread(int id);
 
 void spin_wait(void);
+void progressive_backoff(void);
 
 typedef int8_t nvc_lock_t;
 
@@ -111,6 +114,9 @@ typedef void (*stop_world_fn_t)(int, struct cpu_state *, void *);
 void stop_world(stop_world_fn_t callback, void *arg);
 void start_world(void);
 
+void gc_threads_start(int count);
+int gc_threads_run(task_fn_t fn, void *context);
+
 typedef enum { WX_WRITE, WX_EXECUTE } wx_mode_t;
 void thread_wx_mode(wx_mode_t mode);
 
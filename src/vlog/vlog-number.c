@@ -28,6 +28,10 @@
 #include <string.h>
 #include <stdlib.h>
 
+#ifdef HAVE_AVX2
+#include <x86intrin.h>
+#endif
+
 typedef enum {
    RADIX_BIN = 2,
    RADIX_OCT = 8,
@@ -1683,10 +1687,93 @@ void vec4_inv(int size, uint64_t *a, uint64_t *b)
    vec2_or2(size, a, b);
 }
 
+#ifdef HAVE_AVX2
+
+// These kernels process four words of each bit plane per iteration and
+// return the number of words handled so the caller can finish the tail
+
+__attribute__((target("avx2")))
+static int vec4_and2_avx2(int nwords, uint64_t *a1, uint64_t *b1,
+                          const uint64_t *a2, const uint64_t *b2)
+{
+   int i = 0;
+   for (; i + 4 <= nwords; i += 4) {
+      __m256i xa = _mm256_loadu_si256((const __m256i *)(a1 + i));
+      __m256i xb = _mm256_loadu_si256((const __m256i *)(b1 + i));
+      __m256i ya = _mm256_loadu_si256((const __m256i *)(a2 + i));
+      __m256i yb = _mm256_loadu_si256((const __m256i *)(b2 + i));
+
+      __m256i lmaybe1 = _mm256_or_si256(xa, xb);
+      __m256i rmaybe1 = _mm256_or_si256(ya, yb);
+      __m256i bx = _mm256_or_si256(_mm256_and_si256(xb, rmaybe1),
+                                   _mm256_and_si256(yb, lmaybe1));
+
+      __m256i a = _mm256_or_si256(_mm256_and_si256(xa, ya), bx);
+      _mm256_storeu_si256((__m256i *)(a1 + i), a);
+      _mm256_storeu_si256((__m256i *)(b1 + i), bx);
+   }
+
+   return i;
+}
+
+__attribute__((target("avx2")))
+static int vec4_or2_avx2(int nwords, uint64_t *a1, uint64_t *b1,
+                         const uint64_t *a2, const uint64_t *b2)
+{
+   int i = 0;
+   for (; i + 4 <= nwords; i += 4) {
+      __m256i xa = _mm256_loadu_si256((const __m256i *)(a1 + i));
+      __m256i xb = _mm256_loadu_si256((const __m256i *)(b1 + i));
+      __m256i ya = _mm256_loadu_si256((const __m256i *)(a2 + i));
+      __m256i yb = _mm256_loadu_si256((const __m256i *)(b2 + i));
+
+      __m256i lknown1 = _mm256_andnot_si256(xb, xa);
+      __m256i rknown1 = _mm256_andnot_si256(yb, ya);
+      __m256i bx = _mm256_or_si256(_mm256_andnot_si256(rknown1, xb),
+                                   _mm256_andnot_si256(lknown1, yb));
+
+      __m256i a = _mm256_or_si256(_mm256_or_si256(xa, ya), bx);
+      _mm256_storeu_si256((__m256i *)(a1 + i), a);
+      _mm256_storeu_si256((__m256i *)(b1 + i), bx);
+   }
+
+   return i;
+}
+
+__attribute__((target("avx2")))
+static int vec4_xor2_avx2(int nwords, uint64_t *a1, uint64_t *b1,
+                          const uint64_t *a2, const uint64_t *b2)
+{
+   int i = 0;
+   for (; i + 4 <= nwords; i += 4) {
+      __m256i xa = _mm256_loadu_si256((const __m256i *)(a1 + i));
+      __m256i xb = _mm256_loadu_si256((const __m256i *)(b1 + i));
+      __m256i ya = _mm256_loadu_si256((const __m256i *)(a2 + i));
+      __m256i yb = _mm256_loadu_si256((const __m256i *)(b2 + i));
+
+      __m256i bx = _mm256_or_si256(xb, yb);
+      __m256i a = _mm256_or_si256(_mm256_xor_si256(xa, ya), bx);
+      _mm256_storeu_si256((__m256i *)(a1 + i), a);
+      _mm256_storeu_si256((__m256i *)(b1 + i), bx);
+   }
+
+   return i;
+}
+
+#endif  // HAVE_AVX2
+
 void vec4_and2(int size, uint64_t *a1, uint64_t *b1, const uint64_t *a2,
                const uint64_t *b2)
 {
-   for (int i = 0; i < BIGNUM_WORDS(size); i++) {
+   const int nwords = BIGNUM_WORDS(size);
+
+   int i = 0;
+#ifdef HAVE_AVX2
+   if (nwords >= 4 && __builtin_cpu_supports("avx2"))
+      i = vec4_and2_avx2(nwords, a1, b1, a2, b2);
+#endif
+
+   for (; i < nwords; i++) {
       const uint64_t lmaybe1 = a1[i] | b1[i];
       const uint64_t rmaybe1 = a2[i] | b2[i];
       const uint64_t bx = (b1[i] & rmaybe1) | (b2[i] & lmaybe1);
@@ -1699,7 +1786,15 @@ void vec4_and2(int size, uint64_t *a1, uint64_t *b1, const uint64_t *a2,
 void vec4_or2(int size, uint64_t *a1, uint64_t *b1, const uint64_t *a2,
               const uint64_t *b2)
 {
-   for (int i = 0; i < BIGNUM_WORDS(size); i++) {
+   const int nwords = BIGNUM_WORDS(size);
+
+   int i = 0;
+#ifdef HAVE_AVX2
+   if (nwords >= 4 && __builtin_cpu_supports("avx2"))
+      i = vec4_or2_avx2(nwords, a1, b1, a2, b2);
+#endif
+
+   for (; i < nwords; i++) {
       const uint64_t lknown1 = a1[i] & ~b1[i];
       const uint64_t rknown1 = a2[i] & ~b2[i];
       const uint64_t bx = (b1[i] & ~rknown1) | (b2[i] & ~lknown1);
@@ -1712,9 +1807,19 @@ void vec4_or2(int size, uint64_t *a1, uint64_t *b1, const uint64_t *a2,
 void vec4_xor2(int size, uint64_t *a1, uint64_t *b1, const uint64_t *a2,
                const uint64_t *b2)
 {
-   vec2_xor2(size, a1, a2);
-   vec2_or2(size, b1, b2);
-   vec2_or2(size, a1, b1);
+   const int nwords = BIGNUM_WORDS(size);
+
+   int i = 0;
+#ifdef HAVE_AVX2
+   if (nwords >= 4 && __builtin_cpu_supports("avx2"))
+      i = vec4_xor2_avx2(nwords, a1, b1, a2, b2);
+#endif
+
+   for (; i < nwords; i++) {
+      const uint64_t bx = b1[i] | b2[i];
+      a1[i] = (a1[i] ^ a2[i]) | bx;
+      b1[i] = bx;
+   }
 }
 
 #define VEC4_CMP_OP(name)                                               \
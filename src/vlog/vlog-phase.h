@@ -21,6 +21,7 @@
 #include "prim.h"
 
 void vlog_preprocess(text_buf_t *tb, bool precise);
+void vlog_preprocess_stream(text_buf_t *tb, bool precise);
 vlog_node_t vlog_parse(void);
 void vlog_check(vlog_node_t v);
 void vlog_dump(vlog_node_t v, int indent);
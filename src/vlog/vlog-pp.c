@@ -27,6 +27,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#define PP_CHUNK_SIZE 0x10000
+
 typedef struct _ifdef_stack ifdef_stack_t;
 
 #define BEGIN(s)                                         \
@@ -62,6 +64,7 @@ static bool           emit_locs;
 static pp_mode_t      mode;
 static parse_state_t  state;
 static hash_t        *macro_args = NULL;
+static char           flushed_last;
 
 extern loc_t yylloc;
 extern yylval_t yylval;
@@ -681,7 +684,7 @@ static void p_text_macro_usage(void)
    // newline, the macro is expanding in the middle of a token (e.g.
    // 32'd`MACRO) and inserting directives would break the token.
    const size_t outlen = tb_len(output);
-   const char last = outlen > 0 ? tb_get(output)[outlen - 1] : '\0';
+   const char last = outlen > 0 ? tb_get(output)[outlen - 1] : flushed_last;
    const bool at_boundary = last == '\0' || last == ' '
       || last == '\t' || last == '\n';
 
@@ -977,7 +980,7 @@ static void p_source_text(void)
       p_block_of_text();
 }
 
-void vlog_preprocess(text_buf_t *tb, bool precise)
+static void vlog_preprocess_begin(text_buf_t *tb, bool precise)
 {
    if (macros == NULL) {
       macros = hash_new(64);
@@ -994,13 +997,15 @@ void vlog_preprocess(text_buf_t *tb, bool precise)
 
    emit_locs = precise;
    mode = PP_INITIAL;
+   flushed_last = '\0';
 
    state.n_correct = RECOVER_THRESH;
    state.tokenq_head = state.tokenq_tail = 0;
    state.lex_fn = vlogpp_lex;
+}
 
-   p_source_text();
-
+static void vlog_preprocess_end(void)
+{
    assert(ifdefs == NULL);
    assert(macro_args == NULL);
    output = NULL;
@@ -1008,3 +1013,45 @@ void vlog_preprocess(text_buf_t *tb, bool precise)
    if (!opt_get_int(OPT_SINGLE_UNIT))
       free_macros();
 }
+
+void vlog_preprocess(text_buf_t *tb, bool precise)
+{
+   vlog_preprocess_begin(tb, precise);
+
+   p_source_text();
+
+   vlog_preprocess_end();
+}
+
+static size_t vlog_preprocess_fill(const char **chunk, void *ctx)
+{
+   text_buf_t *tb = ctx;
+
+   if (output == NULL)
+      return 0;   // Already reached the end of the source text
+
+   const size_t outlen = tb_len(tb);
+   if (outlen > 0)
+      flushed_last = tb_get(tb)[outlen - 1];
+
+   tb_rewind(tb);
+
+   // Directives such as `include and `ifdef are expanded completely by
+   // a single call to p_block_of_text so a chunk may exceed the
+   // nominal size but never splits one
+   while (tb_len(tb) < PP_CHUNK_SIZE && not_at_token(tEOF))
+      p_block_of_text();
+
+   if (tb_len(tb) < PP_CHUNK_SIZE)
+      vlog_preprocess_end();
+
+   *chunk = tb_get(tb);
+   return tb_len(tb);
+}
+
+void vlog_preprocess_stream(text_buf_t *tb, bool precise)
+{
+   vlog_preprocess_begin(tb, precise);
+
+   input_from_stream(vlog_preprocess_fill, tb);
+}
@@ -25,6 +25,13 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Limits on the size of the dense lookup table used to evaluate a UDP
+#define UDP_TABLE_MAX_INPUTS 8
+#define UDP_TABLE_MAX        0x20000
+
+#define UDP_NO_CHANGE 0xff
 
 #define CANNOT_HANDLE(v) do {                                           \
       fatal_at(vlog_loc(v), "cannot handle %s in %s" ,                  \
@@ -54,6 +61,7 @@ static mir_value_t vlog_udp_cmp(mir_unit_t *mu, mir_value_t left,
 
    switch (sym) {
    case 'b':
+   case 'B':
       {
          mir_value_t eq0 = mir_build_binary(mu, MIR_VEC_CASE_EQ, t_logic, left,
                                             level_map['0']);
@@ -61,7 +69,7 @@ static mir_value_t vlog_udp_cmp(mir_unit_t *mu, mir_value_t left,
                                             level_map['1']);
          mir_value_t test0 = mir_build_test(mu, eq0);
          mir_value_t test1 = mir_build_test(mu, eq1);
-         return mir_build_and(mu, test0, test1);
+         return mir_build_or(mu, test0, test1);
       }
    case '*':
       should_not_reach_here();
@@ -74,6 +82,194 @@ static mir_value_t vlog_udp_cmp(mir_unit_t *mu, mir_value_t left,
    }
 }
 
+static bool vlog_udp_match(unsigned sym, int code)
+{
+   switch (sym) {
+   case '?': return true;
+   case '0': return code == 0;
+   case '1': return code == 1;
+   case 'x':
+   case 'X': return code == 3;
+   case 'b':
+   case 'B': return code == 0 || code == 1;
+   default: return false;
+   }
+}
+
+static bool vlog_udp_row_match(vlog_node_t entry, int ninputs,
+                               const int *codes, int state, int edge,
+                               int last)
+{
+   int pos = 0;
+   for (int j = 0; j < ninputs; j++) {
+      vlog_node_t sym = vlog_param(entry, pos++);
+      switch (vlog_kind(sym)) {
+      case V_UDP_LEVEL:
+         {
+            const unsigned val = vlog_ival(sym);
+            if (val == '*') {
+               if (edge != j)
+                  return false;
+            }
+            else if (!vlog_udp_match(val, codes[j]))
+               return false;
+         }
+         break;
+      case V_UDP_EDGE:
+         {
+            const unsigned left = vlog_ival(vlog_left(sym));
+            const unsigned right = vlog_ival(vlog_right(sym));
+
+            if (edge != j || !vlog_udp_match(left, last)
+                || !vlog_udp_match(right, codes[j]))
+               return false;
+         }
+         break;
+      default:
+         CANNOT_HANDLE(sym);
+      }
+   }
+
+   if (state >= 0) {
+      vlog_node_t sym = vlog_param(entry, pos++);
+      assert(vlog_kind(sym) == V_UDP_LEVEL);
+
+      if (!vlog_udp_match(vlog_ival(sym), state))
+         return false;
+   }
+
+   return true;
+}
+
+static uint8_t vlog_udp_next_state(vlog_node_t entry)
+{
+   vlog_node_t sym = vlog_param(entry, vlog_params(entry) - 1);
+   assert(vlog_kind(sym) == V_UDP_LEVEL);
+
+   switch (vlog_ival(sym)) {
+   case '0': return 0;
+   case '1': return 1;
+   case 'x':
+   case 'X': return 3;
+   case '-': return UDP_NO_CHANGE;
+   default: CANNOT_HANDLE(sym);
+   }
+}
+
+static uint8_t *vlog_udp_build_table(vlog_node_t table, int ninputs,
+                                     bool seq, size_t *count)
+{
+   // The table has one entry for every combination of input values
+   // and for sequential UDPs the current state and which input, if
+   // any, changed along with its previous value
+
+   if (ninputs > UDP_TABLE_MAX_INPUTS)
+      return NULL;
+
+   const size_t ncombs = UINT64_C(1) << (2 * ninputs);
+   const int nstates = seq ? 4 : 1;
+   const int nedges = seq ? 4 * (ninputs + 1) : 1;
+
+   *count = ncombs * nstates * nedges;
+   if (*count > UDP_TABLE_MAX)
+      return NULL;
+
+   const int nentries = vlog_params(table);
+
+   if (!seq) {
+      // Combinational rows sensitive to an event cannot be tabulated
+      for (int i = 0; i < nentries; i++) {
+         vlog_node_t entry = vlog_param(table, i);
+         for (int j = 0; j < ninputs; j++) {
+            if (vlog_ival(vlog_param(entry, j)) == '*')
+               return NULL;
+         }
+      }
+   }
+
+   uint8_t *entries = xmalloc(*count);
+   int *codes LOCAL = xmalloc_array(ninputs, sizeof(int));
+
+   size_t index = 0;
+   for (int sel = 0; sel < nedges; sel++) {
+      const int edge = sel / 4 - 1, last = sel % 4;
+      for (int state = 0; state < nstates; state++) {
+         for (size_t comb = 0; comb < ncombs; comb++) {
+            for (int j = 0; j < ninputs; j++)
+               codes[j] = (comb >> (2 * (ninputs - j - 1))) & 3;
+
+            uint8_t next = 3;   // X if no row matches
+            for (int i = 0; i < nentries; i++) {
+               vlog_node_t entry = vlog_param(table, i);
+               if (vlog_udp_row_match(entry, ninputs, codes,
+                                      seq ? state : -1, edge, last)) {
+                  next = vlog_udp_next_state(entry);
+                  break;
+               }
+            }
+
+            entries[index++] = next;
+         }
+      }
+   }
+
+   assert(index == *count);
+   return entries;
+}
+
+static mir_value_t vlog_udp_lookup(mir_unit_t *mu, const uint8_t *entries,
+                                   size_t count, mir_value_t plane,
+                                   const mir_value_t *args, int nargs)
+{
+   mir_type_t t_offset = mir_offset_type(mu);
+   mir_type_t t_uint8 = mir_int_type(mu, 0, UINT8_MAX);
+
+   mir_value_t *elems LOCAL = xmalloc_array(count, sizeof(mir_value_t));
+   for (size_t i = 0; i < count; i++)
+      elems[i] = mir_const(mu, t_uint8, entries[i]);
+
+   mir_type_t t_table = mir_carray_type(mu, count, t_uint8);
+   mir_value_t table = mir_const_array(mu, t_table, elems, count);
+   mir_value_t address = mir_build_address_of(mu, table);
+   mir_value_t stride = mir_const(mu, t_offset, 4);
+
+   if (!mir_is_null(plane))
+      address = mir_build_array_ref(mu, address, plane);
+
+   mir_value_t ptr = mir_build_table_ref(mu, address, stride, args, nargs);
+   return mir_build_load(mu, ptr);
+}
+
+static bool vlog_udp_has_no_change(const uint8_t *entries, size_t count)
+{
+   return memchr(entries, UDP_NO_CHANGE, count) != NULL;
+}
+
+static void vlog_udp_drive_entry(mir_unit_t *mu, mir_value_t entry,
+                                 bool no_change, mir_value_t result_var,
+                                 mir_block_t start_bb, mir_block_t wait_bb)
+{
+   mir_type_t t_logic = mir_vec4_type(mu, 1, false);
+   mir_type_t t_uint8 = mir_int_type(mu, 0, UINT8_MAX);
+
+   if (no_change) {
+      mir_block_t skip_bb = mir_add_block(mu);
+      mir_block_t store_bb = mir_add_block(mu);
+
+      mir_value_t nc = mir_const(mu, t_uint8, UDP_NO_CHANGE);
+      mir_value_t cmp = mir_build_cmp(mu, MIR_CMP_EQ, entry, nc);
+      mir_build_cond(mu, cmp, skip_bb, store_bb);
+
+      mir_set_cursor(mu, skip_bb, MIR_APPEND);
+      mir_build_wait(mu, start_bb);
+
+      mir_set_cursor(mu, store_bb, MIR_APPEND);
+   }
+
+   mir_build_store(mu, result_var, mir_build_pack(mu, t_logic, entry));
+   mir_build_jump(mu, wait_bb);
+}
+
 static void vlog_lower_comb_udp(mir_unit_t *mu, vlog_node_t udp)
 {
    vlog_node_t table = vlog_stmt(udp, 0);
@@ -158,9 +354,25 @@ static void vlog_lower_comb_udp(mir_unit_t *mu, vlog_node_t udp)
       in_nets[i - 1] = nets;
    }
 
+   size_t count;
+   uint8_t *entries LOCAL =
+      vlog_udp_build_table(table, nports - 1, false, &count);
+   if (entries != NULL) {
+      mir_value_t *codes LOCAL = xmalloc_array(nports - 1, sizeof(mir_value_t));
+      for (int i = 0; i < nports - 1; i++)
+         codes[i] = mir_build_unpack(mu, in_regs[i], 0, MIR_NULL_VALUE);
+
+      mir_value_t entry = vlog_udp_lookup(mu, entries, count, MIR_NULL_VALUE,
+                                          codes, nports - 1);
+
+      const bool no_change = vlog_udp_has_no_change(entries, count);
+      vlog_udp_drive_entry(mu, entry, no_change, result_var,
+                           start_bb, wait_bb);
+   }
+
    mir_block_t test_bb = mir_get_cursor(mu, NULL);
 
-   const int nentries = vlog_params(table);
+   const int nentries = entries == NULL ? vlog_params(table) : 0;
    for (int i = 0; i < nentries; i++) {
       vlog_node_t entry = vlog_param(table, i);
       assert(vlog_kind(entry) == V_UDP_ENTRY);
@@ -335,6 +547,64 @@ static void vlog_lower_seq_udp(mir_unit_t *mu, vlog_node_t udp)
 
       mir_block_t test_bb = start_bb;
 
+      size_t count;
+      uint8_t *entries LOCAL =
+         vlog_udp_build_table(table, nports - 1, true, &count);
+      if (entries != NULL) {
+         // The table only encodes a change on at most one input so
+         // fall back to testing each row when several change together
+         mir_value_t zero = mir_const(mu, t_offset, 0);
+         mir_value_t sel = zero, nevents = zero;
+
+         mir_value_t *codes LOCAL = xmalloc_array(nports, sizeof(mir_value_t));
+         for (int j = 0; j < nports - 1; j++) {
+            codes[j + 1] = mir_build_unpack(mu, in_regs[j], 0, MIR_NULL_VALUE);
+
+            mir_value_t event = mir_build_event_flag(mu, in_nets[j], one);
+
+            mir_value_t last_ptr = mir_build_last_value(mu, in_nets[j]);
+            mir_value_t last = mir_build_load(mu, last_ptr);
+            mir_value_t packed = mir_build_pack(mu, t_logic, last);
+            mir_value_t code = mir_build_unpack(mu, packed, 0, MIR_NULL_VALUE);
+
+            mir_value_t base = mir_const(mu, t_offset, 4 * (j + 1));
+            mir_value_t this = mir_build_add(mu, t_offset, base,
+                                             mir_build_cast(mu, t_offset, code));
+
+            sel = mir_build_select(mu, t_offset, event, this, sel);
+
+            mir_value_t inc = mir_build_add(mu, t_offset, nevents, one);
+            nevents = mir_build_select(mu, t_offset, event, inc, nevents);
+         }
+
+         mir_value_t upref = mir_build_var_upref(mu, hops, out_var.id);
+         mir_value_t out = mir_build_load(mu, upref);
+         mir_value_t cur = mir_build_load(mu, mir_build_resolved(mu, out));
+         mir_value_t packed = mir_build_pack(mu, t_logic, cur);
+         codes[0] = mir_build_unpack(mu, packed, 0, MIR_NULL_VALUE);
+
+         mir_block_t table_bb = mir_add_block(mu);
+         test_bb = mir_add_block(mu);
+
+         mir_value_t multi = mir_build_cmp(mu, MIR_CMP_GT, nevents, one);
+         mir_build_cond(mu, multi, test_bb, table_bb);
+
+         mir_set_cursor(mu, table_bb, MIR_APPEND);
+
+         const size_t plane_size = UINT64_C(1) << (2 * nports);
+         mir_value_t plane = mir_build_mul(mu, t_offset, sel,
+                                           mir_const(mu, t_offset, plane_size));
+
+         mir_value_t entry = vlog_udp_lookup(mu, entries, count, plane,
+                                             codes, nports);
+
+         const bool no_change = vlog_udp_has_no_change(entries, count);
+         vlog_udp_drive_entry(mu, entry, no_change, result_var,
+                              start_bb, wait_bb);
+
+         mir_set_cursor(mu, test_bb, MIR_APPEND);
+      }
+
       const int nentries = vlog_params(table);
       for (int i = 0; i < nentries; i++) {
          vlog_node_t entry = vlog_param(table, i);
@@ -0,0 +1,41 @@
+set -xe
+
+nvc -a - <<EOF
+entity cmdline21 is
+end entity;
+
+architecture test of cmdline21 is
+  type int_vector is array (natural range <>) of integer;
+  signal clk : bit := '0';
+  signal acc : int_vector(0 to 63) := (others => 0);
+begin
+  clk <= not clk after 5 ns when now < 1 us;
+
+  g: for i in acc'range generate
+    process (clk) is
+    begin
+      if clk'event and clk = '1' then
+        acc(i) <= (acc(i) * 7 + acc((i + 1) mod acc'length) + i) mod 65521;
+      end if;
+    end process;
+  end generate;
+
+  check: process is
+    variable sum : integer := 0;
+  begin
+    wait for 2 us;
+    for i in acc'range loop
+      sum := (sum * 31 + acc(i)) mod 65521;
+    end loop;
+    report "sum is " & integer'image(sum);
+    wait;
+  end process;
+end architecture;
+EOF
+
+nvc -e cmdline21 -r --threads=1 >serial.txt 2>&1
+nvc -r --threads=4 cmdline21 >parallel.txt 2>&1
+
+cat parallel.txt
+
+diff -u serial.txt parallel.txt
@@ -0,0 +1,43 @@
+set -xe
+
+nvc -a - <<EOF
+entity cmdline22 is
+end entity;
+
+architecture test of cmdline22 is
+  function fib (n : natural) return natural is
+  begin
+    if n < 2 then
+      return n;
+    else
+      return fib(n - 1) + fib(n - 2);
+    end if;
+  end function;
+begin
+  process is
+  begin
+    report "fib is " & integer'image(fib(20));
+    wait;
+  end process;
+end architecture;
+EOF
+
+# Compile synchronously so the cache is populated before exit
+export NVC_JIT_ASYNC=0
+
+nvc -e cmdline22 -r --jit-cache >first.txt 2>&1
+ls work/_NVC_JIT/*.o
+nvc -r --jit-cache cmdline22 >second.txt 2>&1
+nvc -r cmdline22 >third.txt 2>&1
+
+# A stale entry whose symbols no longer resolve is discarded
+for f in work/_NVC_JIT/*.o; do
+  LC_ALL=C sed 's/__nvc_/__xxx_/g' $f > tmp.o
+  mv tmp.o $f
+done
+NVC_JIT_LOG=1 nvc -r --jit-cache cmdline22 >fourth.txt 2>&1
+grep "discarding stale cache entry" fourth.txt
+grep "fib is 6765" fourth.txt
+
+diff -u first.txt second.txt
+diff -u first.txt third.txt
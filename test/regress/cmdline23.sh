@@ -0,0 +1,34 @@
+set -xe
+
+nvc -a - <<EOF
+entity cmdline23 is
+end entity;
+
+architecture test of cmdline23 is
+  signal clk1, clk2, clk3 : bit := '0';
+  signal count : natural;
+begin
+  clk1 <= not clk1 after 5 ns when now < 10 us;
+  clk2 <= not clk2 after 7 ns when now < 10 us;
+  clk3 <= not clk3 after 1 ms when now < 5 ms;
+
+  process (clk1, clk2, clk3) is
+  begin
+    count <= count + 1 after 3 ps;
+  end process;
+
+  process is
+  begin
+    wait for 20 ms;
+    report "count is " & natural'image(count);
+    wait;
+  end process;
+end architecture;
+EOF
+
+nvc -e cmdline23 -r --event-queue=heap >heap.txt 2>&1
+nvc -r --event-queue=wheel cmdline23 >wheel.txt 2>&1
+
+cat wheel.txt
+
+diff -u heap.txt wheel.txt
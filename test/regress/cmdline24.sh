@@ -0,0 +1,41 @@
+set -xe
+
+nvc -a - <<EOF
+entity sub is
+    port ( clk : in bit );
+end entity;
+
+architecture test of sub is
+    signal count : natural;
+begin
+    counter: process (clk) is
+    begin
+        if clk'event and clk = '1' then
+            count <= count + 1;
+        end if;
+    end process;
+end architecture;
+
+entity cmdline24 is
+end entity;
+
+architecture test of cmdline24 is
+    signal clk : bit := '0';
+begin
+    clkgen: clk <= not clk after 5 ns when now < 1 us;
+
+    u1: entity work.sub port map ( clk );
+    u2: entity work.sub port map ( clk );
+end architecture;
+EOF
+
+nvc -e cmdline24 -r --profile=prof.folded > out.txt
+
+cat out.txt
+
+grep -E '^cmdline24;u1;counter [0-9]+$' prof.folded
+grep -E '^cmdline24;u2;counter [0-9]+$' prof.folded
+grep -E '^cmdline24;clkgen [0-9]+$' prof.folded
+
+grep "Top processes by time" out.txt
+grep -E '^ +200 +[0-9]+  :cmdline24:clk$' out.txt
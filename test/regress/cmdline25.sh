@@ -0,0 +1,81 @@
+set -xe
+
+cat >pack.vhd <<EOF
+package pack is
+    constant WIDTH : natural := 8;
+end package;
+EOF
+
+cat >sub.vhd <<EOF
+use work.pack.all;
+
+entity sub is
+    port ( x : out bit_vector(1 to WIDTH) );
+end entity;
+
+architecture test of sub is
+begin
+    x <= (others => '1');
+end architecture;
+EOF
+
+cat >other.vhd <<EOF
+entity other is
+end entity;
+
+architecture test of other is
+begin
+end architecture;
+EOF
+
+cat >cmdline25.vhd <<EOF
+entity cmdline25 is
+end entity;
+
+architecture test of cmdline25 is
+    signal x : bit_vector(1 to 8);
+begin
+    u1: entity work.sub port map ( x );
+    u2: entity work.other;
+
+    check: process is
+    begin
+        wait for 1 ns;
+        assert x = X"ff";
+        report "PASSED";
+        wait;
+    end process;
+end architecture;
+EOF
+
+# Global options such as --std are passed on to each job
+nvc --std=2008 -a --jobs=4 pack.vhd sub.vhd other.vhd cmdline25.vhd
+nvc --std=2008 -e cmdline25 -r > out.txt
+grep PASSED out.txt
+
+# Files depending on one that failed to analyse are skipped
+cat >bad.vhd <<EOF
+package bad is
+    constant C : integer := "hello";
+end package;
+EOF
+
+cat >user.vhd <<EOF
+use work.bad.all;
+
+entity user is
+end entity;
+EOF
+
+if nvc --std=2008 -a --jobs=2 bad.vhd user.vhd other.vhd 2> err.txt; then
+    echo "expected analysis to fail"
+    exit 1
+fi
+
+cat err.txt
+grep -i "error" err.txt
+grep "skipping user.vhd which depends on bad.vhd" err.txt
+if grep "user.vhd:" err.txt; then
+    echo "user.vhd should not have been analysed"
+    exit 1
+fi
@@ -0,0 +1,40 @@
+set -xe
+
+nvc -a - <<EOF
+entity cmdline26 is
+end entity;
+
+architecture test of cmdline26 is
+  signal clk : bit := '0';
+  signal count : natural;
+
+  function next_count (n : natural) return natural is
+  begin
+    return n + 1;
+  end function;
+begin
+  clk <= not clk after 5 ns when now < 1 us;
+
+  counter: process (clk) is
+  begin
+    if clk'event and clk = '1' then
+      count <= next_count(count);
+    end if;
+  end process;
+
+  check: process is
+  begin
+    wait for 2 us;
+    assert count = 100;
+    report "PASSED";
+    wait;
+  end process;
+end architecture;
+EOF
+
+NVC_JIT_PRECOMPILE=1 NVC_JIT_LOG=1 nvc -e cmdline26 -r \
+  >out.txt 2>&1
+
+cat out.txt
+grep "precompiled [1-9][0-9]* functions" out.txt
+grep PASSED out.txt
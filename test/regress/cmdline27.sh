@@ -0,0 +1,31 @@
+set -xe
+
+nvc -a - <<EOF
+entity cmdline27 is
+end entity;
+
+architecture test of cmdline27 is
+  function fib (n : natural) return natural is
+  begin
+    if n < 2 then
+      return n;
+    else
+      return fib(n - 1) + fib(n - 2);
+    end if;
+  end function;
+begin
+  process is
+  begin
+    report "fib is " & integer'image(fib(20));
+    wait;
+  end process;
+end architecture;
+EOF
+
+nvc -e --aot cmdline27
+ls work/_NVC_JIT/*.o
+
+NVC_JIT_LOG=1 nvc -r --jit-cache cmdline27 >out.txt 2>&1
+cat out.txt
+grep "fib is 6765" out.txt
+grep "loaded from" out.txt
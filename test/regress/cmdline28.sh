@@ -0,0 +1,47 @@
+set -xe
+
+nvc -a - <<EOF
+entity cmdline28 is
+end entity;
+
+architecture test of cmdline28 is
+  function fib (n : natural) return natural is
+  begin
+    if n < 2 then
+      return n;
+    else
+      return fib(n - 1) + fib(n - 2);
+    end if;
+  end function;
+begin
+  process is
+  begin
+    report "fib is " & integer'image(fib(20));
+    wait;
+  end process;
+end architecture;
+EOF
+
+nvc -e cmdline28 -r --jit-profile=prof.txt >first.txt 2>&1
+cat prof.txt
+grep -i "fib" prof.txt
+
+nvc -r --jit-profile=prof.txt cmdline28 >second.txt 2>&1
+diff -u first.txt second.txt
+grep -i "fib" prof.txt
+
+# With a threshold too high for fib to become hot during the run it is
+# only compiled if it was loaded from the profile
+export NVC_JIT_THRESHOLD=1000000
+export NVC_JIT_ASYNC=0
+export NVC_JIT_LOG=1
+
+nvc -r cmdline28 >third.txt 2>&1
+if grep -i "fib.* at 0x" third.txt; then
+  echo "fib should not have been compiled without a profile"
+  exit 1
+fi
+
+nvc -r --jit-profile=prof.txt cmdline28 >fourth.txt 2>&1
+grep -i "fib.* at 0x" fourth.txt
+grep "fib is 6765" fourth.txt
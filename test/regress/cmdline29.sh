@@ -0,0 +1,66 @@
+set -xe
+
+cat >pack.vhd <<EOF
+package pack is
+    constant WIDTH : natural := 8;
+end package;
+EOF
+
+cat >user.vhd <<EOF
+use work.pack.all;
+
+entity cmdline29 is
+end entity;
+
+architecture test of cmdline29 is
+begin
+    check: process is
+    begin
+        report "WIDTH=" & integer'image(WIDTH);
+        wait;
+    end process;
+end architecture;
+EOF
+
+nvc -a --incremental pack.vhd user.vhd
+nvc -e cmdline29 -r > out.txt
+grep "WIDTH=8" out.txt
+
+# Unchanged files are not analysed again
+nvc -a --incremental --verbose pack.vhd user.vhd > out.txt 2>&1
+grep "skipped unchanged file pack.vhd" out.txt
+grep "skipped unchanged file user.vhd" out.txt
+
+# Changing a dependency causes dependent files to be analysed again
+cat >pack.vhd <<EOF
+package pack is
+    constant WIDTH : natural := 16;
+end package;
+EOF
+
+nvc -a --incremental --verbose pack.vhd user.vhd > out.txt 2>&1
+if grep "skipped unchanged file" out.txt; then
+    echo "pack.vhd and user.vhd should have been analysed"
+    exit 1
+fi
+
+nvc -e cmdline29 -r > out.txt
+grep "WIDTH=16" out.txt
+
+# Analysing a dependency without --incremental also invalidates files
+# that depend on it
+cat >pack.vhd <<EOF
+package pack is
+    constant WIDTH : natural := 32;
+end package;
+EOF
+
+nvc -a pack.vhd
+nvc -a --incremental --verbose user.vhd > out.txt 2>&1
+if grep "skipped unchanged file user.vhd" out.txt; then
+    echo "user.vhd should have been analysed"
+    exit 1
+fi
+
+nvc -e cmdline29 -r > out.txt
+grep "WIDTH=32" out.txt
@@ -0,0 +1,27 @@
+set -xe
+
+# Preprocessed output larger than a single chunk
+{
+    echo '`define INC(x) ((x) + 1)'
+    echo 'module cmdline30;'
+    for i in $(seq 0 4999); do
+        echo "  wire [15:0] w$i = \`INC($i);"
+    done
+    echo '  initial begin'
+    echo '    #1;'
+    echo '    if (w0 !== 1 || w2500 !== 2501 || w4999 !== 5000)'
+    echo '      $display("FAILED");'
+    echo '    else'
+    echo '      $display("PASSED");'
+    echo '  end'
+    echo '  wire [15:0] late = 1 `UNDEFINED;'
+    echo 'endmodule'
+} > cmdline30.v
+
+nvc -a cmdline30.v -e cmdline30 -r >out.txt 2>&1
+cat out.txt
+
+# Locations after many chunks still refer to the original source
+grep "cmdline30.v:5010" out.txt
+grep "macro 'UNDEFINED' undefined" out.txt
+grep PASSED out.txt
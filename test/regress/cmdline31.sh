@@ -0,0 +1,84 @@
+set -xe
+
+nvc -a - <<EOF
+entity cmdline31 is
+end entity;
+
+architecture test of cmdline31 is
+  type scoreboard_t is protected
+    procedure add (n : integer);
+    impure function get return integer;
+  end protected;
+
+  type scoreboard_t is protected body
+    variable total : integer := 0;
+
+    procedure add (n : integer) is
+    begin
+      total := (total * 3 + n) mod 65521;
+    end procedure;
+
+    impure function get return integer is
+    begin
+      return total;
+    end function;
+  end protected body;
+
+  type int_vector is array (natural range <>) of integer;
+
+  shared variable sb : scoreboard_t;
+  signal clk : bit := '0';
+  signal acc : int_vector(0 to 31) := (others => 0);
+begin
+  clk <= not clk after 5 ns when now < 200 ns;
+
+  g: for i in 0 to 31 generate
+    process (clk) is
+    begin
+      if clk'event and clk = '1' then
+        sb.add(i);
+        report "process " & integer'image(i) & " at " & time'image(now);
+      end if;
+    end process;
+  end generate;
+
+  -- These can still run on worker threads
+  h: for i in acc'range generate
+    process (clk) is
+    begin
+      if clk'event and clk = '1' then
+        acc(i) <= (acc(i) * 7 + acc((i + 1) mod acc'length) + i) mod 65521;
+      end if;
+    end process;
+  end generate;
+
+  -- Must run after every process in h and before check
+  k: for i in 0 to 3 generate
+    process (clk) is
+    begin
+      if clk'event and clk = '1' then
+        sb.add(acc(i * 8));
+        report "acc(" & integer'image(i * 8) & ") is "
+          & integer'image(acc(i * 8));
+      end if;
+    end process;
+  end generate;
+
+  check: process is
+  begin
+    wait for 1 us;
+    report "total is " & integer'image(sb.get)
+      & " last is " & integer'image(acc(31));
+    wait;
+  end process;
+end architecture;
+EOF
+
+nvc -e cmdline31 -r --threads=1 >serial.txt 2>&1
+nvc -r --threads=4 cmdline31 >parallel.txt 2>&1
+
+cat parallel.txt
+
+# Protected calls and report output happen in the same order as a
+# serial run
+diff -u serial.txt parallel.txt
@@ -0,0 +1,11 @@
+set -xe
+
+# Generational collection with the write barrier in LLVM generated code
+export NVC_GC_GENERATIONAL=1
+export NVC_GC_STRESS=1
+export NVC_JIT_THRESHOLD=1
+export NVC_JIT_ASYNC=0
+
+nvc -H 1m -a $TESTDIR/regress/gc1.vhd -e gc1 -r >out.txt 2>&1
+cat out.txt
+grep PASSED out.txt
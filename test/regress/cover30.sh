@@ -0,0 +1,24 @@
+set -xe
+
+nvc -a $TESTDIR/regress/cover27.vhd
+
+nvc -e -gG_PAR=0 --cover=statement --cover-file=a.ncdb cover27 -r
+nvc -e -gG_PAR=1 --cover=statement --cover-file=b.ncdb cover27 -r
+
+# Several copies from the same design exercise the identical scope fast
+# path and the different designs exercise the general merge
+for i in 1 2 3 4 5; do
+    cp a.ncdb a$i.ncdb
+    cp b.ncdb b$i.ncdb
+done
+
+NVC_MAX_THREADS=1 nvc --cover-merge a*.ncdb b*.ncdb --output=serial.ncdb
+NVC_MAX_THREADS=4 nvc --cover-merge a*.ncdb b*.ncdb --output=parallel.ncdb
+
+nvc --cover-export --format=xml -o serial.xml serial.ncdb
+nvc --cover-export --format=xml -o parallel.xml parallel.ncdb
+
+diff -u serial.xml parallel.xml
+
+# Statement counts are summed over the six copies of each design
+grep 'G_IF_GEN.P1._S0" data="6"' parallel.xml
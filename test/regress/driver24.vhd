@@ -0,0 +1,76 @@
+entity driver24 is
+end entity;
+
+library ieee;
+use ieee.std_logic_1164.all;
+
+architecture test of driver24 is
+    type t_abc is ('a', 'b', 'c');
+    type t_abc_vector is array (natural range <>) of t_abc;
+
+    -- Matches folding the two input case for up to three drivers only
+    function odd_resolution (v : t_abc_vector) return t_abc is
+        variable result : t_abc := 'a';
+    begin
+        if v'length = 4 then
+            return 'c';
+        end if;
+        for i in v'range loop
+            if v(i) > result then
+                result := v(i);
+            end if;
+        end loop;
+        return result;
+    end function;
+
+    subtype t_odd is odd_resolution t_abc;
+
+    signal bus64 : std_logic_vector(63 downto 0);
+    signal odd   : t_odd;
+begin
+
+    h: for i in 0 to 3 generate
+        odd <= 'a';
+    end generate;
+
+    -- Eight tri-state drivers on a wide bus
+    g: for i in 0 to 7 generate
+        process is
+        begin
+            bus64 <= (others => 'Z');
+            wait for 1 ns;
+            if i = 3 then
+                bus64 <= X"0123456789abcdef";
+            end if;
+            wait for 1 ns;
+            if i = 3 then
+                bus64 <= (others => 'Z');
+            elsif i = 5 then
+                bus64 <= (others => 'H');
+            elsif i = 6 then
+                bus64(31 downto 0) <= (others => 'L');
+            end if;
+            wait for 1 ns;
+            if i = 1 then
+                bus64 <= (others => '1');
+            end if;
+            wait;
+        end process;
+    end generate;
+
+    check: process is
+    begin
+        wait for 500 ps;
+        assert bus64 = (63 downto 0 => 'Z');
+        wait for 1 ns;
+        assert bus64 = X"0123456789abcdef";
+        wait for 1 ns;
+        assert bus64 = (63 downto 32 => 'H', 31 downto 0 => 'W');
+        wait for 1 ns;
+        assert bus64(63 downto 32) = (63 downto 32 => '1');
+        assert bus64(31 downto 0) = (31 downto 0 => '1');
+        assert odd = 'c';
+        wait;
+    end process;
+
+end architecture;
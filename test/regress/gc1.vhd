@@ -0,0 +1,69 @@
+-- Old records updated to point at newly allocated objects
+entity gc1 is
+end entity;
+
+architecture test of gc1 is
+    type int_ptr is access integer;
+    type str_ptr is access string;
+
+    type pair is record
+        a, b : int_ptr;
+    end record;
+
+    type node;
+    type node_ptr is access node;
+
+    type node is record
+        value : int_ptr;
+        both  : pair;
+        next  : node_ptr;
+    end record;
+
+    procedure make_garbage (n : natural) is
+        variable tmp : str_ptr;
+    begin
+        for i in 1 to n loop
+            tmp := new string(1 to 1000);
+        end loop;
+    end procedure;
+
+begin
+
+    p1: process is
+        variable head, it : node_ptr;
+        variable tmp      : pair;
+    begin
+        for i in 1 to 20 loop
+            head := new node'(value => null, both => (null, null),
+                              next => head);
+        end loop;
+
+        -- Promote the list to the old generation
+        make_garbage(2000);
+
+        for round in 1 to 10 loop
+            it := head;
+            while it /= null loop
+                it.value := new integer'(round);
+                tmp := (new integer'(round * 2), new integer'(round * 3));
+                it.both := tmp;         -- Aggregate copy with pointers
+                it := it.next;
+            end loop;
+
+            make_garbage(500);
+            wait for 1 ns;
+
+            it := head;
+            while it /= null loop
+                assert it.value.all = round;
+                assert it.both.a.all = round * 2;
+                assert it.both.b.all = round * 3;
+                it := it.next;
+            end loop;
+        end loop;
+
+        report "PASSED";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,54 @@
+--
+-- READLINE with long lines, CR/LF line endings, and no final newline
+--
+entity textio9 is
+end entity;
+
+use std.textio.all;
+
+architecture test of textio9 is
+begin
+
+    p1: process is
+        file f     : text;
+        variable l : line;
+        variable s : string(1 to 1000);
+    begin
+        for i in s'range loop
+            s(i) := character'val(character'pos('a') + i mod 26);
+        end loop;
+
+        file_open(f, "textio9.txt", write_mode);
+        write(f, "hello" & LF);
+        write(f, "crlf" & CR & LF);
+        write(f, (1 => LF));
+        write(f, s & LF);
+        write(f, "last");
+        file_close(f);
+
+        file_open(f, "textio9.txt", read_mode);
+
+        readline(f, l);
+        assert l.all = "hello";
+        assert l'left = 1;
+
+        readline(f, l);
+        assert l.all = "crlf";
+
+        readline(f, l);
+        assert l'length = 0;
+
+        readline(f, l);
+        assert l.all = s;
+
+        assert not endfile(f);
+        readline(f, l);
+        assert l.all = "last";
+
+        assert endfile(f);
+        file_close(f);
+
+        wait;
+    end process;
+
+end architecture;
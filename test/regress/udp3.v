@@ -0,0 +1,75 @@
+primitive u_ao(o, a, b, c);
+  output o;
+  input  a, b, c;
+  table
+  // a b c : o
+     1 1 ? : 1 ;
+     ? ? 1 : 1 ;
+     0 ? 0 : 0 ;
+     ? 0 0 : 0 ;
+  endtable
+endprimitive
+
+primitive u_dffr(q, d, c, r);
+  output q;
+  reg    q;
+  input  d, c, r;
+  table
+  // d c r : q : q+
+     ? ? 1 : ? : 0 ;
+     0 r 0 : ? : 0 ;
+     1 r 0 : ? : 1 ;
+     ? f 0 : ? : - ;
+     * ? 0 : ? : - ;
+     ? ? f : ? : - ;
+  endtable
+endprimitive
+
+module udp3;
+  reg  a, b, c, d, clk, rst, failed;
+  wire o, q;
+
+  u_ao   g0(o, a, b, c);
+  u_dffr ff0(q, d, clk, rst);
+
+  initial begin
+    failed = 0;
+
+    a = 1; b = 1; c = 0;
+    #1 if (o !== 1) failed = 1;
+    a = 0;
+    #1 if (o !== 0) failed = 1;
+    c = 1;
+    #1 if (o !== 1) failed = 1;
+    a = 1'bx; b = 1; c = 0;
+    #1 if (o !== 1'bx) failed = 1;
+    a = 1'bz; b = 0;
+    #1 if (o !== 0) failed = 1;
+
+    d = 0; clk = 0; rst = 1;
+    #1 if (q !== 0) failed = 1;
+    rst = 0;
+    #1 if (q !== 0) failed = 1;
+    d = 1;
+    #1 clk = 1;
+    #1 if (q !== 1) failed = 1;
+    clk = 0;
+    #1 if (q !== 1) failed = 1;
+    d = 0;
+    #1 if (q !== 1) failed = 1;
+    rst = 1;
+    #1 if (q !== 0) failed = 1;
+    rst = 0;
+    #1 if (q !== 0) failed = 1;
+
+    // Data and clock change in the same cycle
+    {d, clk} = 2'b11;
+    #1 if (q !== 1) failed = 1;
+
+    if (failed)
+      $display("FAILED");
+    else
+      $display("PASSED");
+  end
+
+endmodule // udp3
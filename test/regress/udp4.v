@@ -0,0 +1,55 @@
+// The same rows evaluated with the dense lookup table and, for the
+// primitive with too many inputs to tabulate, compared row by row
+primitive u_tab(o, a, b);
+  output o;
+  input  a, b;
+  table
+  // a b : o
+     b 0 : 1 ;
+     B 1 : 0 ;
+  endtable
+endprimitive
+
+primitive u_wide(o, a, b, p1, p2, p3, p4, p5, p6, p7);
+  output o;
+  input  a, b, p1, p2, p3, p4, p5, p6, p7;
+  table
+  // a b p1 p2 p3 p4 p5 p6 p7 : o
+     b 0 ?  ?  ?  ?  ?  ?  ?  : 1 ;
+     B 1 ?  ?  ?  ?  ?  ?  ?  : 0 ;
+  endtable
+endprimitive
+
+module udp4;
+  reg  a, b, p, failed;
+  wire o1, o2;
+
+  u_tab  g0(o1, a, b);
+  u_wide g1(o2, a, b, p, p, p, p, p, p, p);
+
+  initial begin
+    failed = 0;
+    p = 0;
+
+    a = 0; b = 0;
+    #1 if (o1 !== 1 || o2 !== 1) failed = 1;
+    a = 1;
+    #1 if (o1 !== 1 || o2 !== 1) failed = 1;
+    b = 1;
+    #1 if (o1 !== 0 || o2 !== 0) failed = 1;
+    a = 0;
+    #1 if (o1 !== 0 || o2 !== 0) failed = 1;
+    a = 1'bx;
+    #1 if (o1 !== 1'bx || o2 !== 1'bx) failed = 1;
+    b = 0;
+    #1 if (o1 !== 1'bx || o2 !== 1'bx) failed = 1;
+    a = 1'bz;
+    #1 if (o1 !== 1'bx || o2 !== 1'bx) failed = 1;
+
+    if (failed)
+      $display("FAILED");
+    else
+      $display("PASSED");
+  end
+
+endmodule // udp4
@@ -0,0 +1,50 @@
+set -xe
+
+nvc -a - <<EOF2
+library ieee;
+use ieee.std_logic_1164.all;
+
+entity wave14 is
+end entity;
+
+architecture test of wave14 is
+    signal x : std_logic;
+    signal y : std_logic_vector(1 to 3) := "ZZZ";
+    signal r : real := 1.5;
+begin
+
+    main: process is
+    begin
+        x <= '1';
+        wait for 1 ns;
+        y <= "101";
+        x <= '0';
+        r <= 2.25;
+        wait;
+    end process;
+
+end architecture;
+EOF2
+
+nvc -e wave14 -r -w --format=vcd
+
+grep '^\$enddefinitions \$end$' wave14.vcd
+grep '^\$var logic 1 ! x \$end$' wave14.vcd
+grep '^\$var logic 3 " y \$end$' wave14.vcd
+grep '^\$var real 64 # r \$end$' wave14.vcd
+grep '^#1000000$' wave14.vcd
+grep '^b101 "$' wave14.vcd
+grep '^r2.25 #$' wave14.vcd
+
+if which gzip; then
+  nvc -r --wave=wave14.vcd.gz --format=vcd wave14
+  gzip -dc wave14.vcd.gz | sed '/^\$date/,/^\$end/d' > gz.txt
+  sed '/^\$date/,/^\$end/d' wave14.vcd > plain.txt
+  diff -u plain.txt gz.txt
+fi
+
+nvc -r -w --format=fst wave14
+fstdump wave14.fst > wave14.dump
+grep '^#0 wave14.x 1$' wave14.dump
+grep '^#1000000 wave14.x 0$' wave14.dump
+grep '^#1000000 wave14.y\[1:3\] 101$' wave14.dump
@@ -0,0 +1,7 @@
+set -xe
+
+nvc -a $TESTDIR/regress/wave2.vhd -e wave2 -r -w --wave-async \
+    --exclude '*foo' --include ':wave2:*'
+
+fstdump wave2.fst > wave2.dump
+diff -u $TESTDIR/regress/gold/wave2.dump wave2.dump
@@ -0,0 +1,55 @@
+module wide8;
+
+  reg [99:0]  a, b;
+  reg [299:0] c, d;
+  reg         failed;
+
+  initial begin
+    failed = 0;
+    a = {4'b01xz, 96'h0123456789abcdef01234567};
+    b = {4'b0011, 96'hffffffff00000000ffffffff};
+    #1;
+
+    if ((a & b) !== {4'b00xx, 96'h012345670000000001234567}) begin
+      $display("and: %b", a & b);
+      failed = 1;
+    end
+
+    if ((a | b) !== {4'b0111, 96'hffffffff89abcdefffffffff}) begin
+      $display("or: %b", a | b);
+      failed = 1;
+    end
+
+    if ((a ^ b) !== {4'b01xx, 96'hfedcba9889abcdeffedcba98}) begin
+      $display("xor: %b", a ^ b);
+      failed = 1;
+    end
+
+    if ((a === a) !== 1'b1 || (a === b) !== 1'b0 || (a !== b) !== 1'b1) begin
+      $display("case equality");
+      failed = 1;
+    end
+
+    if ((a == a) !== 1'bx || (a == b) !== 1'b0 || (a != b) !== 1'b1
+        || (b == b) !== 1'b1 || (b != b) !== 1'b0) begin
+      $display("logical equality");
+      failed = 1;
+    end
+
+    c = {3{a}};
+    d = {3{b}};
+    #1;
+
+    if ((c & d) !== {3{a & b}} || (c | d) !== {3{a | b}}
+        || (c ^ d) !== {3{a ^ b}}) begin
+      $display("wide bitwise");
+      failed = 1;
+    end
+
+    if (failed)
+      $display("FAILED");
+    else
+      $display("PASSED");
+  end
+
+endmodule // wide8
@@ -52,6 +52,7 @@
 #include <windows.h>
 #include <fileapi.h>
 #define setenv(x, y, z) _putenv_s((x), (y))
+#define unsetenv(x) _putenv_s((x), "")
 #define realpath(N, R) _fullpath((R), (N), _MAX_PATH)
 #else
 #include <sys/wait.h>
@@ -108,6 +109,7 @@
 #define F_ARRAYS  (1 << 26)
 #define F_SEED    (1 << 27)
 #define F_PERFILE (1 << 28)
+#define F_LLVM    (1 << 29)
 
 typedef struct test test_t;
 typedef struct param param_t;
@@ -442,6 +444,8 @@ static bool parse_test_list(void)
             test->flags |= F_PSL;
          else if (strcmp(opt, "tcl") == 0)
             test->flags |= F_TCL;
+         else if (strcmp(opt, "llvm") == 0)
+            test->flags |= F_LLVM;
          else if (strcmp(opt, "shuffle") == 0)
             test->flags |= F_SHUFFLE;
          else if (strcmp(opt, "per-file") == 0)
@@ -840,7 +844,7 @@ static bool run_test(test_t *test)
    skip |= (test->flags & F_NOTBSD);
 #endif
 #ifndef HAVE_LLVM
-   skip |= (test->flags & F_SLOW);
+   skip |= (test->flags & (F_SLOW | F_LLVM));
 #else
    const char *threshold = getenv("NVC_JIT_THRESHOLD");
    if (threshold != NULL && atoi(threshold) == 0)
@@ -853,6 +857,8 @@ static bool run_test(test_t *test)
    if (skip) {
       if (skip & F_SLOW)
          skipped("slow with interpreter");
+      else if (skip & F_LLVM)
+         skipped("llvm not enabled");
       else if (skip & F_TCL)
          skipped("tcl not enabled");
       else if (skip & (F_NOTWIN | F_WAVE))
@@ -1394,6 +1400,12 @@ static bool run_test(test_t *test)
  out_close:
    fclose(outf);
 
+   // Do not leak environment variables into later tests
+   for (param_t *p = test->params; p != NULL; p = p->next) {
+      if (p->kind == P_ENVVAR)
+         unsetenv(p->name);
+   }
+
  out_chdir:
    if (chdir(cwd) != 0) {
       set_attr(ANSI_FG_RED);
@@ -24,6 +24,7 @@
 #include "printf.h"
 #include "rt/copy.h"
 #include "rt/heap.h"
+#include "rt/wheel.h"
 #include "thread.h"
 #include "util.h"
 #include "stdint.h"
@@ -407,6 +408,119 @@ START_TEST(test_heap_delete)
 }
 END_TEST
 
+START_TEST(test_wheel_basic)
+{
+   wheel_t *w = wheel_new();
+
+   wheel_insert(w, 5, (void*)5);
+   wheel_insert(w, 2, (void*)2);
+   wheel_insert(w, 62, (void*)62);
+   wheel_insert(w, UINT64_C(1) << 40, (void*)1);
+
+   ck_assert_int_eq(wheel_size(w), 4);
+   ck_assert_int_eq(wheel_min_key(w), 2);
+
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)2);
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)5);
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)62);
+
+   wheel_insert(w, 100, (void*)100);
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)100);
+
+   ck_assert_int_eq(wheel_min_key(w), UINT64_C(1) << 40);
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)1);
+
+   ck_assert_int_eq(wheel_size(w), 0);
+
+   wheel_free(w);
+}
+END_TEST
+
+START_TEST(test_wheel_rand)
+{
+   wheel_t *w = wheel_new();
+
+   static const int N = 4096;
+   uintptr_t keys[N];
+
+   for (int i = 0; i < N; i++) {
+      keys[i] = rand() >> (rand() % 24);
+      wheel_insert(w, keys[i], (void*)keys[i]);
+   }
+
+   qsort(keys, N, sizeof(uintptr_t), magnitude_compar);
+
+   for (int i = 0; i < N; i++) {
+      ck_assert_int_eq(wheel_min_key(w), keys[i]);
+      ck_assert_ptr_eq(wheel_extract_min(w), (void*)keys[i]);
+   }
+
+   wheel_free(w);
+}
+END_TEST
+
+START_TEST(test_wheel_delete)
+{
+   wheel_t *w = wheel_new();
+
+   static const int N = 1024;
+   uintptr_t keys[N];
+
+   for (int i = 0; i < N; i++) {
+      keys[i] = 1 + rand() % 10000;
+      wheel_insert(w, keys[i], (void*)keys[i]);
+   }
+
+   int deleted = 0;
+   for (int i = 0; i < N; i++) {
+      if (rand() % 20 == 0) {
+         ck_assert(wheel_delete(w, heap_delete_cb, (void*)keys[i]));
+         keys[i] = 0;
+         deleted++;
+      }
+   }
+
+   ck_assert_int_eq(wheel_size(w), N - deleted);
+
+   qsort(keys, N, sizeof(uintptr_t), magnitude_compar);
+
+   for (int i = deleted; i < N; i++)
+      ck_assert_ptr_eq(wheel_extract_min(w), (void*)keys[i]);
+
+   wheel_free(w);
+}
+END_TEST
+
+START_TEST(test_wheel_vs_heap)
+{
+   // Simulate the access pattern of the event queue where new keys are
+   // always relative to the most recently extracted key
+
+   wheel_t *w = wheel_new();
+   heap_t *h = heap_new(128);
+
+   uint64_t now = 0;
+   for (int i = 0; i < 100000; i++) {
+      if (heap_size(h) == 0 || rand() % 2 == 0) {
+         static const uint64_t ranges[] = { 64, 100000, UINT64_C(1) << 40 };
+         const uint64_t key = now + rand() % ranges[rand() % 3];
+         wheel_insert(w, key, (void*)(uintptr_t)key);
+         heap_insert(h, key, (void*)(uintptr_t)key);
+      }
+      else {
+         ck_assert_int_eq(wheel_min_key(w), heap_min_key(h));
+         now = heap_min_key(h);
+         ck_assert_ptr_eq(wheel_extract_min(w), heap_extract_min(h));
+      }
+
+      ck_assert_int_eq(wheel_size(w), heap_size(h));
+   }
+
+   wheel_free(w);
+   heap_free(h);
+}
+END_TEST
+
 START_TEST(test_strip)
 {
    LOCAL_TEXT_BUF tb = tb_new();
@@ -553,6 +667,30 @@ START_TEST(test_set_clear_range)
 }
 END_TEST
 
+START_TEST(test_claim_range)
+{
+   bit_mask_t m;
+   mask_init(&m, mask_size[_i]);
+
+   ck_assert(mask_claim_range(&m, 2, 3));
+   ck_assert(!mask_claim_range(&m, 2, 3));
+   ck_assert(!mask_claim_range(&m, 4, 1));
+   ck_assert_int_eq(mask_popcount(&m), 3);
+   fail_if(mask_test(&m, 1));
+   fail_if(mask_test(&m, 5));
+
+   if (mask_size[_i] > 64) {
+      ck_assert(mask_claim_range(&m, 60, mask_size[_i] - 60));
+      ck_assert_int_eq(mask_popcount(&m), mask_size[_i] - 57);
+      fail_if(mask_test(&m, 59));
+      fail_unless(mask_test(&m, mask_size[_i] - 1));
+      ck_assert(!mask_claim_range(&m, 60, 1));
+   }
+
+   mask_free(&m);
+}
+END_TEST
+
 START_TEST(test_count_clear)
 {
    bit_mask_t m;
@@ -938,6 +1076,80 @@ START_TEST(test_copy2)
 }
 END_TEST
 
+START_TEST(test_lookup_bytes)
+{
+   int8_t tab1[16], tab2[9][16];
+   for (int i = 0; i < 16; i++)
+      tab1[i] = 15 - i;
+   for (int i = 0; i < 9; i++) {
+      for (int j = 0; j < 16; j++)
+         tab2[i][j] = (i * 7 + j * 3) % 9;
+   }
+
+   uint8_t a[50], b[50];
+   for (int i = 0; i < ARRAY_LEN(a); i++) {
+      a[i] = (i * 5) % 9;
+      b[i] = (i * 11) % 16;
+   }
+
+   for (int size = 0; size < 50; size++) {
+      int8_t out[50 + 1];
+      out[size] = 100;
+
+      lookup1_bytes(out, b, tab1, size);
+
+      for (int i = 0; i < size; i++)
+         ck_assert_int_eq(out[i], tab1[b[i]]);
+      ck_assert_int_eq(out[size], 100);
+
+      lookup2_bytes(out, a, b, tab2, 9, size);
+
+      for (int i = 0; i < size; i++)
+         ck_assert_int_eq(out[i], tab2[a[i]][b[i]]);
+      ck_assert_int_eq(out[size], 100);
+   }
+}
+END_TEST
+
+START_TEST(test_fbuf_zip)
+{
+   static const fbuf_zip_t zip[] = {
+      FBUF_ZIP_NONE, FBUF_ZIP_FASTLZ, FBUF_ZIP_ZSTD
+   };
+
+   fbuf_t *f = fbuf_open("test.fbuf", FBUF_OUT, FBUF_CS_ADLER32);
+   ck_assert_ptr_nonnull(f);
+   fbuf_set_zip(f, zip[_i]);
+
+   for (int i = 0; i < 100000; i++) {
+      fbuf_put_uint(f, i * 7);
+      write_u32(i, f);
+   }
+   write_raw("hello", 6, f);
+
+   uint32_t wsum;
+   fbuf_close(f, &wsum);
+
+   f = fbuf_open("test.fbuf", FBUF_IN, FBUF_CS_ADLER32);
+   ck_assert_ptr_nonnull(f);
+
+   for (int i = 0; i < 100000; i++) {
+      ck_assert_int_eq(fbuf_get_uint(f), i * 7);
+      ck_assert_int_eq(read_u32(f), i);
+   }
+
+   char buf[6];
+   read_raw(buf, sizeof(buf), f);
+   ck_assert_str_eq(buf, "hello");
+
+   uint32_t rsum;
+   fbuf_close(f, &rsum);
+   ck_assert_int_eq(rsum, wsum);
+
+   remove("test.fbuf");
+}
+END_TEST
+
 Suite *get_misc_tests(void)
 {
    Suite *s = suite_create("misc");
@@ -963,8 +1175,16 @@ Suite *get_misc_tests(void)
    tcase_add_test(tc_heap, test_heap_delete);
    suite_add_tcase(s, tc_heap);
 
+   TCase *tc_wheel = tcase_create("wheel");
+   tcase_add_test(tc_wheel, test_wheel_basic);
+   tcase_add_test(tc_wheel, test_wheel_rand);
+   tcase_add_test(tc_wheel, test_wheel_delete);
+   tcase_add_test(tc_wheel, test_wheel_vs_heap);
+   suite_add_tcase(s, tc_wheel);
+
    TCase *tc_util = tcase_create("util");
    tcase_add_test(tc_util, test_strip);
+   tcase_add_loop_test(tc_util, test_fbuf_zip, 0, 3);
    suite_add_tcase(s, tc_util);
 
    TCase *tc_printf = tcase_create("printf");
@@ -974,6 +1194,7 @@ Suite *get_misc_tests(void)
    TCase *tc_mask = tcase_create("mask");
    tcase_add_loop_test(tc_mask, test_mask, 0, ARRAY_LEN(mask_size));
    tcase_add_loop_test(tc_mask, test_set_clear_range, 0, ARRAY_LEN(mask_size));
+   tcase_add_loop_test(tc_mask, test_claim_range, 0, ARRAY_LEN(mask_size));
    tcase_add_loop_test(tc_mask, test_count_clear, 0, ARRAY_LEN(mask_size));
    tcase_add_loop_test(tc_mask, test_scan_backwards, 0, ARRAY_LEN(mask_size));
    tcase_add_loop_test(tc_mask, test_subtract, 0, ARRAY_LEN(mask_size));
@@ -998,6 +1219,7 @@ Suite *get_misc_tests(void)
    TCase *tc_copy = tcase_create("copy");
    tcase_add_test(tc_pool, test_cmp_bytes);
    tcase_add_test(tc_pool, test_copy2);
+   tcase_add_test(tc_copy, test_lookup_bytes);
    suite_add_tcase(s, tc_copy);
 
    return s;
@@ -16,9 +16,11 @@
 //
 
 #include "test_util.h"
+#include "option.h"
 #include "rt/mspace.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 START_TEST(test_sanity)
 {
@@ -294,6 +296,136 @@ START_TEST(test_end_ptr)
 }
 END_TEST
 
+START_TEST(test_small_cache)
+{
+   mspace_t *m = mspace_new(0x100000);
+
+   // Small objects are allocated from a per-thread cache and larger
+   // objects from the shared free lists
+   char *small[100];
+   for (int i = 0; i < ARRAY_LEN(small); i++) {
+      small[i] = mspace_alloc(m, 40);
+      ck_assert_ptr_nonnull(small[i]);
+      memset(small[i], i, 40);
+   }
+
+   char *large = mspace_alloc(m, 4096);
+   ck_assert_ptr_nonnull(large);
+   memset(large, 0xff, 4096);
+
+   for (int i = 0; i < ARRAY_LEN(small); i++) {
+      size_t size;
+      ck_assert_ptr_eq(mspace_find(m, small[i] + 20, &size), small[i]);
+      ck_assert_int_eq(size, 64);
+
+      for (int j = 0; j < 40; j++)
+         ck_assert_int_eq(small[i][j], i);
+   }
+
+   size_t size;
+   ck_assert_ptr_eq(mspace_find(m, large + 4000, &size), large);
+   ck_assert_int_eq(size, 4096 + 32);
+
+   mspace_destroy(m);
+}
+END_TEST
+
+START_TEST(test_write_barrier)
+{
+   opt_set_int(OPT_GC_GENERATIONAL, 1);
+
+   mspace_t *m = mspace_new(0x10000);
+
+   tlab_t *t = tlab_acquire(m);
+   ck_assert_int_eq(t->heapsize, 0x10000);
+   tlab_release(t);
+
+   generate_garbage(m, 5, sizeof(int));
+
+   // Promote the table to the old generation with a full collection
+   mptr_t p = mptr_new(m, "table");
+   *mptr_get(p) = mspace_alloc(m, 16 * sizeof(int *));
+   memset(*mptr_get(p), '\0', 16 * sizeof(int *));
+   generate_garbage(m, 5000, sizeof(int));
+
+   // Overwrite slots in the old table with pointers to young objects
+   // which are only reachable through the table
+   for (int round = 0; round < 10; round++) {
+      for (int i = 0; i < 16; i++) {
+         int **table = *mptr_get(p);
+         int *value = mspace_alloc(m, sizeof(int));
+         *value = round * 100 + i;
+         table[i] = value;
+         mspace_write_barrier(m, &(table[i]), sizeof(int *));
+      }
+
+      generate_garbage(m, 2000, 3 * sizeof(int));
+
+      int **table = *mptr_get(p);
+      for (int i = 0; i < 16; i++)
+         ck_assert_int_eq(*table[i], round * 100 + i);
+   }
+
+   mptr_free(m, &p);
+   mspace_destroy(m);
+
+   opt_set_int(OPT_GC_GENERATIONAL, 0);
+}
+END_TEST
+
+START_TEST(test_parallel_mark)
+{
+   struct list {
+      struct list *next;
+      int value;
+   };
+
+   // Heaps this small are normally marked by a single thread
+   opt_set_int(OPT_GC_THREADS, 4);
+
+   mspace_t *m = mspace_new(0x100000);
+
+   // Many independent lists so the mark work is shared between threads
+   static const int NLISTS = 256, LENGTH = 20;
+
+   mptr_t p = mptr_new(m, "lists");
+   *mptr_get(p) = mspace_alloc(m, NLISTS * sizeof(struct list *));
+
+   for (int i = 0; i < NLISTS; i++) {
+      struct list *head = NULL;
+      for (int j = 0; j < LENGTH; j++) {
+         struct list *l = mspace_alloc(m, sizeof(struct list));
+         l->value = i * LENGTH + j;
+         l->next = head;
+         head = l;
+
+         generate_garbage(m, 5, (1 + rand() % 10) * sizeof(int));
+      }
+
+      struct list **lists = *mptr_get(p);
+      lists[i] = head;
+   }
+
+   // Do enough allocations to trigger several collections
+   for (int round = 0; round < 5; round++) {
+      generate_garbage(m, 20000, 4 * sizeof(int));
+
+      struct list **lists = *mptr_get(p);
+      for (int i = 0; i < NLISTS; i++) {
+         struct list *it = lists[i];
+         for (int j = LENGTH - 1; j >= 0; j--, it = it->next)
+            ck_assert_int_eq(it->value, i * LENGTH + j);
+         ck_assert_ptr_null(it);
+      }
+   }
+
+   mptr_free(m, &p);
+   mspace_destroy(m);
+
+   opt_set_int(OPT_GC_THREADS, 0);
+}
+END_TEST
+
 Suite *get_mspace_tests(void)
 {
    Suite *s = suite_create("mspace");
@@ -308,6 +440,9 @@ Suite *get_mspace_tests(void)
    tcase_add_test(tc, test_linked_list);
    tcase_add_test(tc, test_tlab);
    tcase_add_test(tc, test_end_ptr);
+   tcase_add_test(tc, test_small_cache);
+   tcase_add_test(tc, test_write_barrier);
+   tcase_add_test(tc, test_parallel_mark);
    suite_add_tcase(s, tc);
 
    return s;
@@ -20,6 +20,7 @@
 #include "jit/jit-priv.h"
 #include "jit/jit.h"
 #include "option.h"
+#include "rt/mspace.h"
 
 #include <inttypes.h>
 #include <math.h>
@@ -1387,6 +1388,79 @@ START_TEST(test_sub)
 }
 END_TEST
 
+static bool card_dirty(tlab_t *t, void *ptr)
+{
+   return t->cards[((char *)ptr - t->heap) >> MSPACE_CARD_SHIFT];
+}
+
+static void clear_card(tlab_t *t, void *ptr)
+{
+   t->cards[((char *)ptr - t->heap) >> MSPACE_CARD_SHIFT] = 0;
+}
+
+START_TEST(test_barrier)
+{
+   opt_set_int(OPT_GC_GENERATIONAL, 1);
+
+   jit_t *j = get_native_jit();
+   mspace_t *m = jit_get_mspace(j);
+
+   const char *text1 =
+      "    RECV      R0, #0          \n"
+      "    RECV      R1, #1          \n"
+      "    RECV      R2, #2          \n"
+      "    $GALLOC   R3, #4          \n"
+      "    STORE.32  R2, [R3]        \n"
+      "    SHL       R4, R1, #3      \n"
+      "    ADD       R5, R0, R4      \n"
+      "    STORE.64  R3, [R5]        \n"
+      "    $BARRIER  R5, #8          \n"
+      "    RET                       \n";
+
+   jit_handle_t h1 = assemble(j, text1, "barrier1", "pii");
+
+   // Sizes too large to mark inline call into the runtime
+   const char *text2 =
+      "    RECV      R0, #0          \n"
+      "    RECV      R1, #1          \n"
+      "    $BARRIER  R0, R1          \n"
+      "    RET                       \n";
+
+   jit_handle_t h2 = assemble(j, text2, "barrier2", "pi");
+
+   tlab_t *t = tlab_acquire(m);
+   ck_assert_ptr_nonnull(t->cards);
+
+   // Pointers outside the heap are ignored
+   int *stack[4] = {};
+   jit_call(j, h1, stack, 2, 42);
+   ck_assert_int_eq(*stack[2], 42);
+
+   mptr_t p = mptr_new(m, "table");
+   int **table = *mptr_get(p) = mspace_alloc(m, 100 * sizeof(int *));
+   memset(table, '\0', 100 * sizeof(int *));
+
+   for (int i = 0; i < 100; i += 7) {
+      clear_card(t, table + i);
+      jit_call(j, h1, table, i, i * 3);
+      ck_assert(card_dirty(t, table + i));
+      ck_assert_int_eq(*table[i], i * 3);
+   }
+
+   clear_card(t, table);
+   clear_card(t, table + 99);
+   jit_call(j, h2, table, 100 * sizeof(int *));
+   ck_assert(card_dirty(t, table));
+   ck_assert(card_dirty(t, table + 99));
+
+   tlab_release(t);
+   mptr_free(m, &p);
+   jit_free(j);
+
+   opt_set_int(OPT_GC_GENERATIONAL, 0);
+}
+END_TEST
+
 Suite *get_native_tests(void)
 {
    Suite *s = suite_create("native");
@@ -1416,6 +1490,7 @@ Suite *get_native_tests(void)
    tcase_add_test(tc, test_memset);
    tcase_add_test(tc, test_move);
    tcase_add_test(tc, test_sub);
+   tcase_add_test(tc, test_barrier);
    suite_add_tcase(s, tc);
 
    return s;